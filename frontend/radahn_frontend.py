@@ -17,6 +17,7 @@ from copy import deepcopy
 import json
 import io
 import zipfile
+import struct
 
 from ase.io import write, read
 from ase.atoms import Atoms
@@ -679,6 +680,40 @@ def launch_simulation(configTask:dict):
 
 
 
+# KVS published with the engine --packedkvs: a schema message then frames of values, same decoding as utils/listenRadahn.py
+class PackedKVSReader:
+    def __init__(self):
+        self.version = None
+        self.fields = []
+        self.dtypes = []
+
+    def decode(self, msg:dict):
+        kind = msg.get("kind")
+        if kind is None:
+            return msg
+        if kind == "schema":
+            self.version = msg["version"]
+            self.fields = msg["fields"]
+            # The values are packed as float64, the integers are restored from the type of their KVS leaf
+            self.dtypes = msg.get("sourceDtypes", msg["dtypes"])
+            return None
+        if kind != "values" or msg["version"] != self.version:
+            return None
+
+        # A single value is not written as an array in JSON
+        values = msg["values"] if isinstance(msg["values"], list) else [msg["values"]]
+        kvs = {}
+        for path, dtype, value in zip(self.fields, self.dtypes, values):
+            group, field = path.split("/", 1)
+            kvs.setdefault(group, {})[field] = value if dtype.startswith("float") else int(value)
+        # Leaves which are not numeric scalars, copied as they are
+        for group, fields in msg.get("others", {}).items():
+            if isinstance(fields, dict):
+                kvs.setdefault(group, {}).update(fields)
+            else:
+                kvs[group] = fields
+        return kvs
+
 def listen_to_zmq_socket(configTask:dict):
     propagateLog({"msg": "Start Listening for KVS messages.", "level": "info"})
     try:
@@ -695,12 +730,18 @@ def listen_to_zmq_socket(configTask:dict):
         if checkEvent:
             threadTable[configTask["threadName"]]["event"].set()
         previousIt = -1
+        kvsReader = PackedKVSReader()
         while (checkEvent and threadTable[configTask["threadName"]]["event"].is_set()) or (not checkEvent):
             socks = dict(poller.poll(500)) # ms
             if socket in socks and socks[socket] == zmq.POLLIN:
                 message = socket.recv()
                 messageStr = message.decode('utf-8')
-                msgDict = json.loads(messageStr)
+                rawDict = json.loads(messageStr)
+                msgDict = kvsReader.decode(rawDict)
+                if msgDict is None:
+                    continue
+                if msgDict is not rawDict:
+                    messageStr = json.dumps(msgDict)
                 if "global" not in msgDict.keys():
                     continue
                 if "simIt" not in msgDict["global"].keys():
@@ -717,6 +758,41 @@ def listen_to_zmq_socket(configTask:dict):
             threadTable[configTask["threadName"]]["thread"] = None
             threadTable[configTask["threadName"]]["event"].clear()
 
+# Binary frame of the atoms gate (engine --atomsformat float64/float32), same layout as utils/listenRadahn.py
+FRAME_MAGIC = b"RDHNFRME"
+FRAME_HEADER = struct.Struct("<8sHBBIQQ")
+FRAME_DTYPES = {0: np.dtype("<f8"), 1: np.dtype("<f4")}
+
+def extract_conduit_leaf(parts:list, name:str) -> memoryview:
+    # Conduit message: JSON schema of the node followed by its compact data, the leaf is located from its schema
+    if len(parts) < 2:
+        raise ValueError("The message is not a conduit message (schema and data).")
+    schema = json.loads(parts[0])
+    leaf = schema.get(name) if isinstance(schema, dict) else None
+    if not isinstance(leaf, dict) or leaf.get("dtype") != "uint8":
+        raise ValueError(f"The message has no uint8 field {name}.")
+    offset = int(leaf.get("offset", 0))
+    count = int(leaf["number_of_elements"])
+    if int(leaf.get("stride", 1)) != 1 or offset + count > len(parts[-1]):
+        raise ValueError(f"Invalid layout of the field {name} in the message.")
+    return memoryview(parts[-1])[offset:offset + count]
+
+def decode_atoms_message(parts:list) -> dict:
+    # JSON messages are forwarded as text, binary frames are checked and forwarded as is to be decoded by the page
+    if len(parts) == 1:
+        return {'message': parts[0].decode('utf-8')}
+
+    frame = extract_conduit_leaf(parts, "frame")
+    if len(frame) < FRAME_HEADER.size:
+        raise ValueError("The atoms message is not a Radahn frame.")
+    magic, version, kind, dtype, _, _, nbAtoms = FRAME_HEADER.unpack_from(frame, 0)
+    if magic != FRAME_MAGIC or version != 1 or kind != 1 or dtype not in FRAME_DTYPES:
+        raise ValueError(f"Unsupported atoms frame (version {version}, kind {kind}, dtype {dtype}).")
+    size = FRAME_HEADER.size + 3 * nbAtoms * FRAME_DTYPES[dtype].itemsize
+    if len(frame) < size:
+        raise ValueError(f"Truncated atoms frame of {nbAtoms} atoms.")
+    return {'frame': frame[:size].tobytes()}
+
 def listen_to_zmq_socketAtoms(configTask:dict):
     propagateLog({"msg": "Start Listening for Atom messages.", "level": "info"})
     try:
@@ -734,8 +810,8 @@ def listen_to_zmq_socketAtoms(configTask:dict):
             # we use an poller to be able to check the event periodically, allowing external action to stop this infinite loop
             socks = dict(poller.poll(500)) # ms
             if socket in socks and socks[socket] == zmq.POLLIN:
-                message = socket.recv()
-                socketio.emit('zmq_message_atoms', {'message': message.decode('utf-8')})
+                parts = socket.recv_multipart()
+                socketio.emit('zmq_message_atoms', decode_atoms_message(parts))
     finally:
         propagateLog({"msg": "End Listening for Atom messages.", "level": "info"})
         if "threadName" in configTask:
@@ -50,7 +50,8 @@ public:
             if(node.has_child(field))
             {
                 // Code adjusted from conduit_utils.cpp
-                conduit::Node curr = node[field];
+                // Read in place, the leaf is not copied and its name is not parsed as a path
+                const conduit::Node& curr = node.child(field);
                 switch(curr.dtype().id())
                 {
                     /* ints */
@@ -143,6 +144,15 @@ public:
         m_content<<"\n";
     }
 
+    // Rows written so far, used to checkpoint the writer
+    std::string getContent() const { return m_content.str(); }
+    void setContent(const std::string& content)
+    {
+        m_content.str("");
+        m_content.clear();
+        m_content<<content;
+    }
+
     void writeFile(const std::string& folder) const
     {
         std::string fileName = m_name + ".csv";
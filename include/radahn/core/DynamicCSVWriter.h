@@ -43,7 +43,7 @@ public:
             m_fields.insert(field);
 
             // Code adjusted from conduit_utils.cpp
-            conduit::Node curr = node[field];
+            const conduit::Node& curr = node.child(field);
 
             switch(curr.dtype().id())
             {
@@ -142,6 +142,39 @@ public:
         m_frames.insert({it, frame});
     }
 
+    // Frames stored so far, used to checkpoint the writer
+    void saveState(conduit::Node& node) const
+    {
+        for(auto & [it, frame] : m_frames)
+        {
+            auto & frameNode = node.append();
+            frameNode["it"] = it;
+            auto & fieldsNode = frameNode["fields"];
+            fieldsNode.set(conduit::DataType::object());
+            for(auto & [field, value] : frame)
+                fieldsNode.add_child(field) = value;
+        }
+    }
+
+    void loadState(const conduit::Node& node)
+    {
+        m_frames.clear();
+        m_fields.clear();
+        for(conduit::index_t i = 0; i < node.number_of_children(); ++i)
+        {
+            auto & frameNode = node.child(i);
+            auto & fieldsNode = frameNode["fields"];
+            dynamicCSVFrame frame;
+            for(conduit::index_t f = 0; f < fieldsNode.number_of_children(); ++f)
+            {
+                auto field = fieldsNode.child(f).name();
+                m_fields.insert(field);
+                frame.insert({field, fieldsNode.child(f).as_string()});
+            }
+            m_frames.insert({frameNode["it"].to_uint64(), frame});
+        }
+    }
+
     void writeFile(const std::string& folder) const
     {
         std::string fileName = m_name + ".csv";
@@ -2,9 +2,13 @@
 
 #include <vector>
 #include <set>
+#include <array>
+#include <span>
 
 #include <radahn/core/types.h>
 
+#include <conduit/conduit.hpp>
+
 namespace radahn {
 
 namespace core {
@@ -22,11 +26,24 @@ public:
 
     bool selectAtoms(radahn::core::simIt_t currentIt, const std::vector<atomIndexes_t>& indices, const std::vector<atomPositions_t>& positions);
 
+    // Reduction of the selection computed by the simulation: number of atoms found ("count"), geometric center ("center")
+    // and positions of a few tracked atoms ("trackedIDs", "trackedPositions"). The next call to selectAtoms() for the 
+    // same iteration keeps this state instead of looking up the atom positions.
+    void setReducedState(radahn::core::simIt_t currentIt, const conduit::Node& reduction);
+    // Request of the reduction of the selection, with the positions of the given atoms
+    void writeReductionRequest(conduit::Node& request, std::span<const atomIndexes_t> trackedIndices) const;
+
     const std::vector<radahn::core::atomIndexes_t>& getSelectionVector() const { return m_vecSelection; }
     const std::vector<radahn::core::atomPositions_t>& getCurrentSelectedPositions() const { return m_positions; }
     size_t getNbSelectedAtoms() const { return m_selection.size(); }
 
-    std::vector<radahn::core::atomPositions_t> computePositionCenter() const;
+    std::array<radahn::core::atomPositions_t, 3> computePositionCenter() const;
+    // Position of the i-th atom of the selection. With a reduced state, the atom must be one of the tracked atoms.
+    std::array<radahn::core::atomPositions_t, 3> getSelectedAtomPosition(size_t selectionIndex) const;
+
+    // Last positions selected, the selection itself is part of the settings
+    void saveState(conduit::Node& node) const;
+    void loadState(const conduit::Node& node);
 
 protected:
     std::set<radahn::core::atomIndexes_t> m_selection;
@@ -34,6 +51,12 @@ protected:
     radahn::core::simIt_t m_currentIt;
     std::vector<radahn::core::atomIndexes_t> m_indices;
     std::vector<radahn::core::atomPositions_t> m_positions;
+
+    bool m_reductionPending = false;        // Set by setReducedState(), consumed by selectAtoms()
+    bool m_reduced = false;                 // m_indices and m_positions only contain the tracked atoms
+    radahn::core::simIt_t m_reducedIt = 0;
+    uint64_t m_reducedCount = 0;
+    std::array<radahn::core::atomPositions_t, 3> m_reducedCenter = {0.0, 0.0, 0.0};
 };
 
 } // core
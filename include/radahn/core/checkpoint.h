@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+
+#include <radahn/core/types.h>
+
+namespace radahn {
+
+namespace core {
+
+// Checkpoints of a steering session are written in a folder shared by the simulation and the motor engine.
+// Each component writes its state for a step as <prefix>.<step>.ckpt (plus the companion files of the format used,
+// named <prefix>.<step>.ckpt.* and written before it).
+// A session can only be resumed from a step for which all the components completed their checkpoint.
+
+std::string getCheckpointPath(const std::string& folder, const std::string& prefix, simIt_t step);
+
+// Prefix of the simulation checkpoints. Each replica of an ensemble run writes its own.
+std::string getSimulationCheckpointPrefix(uint32_t replica, uint32_t nbReplicas);
+
+// Latest step for which a checkpoint of every prefix exists.
+std::optional<simIt_t> findLastCheckpoint(const std::string& folder, const std::vector<std::string>& prefixes);
+
+// Remove the checkpoints of the prefix except the `keep` most recent ones.
+void pruneCheckpoints(const std::string& folder, const std::string& prefix, size_t keep);
+
+} // core
+
+} // radahn
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <span>
+#include <string_view>
+#include <fstream>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace radahn {
+
+namespace core {
+
+// Append-only binary journal of the commands executed by the simulation, replayed by radahn-replay.
+//
+// File layout: the magic "RDHNJRNL", a uint32 version, then a sequence of records.
+// Each record starts with its type (1 byte), the integers are LEB128 varints:
+//  - STRING: id, size, bytes. Defines a string referenced by the other records by its id.
+//  - COMMAND: string id of the template, number of arguments, then for each argument its kind (1 byte) and
+//    either its size and bytes (INLINE) or a string id (INTERNED). The template is the command with each
+//    argument replaced by the byte 0x01.
+//  - SCRIPT: string id of the content of a script executed as a whole.
+//  - BLOB: string id of a tag, string id of a binary payload. Used for data given to Lammps without a command.
+//  - RESET: the previous string ids are not used anymore, the next STRING records start again from 0.
+// The fields of a command are the words separated by spaces. The numbers (step, run length, motor settings...) are
+// the arguments stored with each command, so the templates only contain the words and are shared by all the steps.
+// A run of integers (atom selection) is a single argument, interned since the same selections are used by many commands.
+// The string table is reset once it holds maxStrings entries to bound the memory used by long runs.
+enum class JournalRecord : uint8_t
+{
+    STRING = 1,
+    COMMAND = 2,
+    SCRIPT = 3,
+    BLOB = 4,
+    RESET = 5
+};
+
+enum class JournalArgument : uint8_t
+{
+    INLINE = 0,
+    INTERNED = 1
+};
+
+class CommandJournalWriter
+{
+public:
+    // The records are accumulated in memory and written by a background thread once bufferSize bytes are reached
+    // or when flush() is called. An empty path disables the journal.
+    CommandJournalWriter(const std::string& path, size_t bufferSize = 1 << 20, size_t maxStrings = 1 << 16);
+    ~CommandJournalWriter();
+
+    bool isOpen() const { return m_file.is_open(); }
+
+    void appendCommand(const std::string& cmd);
+    void appendScript(const std::string& content);
+    void appendBlob(const std::string& tag, std::span<const uint8_t> payload);
+
+    // Hand the pending records over to the writing thread, doesn't wait for the write to complete.
+    void flush();
+    // Write all the pending records and close the file.
+    void close();
+
+private:
+    uint64_t intern(const std::string& value);
+    void writeVarint(uint64_t value);
+    void writeBytes(std::string_view value);
+    void run();
+
+    std::ofstream m_file;
+    size_t m_bufferSize;
+    size_t m_maxStrings;
+    std::vector<uint8_t> m_buffer;
+    std::unordered_map<std::string, uint64_t> m_strings;
+    uint64_t m_nbResets = 0;
+
+    std::deque<std::vector<uint8_t>> m_pending;
+    bool m_stop = false;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+};
+
+struct JournalEntry
+{
+    JournalRecord type = JournalRecord::COMMAND;
+    std::string tag;            // BLOB only
+    std::string content;        // Command, script content or blob payload
+};
+
+class CommandJournalReader
+{
+public:
+    bool open(const std::string& path);
+
+    // Read the next command, script or blob. The string definitions are resolved internally.
+    // Returns false at the end of the journal or if the journal is corrupted.
+    bool next(JournalEntry& entry);
+
+private:
+    bool readVarint(uint64_t& value);
+    bool readBytes(std::string& value);
+    bool readString(uint64_t& id, std::string& value);
+    bool readCommand(std::string& command);
+    bool resolve(uint64_t id, std::string& value) const;
+
+    std::ifstream m_file;
+    std::vector<std::string> m_strings;
+};
+
+} // core
+
+} // radahn
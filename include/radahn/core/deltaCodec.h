@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <conduit/conduit.hpp>
+
+#include <radahn/core/types.h>
+
+namespace radahn {
+
+namespace core {
+
+// Lossless temporal compression of per-atom 3D fields (positions, velocities).
+// Each component is XORed with the value sent for the same atom in the previous frame. Small displacements
+// only change the low bytes of the representation, so only the significant bytes of the XOR are sent.
+// Works on the raw bits of float64, float32 or uint16 arrays, and can be combined with the position encodings.
+//
+// Message layout (under the node given to encode()):
+//  - "wordSize": size in bytes of one component (8, 4 or 2)
+//  - "keyframe": 1 if no atom uses a reference
+//  - "reference": uint8 per atom, 1 if the atom is XORed with its previous value
+//  - "sizes": number of significant bytes per component, 2 components per byte
+//  - "payload": significant bytes of each component, least significant byte first
+//
+// A rank only uses the reference of an atom if it sent this atom in its previous frame. Atoms which migrated from
+// another rank or were absent from the previous frame (region of interest) are sent without reference.
+
+class DeltaEncoder
+{
+public:
+    DeltaEncoder(){}
+    DeltaEncoder(uint32_t keyframeEvery) : m_keyframeEvery(keyframeEvery){}
+
+    // values must contain 3 components per atom.
+    void encode(const atomIndexes_t* ids, size_t nbAtoms, const conduit::Node& values, conduit::Node& dest);
+
+    uint32_t m_keyframeEvery = 20;
+
+private:
+    std::vector<uint64_t> m_reference;      // 3 components per atom ID
+    std::vector<uint64_t> m_lastFrame;      // Frame number + 1 in which each atom ID was last sent, 0 if never
+    uint64_t m_nbFrames = 0;
+
+    // Kept between two frames. The payload node is still resized when the compressed size changes.
+    std::vector<uint8_t> m_useReference;
+    std::vector<uint8_t> m_sizes;
+    std::vector<uint8_t> m_payload;
+};
+
+class DeltaDecoder
+{
+public:
+    // Rebuild the values (float64, float32 or uint16 depending on the word size) from a node produced by DeltaEncoder.
+    // The values are written in place when the node already holds an array of the same type and size.
+    bool decode(const atomIndexes_t* ids, size_t nbAtoms, const conduit::Node& src, conduit::Node& values);
+
+private:
+    std::vector<uint64_t> m_reference;      // 3 components per atom ID
+    std::vector<uint8_t> m_known;           // 1 if the atom ID has been received at least once
+    std::vector<uint64_t> m_words;          // Decoded components of the current frame
+};
+
+} // core
+
+} // radahn
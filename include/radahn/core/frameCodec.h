@@ -0,0 +1,42 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include <radahn/core/types.h>
+#include <radahn/core/positionCodec.h>
+
+namespace radahn {
+
+namespace core {
+
+// Binary frame published by the engine on the atoms gate, decoded by utils/listenRadahn.py.
+//
+// Little-endian layout, 32 bytes header followed by the data:
+//  - magic "RDHNFRME" (8 bytes)
+//  - uint16 schema version
+//  - uint8 frame kind (FrameKind)
+//  - uint8 dtype of the values, PositionEncoding::FLOAT64 or PositionEncoding::FLOAT32
+//  - uint32 reserved, 0
+//  - uint64 simIt
+//  - uint64 number of atoms
+//  - 3 * number of atoms values (x, y, z of each atom in ID order)
+enum class FrameKind : uint8_t
+{
+    POSITIONS = 1
+};
+
+constexpr uint16_t frameSchemaVersion = 1;
+constexpr size_t frameHeaderSize = 32;
+
+// Encode the positions (3 values per atom) in out, replacing its content.
+// Only FLOAT64 and FLOAT32 are supported, FIXED16 requires the box and is kept for the simulation messages.
+bool encodePositionsFrame(simIt_t it, const std::vector<atomPositions_t>& positions, PositionEncoding dtype, std::vector<uint8_t>& out);
+
+// Decode a frame written by encodePositionsFrame. The positions are converted to double.
+bool decodePositionsFrame(std::span<const uint8_t> frame, simIt_t& it, std::vector<atomPositions_t>& outPositions);
+
+} // core
+
+} // radahn
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <radahn/core/types.h>
+
+namespace radahn {
+
+namespace core {
+
+// Compute the position of each atom in the frame ordered by ID. Return true if the IDs are exactly 1..nbAtoms
+// (dense frame), the position of each atom is then its ID - 1 and the frame can be used as indexed by ID.
+// Otherwise (region of interest, deleted atoms), the atoms are sorted by ID in a compact frame.
+bool computeSortedOrder(const atomIndexes_t* ids, size_t nbAtoms, std::vector<size_t>& order);
+
+} // core
+
+} // radahn
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <chrono>
+
+#include <conduit/conduit.hpp>
+
+namespace radahn {
+
+namespace core {
+
+// Wall clock time spent in the phases of a steering iteration.
+// A phase can be started and stopped several times, the durations are accumulated until clear().
+class PhaseTimers
+{
+public:
+    void start(const std::string& phase);
+    void stop(const std::string& phase);
+
+    // Accumulated time (s) of the phase, 0 if it was not measured
+    double get(const std::string& phase) const;
+
+    // Add the durations to the node as <prefix><phase> (s)
+    void exportTo(conduit::Node& node, const std::string& prefix) const;
+    // Reset the durations to 0, the phases currently running keep running.
+    // The phases measured before are still exported, with 0 if they didn't run since.
+    void clear();
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    std::map<std::string, double> m_durations;
+    std::map<std::string, clock::time_point> m_started;
+    mutable std::string m_key;
+};
+
+} // core
+
+} // radahn
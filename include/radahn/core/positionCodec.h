@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include <conduit/conduit.hpp>
+
+#include <radahn/core/types.h>
+
+namespace radahn {
+
+namespace core {
+
+// Encoding of the atom positions sent from the simulation to the engine.
+// FLOAT64: raw positions, no metadata.
+// FLOAT32: positions cast to float, ~7 significant digits.
+// FIXED16: positions stored as uint16 relative to the simulation box, x = offset + value * scale for each axis.
+enum class PositionEncoding : uint8_t
+{
+    FLOAT64 = 0,
+    FLOAT32 = 1,
+    FIXED16 = 2
+};
+
+constexpr const char* to_string(PositionEncoding e)// throw()
+{
+    switch (e)
+    {
+    case PositionEncoding::FLOAT64:
+        return "float64";
+    case PositionEncoding::FLOAT32:
+        return "float32";
+    case PositionEncoding::FIXED16:
+        return "fixed16";
+    default:
+        throw std::invalid_argument("Unknown PositionEncoding given to to_string(PositionEncoding).");
+    }
+}
+
+constexpr PositionEncoding positionEncodingFromString(const std::string_view& str)// throw()
+{
+    if (str == "float64")
+        return PositionEncoding::FLOAT64;
+    if (str == "float32")
+        return PositionEncoding::FLOAT32;
+    if (str == "fixed16")
+        return PositionEncoding::FIXED16;
+
+    throw std::invalid_argument("Unknown string given to positionEncodingFromString(const std::string&): " + std::string(str));
+}
+
+// Write the 3*nbAtoms positions in simData["atomPositions"] with the requested encoding.
+// The encoding and, if needed, the per-axis scale and offset are written in simData as well.
+// boxLo and boxHi are only used by FIXED16. Positions outside of the box are clamped to the box bounds.
+// Return the number of clamped coordinates.
+uint64_t encodePositions(
+    PositionEncoding encoding,
+    const atomPositions_t* positions,
+    uint64_t nbAtoms,
+    const double boxLo[3],
+    const double boxHi[3],
+    conduit::Node& simData);
+
+// Decode simData["atomPositions"] and append the result to outPositions.
+// Messages without "positionEncoding" are considered FLOAT64.
+bool decodePositions(const conduit::Node& simData, std::vector<atomPositions_t>& outPositions);
+
+// Decode simData["atomPositions"] and write the position of the atom ids[i] at outPositions[3*(ids[i]-1)].
+// outPositions must be sized for the largest ID. Return false if the positions don't match the nbAtoms IDs.
+bool scatterPositions(const conduit::Node& simData, const atomIndexes_t* ids, uint64_t nbAtoms, atomPositions_t* outPositions);
+
+} // core
+
+} // radahn
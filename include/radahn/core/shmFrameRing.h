@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <conduit/conduit.hpp>
+
+namespace radahn {
+
+namespace core {
+
+// Ring of frames in a POSIX shared memory segment, written by one simulation rank and read by the engine
+// running on the same node. Only the schema of a frame and its sequence number go through the regular transport,
+// the engine reads the values in place.
+//
+// The segment starts with a header (ShmRingHeader) followed by nbSlots slots of slotSize bytes.
+// The frame of the sequence number s is stored in the slot s % nbSlots with the compact layout of its schema.
+// The writer waits while all the slots hold frames not yet released by the reader, and gives up if the
+// reader process exits or doesn't release a slot within writeTimeout.
+class ShmFrameRing
+{
+public:
+    enum class WriteStatus
+    {
+        WRITTEN,
+        TOO_LARGE,      // The node doesn't fit in a slot, nothing was written
+        READER_GONE     // The reader exited or stopped releasing the slots
+    };
+
+    static constexpr std::chrono::seconds writeTimeout{60};
+
+    ~ShmFrameRing();
+
+    // Create the segment, the creator removes it on destruction. Return nullptr on failure.
+    // The segments still existing when the process exits (exit() on an error) are removed as well.
+    static std::unique_ptr<ShmFrameRing> create(const std::string& name, uint32_t nbSlots, uint64_t slotSize);
+    // Map an existing segment as its reader. Return nullptr if it doesn't exist on this node.
+    static std::unique_ptr<ShmFrameRing> open(const std::string& name);
+
+    const std::string& getName() const { return m_name; }
+    uint64_t getSlotSize() const;
+
+    // Remove the name of the segment once the reader mapped it, the mappings stay valid.
+    // Nothing is left behind if one of the processes is killed afterwards.
+    void unlink();
+
+    // Copy the node in the next slot and return its sequence number and compact schema.
+    WriteStatus write(const conduit::Node& node, uint64_t& seq, std::string& schema);
+
+    // Point the node to the frame of the sequence number, without copy. The frame stays valid until it is released.
+    bool view(uint64_t seq, const std::string& schema, conduit::Node& out);
+    // Give the slots of the frames up to seq (included) back to the writer
+    void release(uint64_t seq);
+
+private:
+    struct ShmRingHeader
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t nbSlots;
+        uint64_t slotSize;
+        std::atomic<uint64_t> writeSeq;     // Next sequence number to write
+        std::atomic<uint64_t> readSeq;      // First sequence number not released by the reader
+        std::atomic<int64_t> readerPid;     // Process of the reader, 0 until the segment is opened
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The ring requires lock free atomics to be shared between processes.");
+
+    ShmFrameRing(const std::string& name, void* segment, size_t segmentSize, bool owner);
+    uint8_t* getSlot(uint64_t seq);
+    bool isReaderAlive() const;
+
+    std::string m_name;
+    void* m_segment = nullptr;
+    size_t m_segmentSize = 0;
+    bool m_owner = false;
+    ShmRingHeader* m_header = nullptr;
+};
+
+} // core
+
+} // radahn
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+
+namespace radahn {
+
+namespace core {
+
+// Threads kept for the whole run to share a loop between them, instead of starting new threads at every frame.
+// run() calls the task on the calling thread and on nbWorkers - 1 threads of the pool, and returns once they all returned.
+// The task must split the work itself (shared counter for instance). A run doesn't allocate.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(size_t nbThreads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Number of threads available to run(), the calling thread included
+    size_t getNbWorkers() const { return m_threads.size() + 1; }
+
+    template<typename F>
+    void run(size_t nbWorkers, F& task)
+    {
+        runTask(nbWorkers, &task, [](void* t) { (*static_cast<F*>(t))(); });
+    }
+
+private:
+    void runTask(size_t nbWorkers, void* task, void (*call)(void*));
+    void workerLoop(size_t index);
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;      // Incremented at every run
+    size_t m_nbActive = 0;          // Threads of the pool taking part in the current run
+    size_t m_nbRunning = 0;         // Threads of the pool still running the current task
+    void* m_task = nullptr;
+    void (*m_call)(void*) = nullptr;
+    bool m_stop = false;
+};
+
+} // core
+
+} // radahn
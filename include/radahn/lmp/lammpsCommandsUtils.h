@@ -3,6 +3,9 @@
 #include <cstdint>
 #include <span>
 #include <memory>
+#include <map>
+#include <array>
+#include <ostream>
 
 #include <radahn/core/units.h>
 #include <radahn/core/types.h>
@@ -30,8 +33,14 @@ public:
     virtual bool loadFromConduit(conduit::Node& node) = 0;
     virtual bool writeDoCommands(std::vector<std::string>& cmds) const = 0;
     virtual bool writeUndoCommands(std::vector<std::string>& cmds) const = 0;
+    // Only the fix part of the do/undo commands, used to update the parameters of a motor without touching its group
+    virtual bool writeFixCommands(std::vector<std::string>& cmds) const { (void)cmds; return true; }
+    virtual bool writeUnfixCommands(std::vector<std::string>& cmds) const { (void)cmds; return true; }
     virtual std::string getGroupName() const { return std::string(""); }
+    virtual std::span<const radahn::core::atomIndexes_t> getSelection() const { return {}; }
     virtual bool needMotionIntegration() const { return true; }
+
+    std::string m_origin;
 };
 
 class MoveLammpsCommand : public LammpsCommand
@@ -40,14 +49,19 @@ public:
     radahn::core::VelocityQuantity m_vx;
     radahn::core::VelocityQuantity m_vy;
     radahn::core::VelocityQuantity m_vz;
-    std::string m_origin;
     std::vector<radahn::core::atomIndexes_t> m_selection;
+    // Optional completion criteria on the displacement of the selection center, only used by the fix radahn
+    std::array<bool, 3> m_check = {false, false, false};
+    std::array<radahn::core::atomPositions_t, 3> m_distance = {0.0, 0.0, 0.0};
 
     MoveLammpsCommand() : LammpsCommand(){}
     virtual bool loadFromConduit(conduit::Node& node) override;
     virtual bool writeDoCommands(std::vector<std::string>& cmds) const override;
     virtual bool writeUndoCommands(std::vector<std::string>& cmds) const override;
+    virtual bool writeFixCommands(std::vector<std::string>& cmds) const override;
+    virtual bool writeUnfixCommands(std::vector<std::string>& cmds) const override;
     virtual std::string getGroupName() const override;
+    virtual std::span<const radahn::core::atomIndexes_t> getSelection() const override { return m_selection; }
     virtual bool needMotionIntegration() const override { return false; }
 
 };
@@ -61,7 +75,6 @@ public:
     radahn::core::atomPositions_t m_ax;       // Axe vector
     radahn::core::atomPositions_t m_ay;
     radahn::core::atomPositions_t m_az;
-    std::string m_origin;
     radahn::core::TimeQuantity m_period;      // Period of the rotation
     std::vector<radahn::core::atomIndexes_t> m_selection;
     
@@ -69,7 +82,10 @@ public:
     virtual bool loadFromConduit(conduit::Node& node) override;
     virtual bool writeDoCommands(std::vector<std::string>& cmds) const override;
     virtual bool writeUndoCommands(std::vector<std::string>& cmds) const override;
+    virtual bool writeFixCommands(std::vector<std::string>& cmds) const override;
+    virtual bool writeUnfixCommands(std::vector<std::string>& cmds) const override;
     virtual std::string getGroupName() const override;
+    virtual std::span<const radahn::core::atomIndexes_t> getSelection() const override { return m_selection; }
     virtual bool needMotionIntegration() const override { return false; }
 };
 
@@ -79,14 +95,19 @@ public:
     radahn::core::ForceQuantity m_fx;
     radahn::core::ForceQuantity m_fy;
     radahn::core::ForceQuantity m_fz;
-    std::string m_origin;
     std::vector<radahn::core::atomIndexes_t> m_selection;
+    // Optional completion criteria on the displacement of the selection center, only used by the fix radahn
+    std::array<bool, 3> m_check = {false, false, false};
+    std::array<radahn::core::atomPositions_t, 3> m_distance = {0.0, 0.0, 0.0};
 
     AddForceLammpsCommand() : LammpsCommand(){}
     virtual bool loadFromConduit(conduit::Node& node) override;
     virtual bool writeDoCommands(std::vector<std::string>& cmds) const override;
     virtual bool writeUndoCommands(std::vector<std::string>& cmds) const override;
+    virtual bool writeFixCommands(std::vector<std::string>& cmds) const override;
+    virtual bool writeUnfixCommands(std::vector<std::string>& cmds) const override;
     virtual std::string getGroupName() const override;
+    virtual std::span<const radahn::core::atomIndexes_t> getSelection() const override { return m_selection; }
 };
 
 class AddTorqueLammpsCommand : public LammpsCommand
@@ -95,21 +116,21 @@ public:
     radahn::core::TorqueQuantity m_tx;
     radahn::core::TorqueQuantity m_ty;
     radahn::core::TorqueQuantity m_tz;
-    std::string m_origin;
     std::vector<radahn::core::atomIndexes_t> m_selection;
 
     AddTorqueLammpsCommand() : LammpsCommand(){}
     virtual bool loadFromConduit(conduit::Node& node) override;
     virtual bool writeDoCommands(std::vector<std::string>& cmds) const override;
     virtual bool writeUndoCommands(std::vector<std::string>& cmds) const override;
+    virtual bool writeFixCommands(std::vector<std::string>& cmds) const override;
+    virtual bool writeUnfixCommands(std::vector<std::string>& cmds) const override;
     virtual std::string getGroupName() const override;
+    virtual std::span<const radahn::core::atomIndexes_t> getSelection() const override { return m_selection; }
 };
 
 class WaitLammpsCommand : public LammpsCommand
 {
 public:
-    std::string m_origin;
-
     WaitLammpsCommand() : LammpsCommand(){}
     virtual bool loadFromConduit(conduit::Node& node) override;
     virtual bool writeDoCommands(std::vector<std::string>& cmds) const override;
@@ -130,6 +151,19 @@ public:
     bool loadCommandsFromConduit(conduit::Node& cmds);
     bool writeDoCommands(std::vector<std::string>& cmds) const;
     bool writeUndoCommands(std::vector<std::string>& cmds) const;
+
+    // Stateful alternative to writeDoCommands/writeUndoCommands.
+    // Compare the commands loaded since the last call with the ones currently applied in Lammps and only write
+    // the commands needed to go from one to the other: new motors, stopped motors, re-fix of the motors whose parameters changed.
+    // The integration groups and the NVE fix are only recreated when the non integrated atoms change.
+    // The loaded commands are consumed, a call without any loaded command stops all the motors.
+    bool writeUpdateCommands(std::vector<std::string>& cmds);
+    // Remove everything applied by writeUpdateCommands.
+    bool writeClearCommands(std::vector<std::string>& cmds);
+
+    // Access to the loaded commands when they are applied without going through Lammps commands (fix radahn)
+    const std::vector<std::shared_ptr<LammpsCommand>>& getCommands() const { return m_cmds; }
+    void clearCommands() { m_cmds.clear(); }
     
 
     static void registerMoveCommandToConduit(
@@ -165,6 +199,24 @@ public:
         radahn::core::TimeQuantity period,     
         const std::vector<radahn::core::atomIndexes_t>& selection);
     static void registerWaitCommandToConduit(conduit::Node& node, const std::string& name);
+    // Add a completion criteria to a move or add force command already registered in the node
+    static void registerCompletionToConduit(
+        conduit::Node& node,
+        bool checkX,
+        bool checkY,
+        bool checkZ,
+        radahn::core::DistanceQuantity dx,
+        radahn::core::DistanceQuantity dy,
+        radahn::core::DistanceQuantity dz);
+    // Node of the index-th command of a list rewritten in place at every frame. A node written by another origin
+    // is cleared first so that no field of a different command type remains.
+    static conduit::Node& reuseCommandNode(conduit::Node& cmds, conduit::index_t index, const std::string& origin);
+    // Remove the commands following the first count ones of a list rewritten in place
+    static void trimCommands(conduit::Node& cmds, conduit::index_t count);
+
+    // Write the IDs for the "group ID id ..." command, using the Lammps ranges A:B and A:B:C when possible
+    // so that the command length doesn't scale with the size of contiguous selections.
+    static void writeIdSelection(std::ostream& out, std::span<const radahn::core::atomIndexes_t> selection);
 
 protected:
     std::vector<std::shared_ptr<LammpsCommand>> m_cmds;
@@ -172,6 +224,14 @@ protected:
     std::string m_nonIntegrateGroupName = "nonintegrateGRP";
     bool m_hasPermanentAnchor = false;
     std::string m_permanentAnchorName;
+
+    // State applied in Lammps by writeUpdateCommands
+    std::string m_integrationFixName = "NVE";
+    std::map<std::string, std::shared_ptr<LammpsCommand>> m_appliedCmds;
+    std::map<std::string, std::vector<radahn::core::atomIndexes_t>> m_appliedNonIntegrated;
+    bool m_integrationApplied = false;
+
+    void writeIntegrationCommands(const std::vector<std::string>& nonIntegrationGroup, std::vector<std::string>& cmds) const;
 };
 
 } // core
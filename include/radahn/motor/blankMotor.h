@@ -29,10 +29,14 @@ public:
         conduit::Node& kvs) override;
         
     virtual bool appendCommandToConduitNode(conduit::Node& node) override;
+    virtual radahn::core::simIt_t getEstimatedStepsToCompletion() const override;
     virtual bool loadFromJSON(const nlohmann::json& node, uint32_t version, radahn::core::SimUnits units) override;
 
     virtual void convertSettingsTo(radahn::core::SimUnits destUnits) override;
 
+    virtual void saveState(conduit::Node& node) const override;
+    virtual bool loadState(const conduit::Node& node) override;
+
 protected:
     virtual void declareCSVWriterFieldNames() override;
 
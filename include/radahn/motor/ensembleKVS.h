@@ -0,0 +1,38 @@
+#pragma once
+
+#include <radahn/core/types.h>
+#include <radahn/core/DynamicCSVWriter.h>
+
+#include <conduit/conduit.hpp>
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace radahn {
+
+namespace motor {
+
+// Statistics over the KVS of the replicas of an ensemble run.
+// The groups (motors and global) keep their names, each scalar numeric field <f> of a group
+// becomes <f>_mean, <f>_std, <f>_min and <f>_max. A replica without the field (motor not started yet)
+// is not counted, the number of replicas used is given by <f>_n.
+class EnsembleKVS
+{
+public:
+    void aggregate(radahn::core::simIt_t it, const std::vector<const conduit::Node*>& replicaKVS);
+
+    const conduit::Node& getCurrentKVS() const { return m_currentKVS; }
+    conduit::Node& getCurrentKVS() { return m_currentKVS; }
+
+    // One file ensemble_<group>.csv per group
+    void saveToCSV(const std::string& folder = ".") const;
+
+protected:
+    conduit::Node m_currentKVS;
+    std::map<std::string, radahn::core::DynamicCSVWriter> m_groupCSV;
+};
+
+} // motor
+
+} // radahn
@@ -1,7 +1,6 @@
 #pragma once 
 
-#include <radahn/motor/motor.h>
-#include <radahn/core/atomSet.h>
+#include <radahn/motor/selectionMotor.h>
 #include <radahn/core/units.h>
 #include <radahn/lmp/lammpsCommandsUtils.h>
 
@@ -10,10 +9,10 @@ namespace radahn {
 namespace motor {
 
 
-class ForceMotor : public Motor
+class ForceMotor : public SelectionMotor
 {
 public:
-    ForceMotor() : Motor()
+    ForceMotor() : SelectionMotor()
     {
         declareCSVWriterFieldNames();
     }
@@ -26,8 +25,7 @@ public:
         radahn::core::DistanceQuantity dy = radahn::core::DistanceQuantity(0.0, radahn::core::SimUnits::LAMMPS_REAL), 
         radahn::core::DistanceQuantity dz = radahn::core::DistanceQuantity(0.0, radahn::core::SimUnits::LAMMPS_REAL)
         ) : 
-        Motor(name),
-        m_currentState(selection), 
+        SelectionMotor(name, selection),
         m_fx(fx), m_fy(fy), m_fz(fz),
         m_checkX(checkX), m_checkY(checkY), m_checkZ(checkZ),
         m_dx(dx), m_dy(dy), m_dz(dz)
@@ -47,11 +45,13 @@ public:
 
     virtual void convertSettingsTo(radahn::core::SimUnits destUnits) override;
 
+    virtual void saveState(conduit::Node& node) const override;
+    virtual bool loadState(const conduit::Node& node) override;
+
 protected:
     virtual void declareCSVWriterFieldNames() override;
 
     // Settings variables
-    radahn::core::AtomSet m_currentState;
     radahn::core::ForceQuantity m_fx;
     radahn::core::ForceQuantity m_fy;
     radahn::core::ForceQuantity m_fz;
@@ -63,11 +63,9 @@ protected:
     radahn::core::DistanceQuantity m_dz;
 
     // Internal computation variables
-    bool m_initialStateRegistered   = false;
     radahn::core::DistanceQuantity m_initialCx;          // initial center
     radahn::core::DistanceQuantity m_initialCy;
     radahn::core::DistanceQuantity m_initialCz;
-    radahn::core::AtomSet m_initialState;
 };
 
 } // core
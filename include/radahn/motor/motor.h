@@ -1,6 +1,8 @@
 #pragma once 
 
 #include <string>
+#include <set>
+#include <vector>
 #include <conduit/conduit.hpp>
 #include <nlohmann/json.hpp>
 
@@ -42,8 +44,18 @@ public:
         const std::vector<radahn::core::atomPositions_t>& positions,
         conduit::Node& kvs) = 0;
     virtual bool appendCommandToConduitNode(conduit::Node& node) = 0;
+    // Append the atoms the motor needs to update its state, the caller removes the duplicates. Motors without selection don't add anything.
+    virtual void collectSelection(std::vector<radahn::core::atomIndexes_t>& selection) const { (void)selection; }
+    // Add the reduction the simulation must compute for the motor to update its state without the atom positions
+    // (see AtomSet::writeReductionRequest), and apply its result. Motors without selection don't need any.
+    virtual void collectReductions(conduit::Node& requests) const { (void)requests; }
+    virtual void applyReduction(radahn::core::simIt_t it, const conduit::Node& reduction) { (void)it; (void)reduction; }
     void addDependency(std::shared_ptr<Motor> dependency);
 
+    // Estimated number of steps before the motor reaches its target, based on the progress rate measured
+    // between its last two updates. Returns 0 if no estimate is available (not enough updates, no progress).
+    virtual radahn::core::simIt_t getEstimatedStepsToCompletion() const;
+
     bool canStart() const ;
     bool startMotor();
 
@@ -51,16 +63,29 @@ public:
 
     virtual void convertSettingsTo(radahn::core::SimUnits destUnits) = 0;
 
+    // Runtime state of the motor (status, tracking variables, CSV rows) for the checkpoints.
+    // The settings are loaded from the motor configuration and are not part of the state.
+    virtual void saveState(conduit::Node& node) const;
+    virtual bool loadState(const conduit::Node& node);
+
     void writeCSVFile(const std::string& folder) const;
 
 protected:
     virtual void declareCSVWriterFieldNames() = 0;
 
+    // Record the progress (%) reached at the iteration it and update the progress rate.
+    void registerProgress(radahn::core::simIt_t it, double progress);
+
     std::string m_name;
     MotorStatus m_status = MotorStatus::MOTOR_WAIT;
     std::vector<std::shared_ptr<Motor>> m_dependencies;
     radahn::core::CSVWriter m_motorWriter;
 
+    bool m_progressRegistered = false;
+    radahn::core::simIt_t m_lastProgressIt = 0;
+    double m_lastProgress = 0.0;
+    double m_progressRate = 0.0;        // Progress (%) per step
+
 };
 
 } // core
@@ -3,6 +3,7 @@
 #include <radahn/motor/motor.h>
 #include <radahn/core/types.h>
 #include <radahn/core/DynamicCSVWriter.h>
+#include <radahn/core/workerPool.h>
 
 #include <conduit/conduit.hpp>
 
@@ -27,14 +28,21 @@ public:
     void loadTestMotorSetup();
 
     void setCurrentSimulationIt(radahn::core::simIt_t it);
-    void updateEngineState(radahn::core::simIt_t it,
-        std::vector<radahn::core::atomIndexes_t>& indices, 
-        std::vector<radahn::core::atomPositions_t>& positions);
-    bool updateMotorsState(radahn::core::simIt_t it,
-        std::vector<radahn::core::atomIndexes_t>& indices, 
-        std::vector<radahn::core::atomPositions_t>& positions);
+    // Chunks are the "simdata" nodes received from the simulation processes. Their positions are decoded
+    // directly at their ID in the engine arrays, the chunks being processed in parallel for large frames.
+    // Return false if a chunk has an invalid atom ID or if its positions could not be decoded.
+    bool updateEngineState(radahn::core::simIt_t it, const std::vector<const conduit::Node*>& chunks);
+    // Update the motors with the frame given to updateEngineState() for the same iteration
+    bool updateMotors(radahn::core::simIt_t it);
 
     bool getCommandsFromMotors(conduit::Node& node) const;
+    void getActiveSelection(std::vector<radahn::core::atomIndexes_t>& selection) const;
+    // Reductions to compute in the simulation for the next frame, one child per motor, and their results.
+    // The results must be applied before updateMotors() for the same iteration.
+    void getReductionRequests(conduit::Node& requests) const;
+    void applyReductions(radahn::core::simIt_t it, const conduit::Node& reductions);
+    // Number of steps before the first running motor is expected to reach its target, 0 if no motor can estimate it.
+    radahn::core::simIt_t getSuggestedInterval() const;
     bool updateMotorLists();
 
     bool isCompleted() const;
@@ -50,11 +58,18 @@ public:
 
     void convertMotorsTo(radahn::core::SimUnits destUnits);
 
+    // Checkpoint of the motors and of the KVS history. The motors must be loaded and converted to the simulation units first.
+    void saveState(conduit::Node& node) const;
+    bool loadState(const conduit::Node& node);
+
     void addGlobalKVS(conduit::Node& globals);
     void commitKVSFrame();
-    void saveKVSToCSV();
+    void saveKVSToCSV(const std::string& folder = ".");
 
 protected:
+    // Prepare the KVS tree for a new frame
+    void resetKVS();
+
     //std::vector<std::shared_ptr<radahn::motor::Motor>> m_motors;
     std::unordered_map<std::string, std::shared_ptr<radahn::motor::Motor>> m_motorsMap;
     std::list<std::shared_ptr<radahn::motor::Motor>> m_pendingMotors;
@@ -63,6 +78,7 @@ protected:
     radahn::core::simIt_t m_currentIt;
     std::vector<radahn::core::atomIndexes_t> m_currentIndexes;
     std::vector<radahn::core::atomPositions_t> m_currentPositions;
+    std::unique_ptr<radahn::core::WorkerPool> m_scatterPool;    // Created with the first frame large enough to be split
 
     conduit::Node m_currentKVS;  // Data which can be used for plotting
     radahn::core::DynamicCSVWriter m_globalCSV;
@@ -2,8 +2,7 @@
 
 #include <spdlog/spdlog.h>
 
-#include <radahn/motor/motor.h>
-#include <radahn/core/atomSet.h>
+#include <radahn/motor/selectionMotor.h>
 #include <radahn/core/units.h>
 #include <radahn/lmp/lammpsCommandsUtils.h>
 
@@ -12,10 +11,10 @@ namespace radahn {
 namespace motor {
 
 
-class MoveMotor : public Motor
+class MoveMotor : public SelectionMotor
 {
 public:
-    MoveMotor() : Motor()
+    MoveMotor() : SelectionMotor()
     {
         declareCSVWriterFieldNames();
     }
@@ -28,8 +27,7 @@ public:
         radahn::core::DistanceQuantity dy = radahn::core::DistanceQuantity(0.0, radahn::core::SimUnits::LAMMPS_REAL), 
         radahn::core::DistanceQuantity dz = radahn::core::DistanceQuantity(0.0, radahn::core::SimUnits::LAMMPS_REAL)
         ) : 
-        Motor(name),
-        m_currentState(selection), 
+        SelectionMotor(name, selection),
         m_vx(vx), m_vy(vy), m_vz(vz),
         m_checkX(checkX), m_checkY(checkY), m_checkZ(checkZ),
         m_dx(dx), m_dy(dy), m_dz(dz)
@@ -49,11 +47,13 @@ public:
 
     virtual void convertSettingsTo(radahn::core::SimUnits destUnits) override;
 
+    virtual void saveState(conduit::Node& node) const override;
+    virtual bool loadState(const conduit::Node& node) override;
+
 protected:
     virtual void declareCSVWriterFieldNames() override;
 
     // Settings variables
-    radahn::core::AtomSet m_currentState;
     radahn::core::VelocityQuantity m_vx;
     radahn::core::VelocityQuantity m_vy;
     radahn::core::VelocityQuantity m_vz;
@@ -65,12 +65,10 @@ protected:
     radahn::core::DistanceQuantity m_dz;
 
     // Internal computation variables
-    bool m_initialStateRegistered   = false;
     radahn::core::DistanceQuantity m_initialCx;          // initial center
     radahn::core::DistanceQuantity m_initialCy;
     radahn::core::DistanceQuantity m_initialCz;
     radahn::core::DistanceQuantity m_initialDistance;
-    radahn::core::AtomSet m_initialState;
 };
 
 } // core
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <radahn/core/types.h>
+
+#include <conduit/conduit.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace radahn {
+
+namespace motor {
+
+// KVS published as a schema message followed by value frames, decoded by utils/listenRadahn.py and the frontend.
+// The KVS tree (group/field) is flattened into the list of its scalar numeric leaves:
+//  - schema: {"kind": "schema", "version": v, "fields": ["group/field", ...], "dtypes": ["float64", ...], "sourceDtypes": ["uint64", ...]}
+//  - values: {"kind": "values", "version": v, "simIt": it, "values": [float64, ...], "others": {group: {field: ...}}}
+// The values are in the order of the fields. They are all packed as float64, as declared by "dtypes". "sourceDtypes" gives
+// the type of each leaf in the KVS so that a reader can restore the integers (exact up to 2^53).
+// The other leaves (strings, arrays, nested nodes) are copied as they are in "others", which is only present if the KVS has some.
+// The version changes every time the list of fields changes (motor started or stopped, new phase). It starts from a
+// random value so that a reader doesn't take the schema of a restarted engine for the one it already has.
+class PackedKVSWriter
+{
+public:
+    PackedKVSWriter();
+
+    // Flatten the KVS. Return true if its fields differ from the previous call, the schema must be sent again.
+    bool update(const conduit::Node& kvs);
+
+    void writeSchema(conduit::Node& msg) const;
+    // The KVS must be the one given to the last update()
+    void writeValues(radahn::core::simIt_t it, const conduit::Node& kvs, conduit::Node& msg) const;
+
+    uint32_t getVersion() const { return m_version; }
+
+protected:
+    // Hash of the names and types of the leaves, computed without allocation
+    static uint64_t computeSignature(const conduit::Node& kvs, uint64_t& nbFields);
+    void buildSchema(const conduit::Node& kvs);
+
+    uint64_t m_signature = 0;
+    uint32_t m_version = 0;
+    bool m_hasSchema = false;
+    std::vector<std::string> m_fields;
+    std::vector<std::string> m_sourceDtypes;
+    std::vector<double> m_values;
+};
+
+} // motor
+
+} // radahn
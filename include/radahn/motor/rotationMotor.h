@@ -0,0 +1,46 @@
+#pragma once 
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <glm/gtx/vector_angle.hpp>
+#include <glm/gtx/closest_point.hpp>
+
+#include <radahn/motor/selectionMotor.h>
+
+namespace radahn {
+
+namespace motor {
+
+// Base of the motors tracking the rotation of their selection around an axis with one of its atoms
+class RotationMotor : public SelectionMotor
+{
+public:
+    RotationMotor() : SelectionMotor() {}
+    RotationMotor(const std::string& name, const std::set<radahn::core::atomIndexes_t>& selection) : 
+        SelectionMotor(name, selection) {}
+
+    // Once started, only the tracked atom is needed on top of the center of the selection
+    virtual void collectReductions(conduit::Node& requests) const override;
+
+    virtual void saveState(conduit::Node& node) const override;
+    virtual bool loadState(const conduit::Node& node) override;
+
+protected:
+    // Variables used internally only to track the rotation
+    glm::dvec3 m_centroid;
+    glm::dvec3 m_rotationAxis;
+    glm::dvec3 m_trackedPointFirstIteration;            // Tracked atom taken when the motor started. It served as a starting point to track the rotation done
+    glm::dvec3 m_trackedPointFirstIterationProjection;  // Projection of the tracked point on the rotation axis based on its positions during the first iteration
+    glm::dvec3 m_firstIterationProjectionVector;        // Vector between the tracked atom position during the first iteration and its projection on the rotation vector
+    double m_previousRotationAngleDeg = 0;
+    double m_previousRotationAngleRad = 0;
+    double m_totalRotationDeg = 0;
+    int32_t m_nbRotationCompleted = 0;
+    size_t m_trackedAtomIndex = 0;
+};
+
+} // motor
+
+} // radahn
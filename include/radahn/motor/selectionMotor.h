@@ -0,0 +1,40 @@
+#pragma once 
+
+#include <array>
+
+#include <radahn/motor/motor.h>
+#include <radahn/core/atomSet.h>
+
+namespace radahn {
+
+namespace motor {
+
+// Base of the motors acting on a selection of atoms. The selection is tracked in m_currentState,
+// and m_initialState keeps the selection as it was when the motor started.
+class SelectionMotor : public Motor
+{
+public:
+    SelectionMotor() : Motor() {}
+    SelectionMotor(const std::string& name, const std::set<radahn::core::atomIndexes_t>& selection) : 
+        Motor(name), 
+        m_currentState(selection) {}
+
+    virtual void collectSelection(std::vector<radahn::core::atomIndexes_t>& selection) const override;
+    virtual void collectReductions(conduit::Node& requests) const override;
+    virtual void applyReduction(radahn::core::simIt_t it, const conduit::Node& reduction) override;
+
+    virtual void saveState(conduit::Node& node) const override;
+    virtual bool loadState(const conduit::Node& node) override;
+
+protected:
+    // Read the 3 components of node[name], false if the field is missing or has less than 3 values
+    bool loadVector(const conduit::Node& node, const std::string& name, std::array<double, 3>& values) const;
+
+    radahn::core::AtomSet m_currentState;
+    bool m_initialStateRegistered   = false;
+    radahn::core::AtomSet m_initialState;
+};
+
+} // motor
+
+} // radahn
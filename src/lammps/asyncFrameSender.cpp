@@ -0,0 +1,134 @@
+#include "asyncFrameSender.h"
+
+#include <chrono>
+
+#include <spdlog/spdlog.h>
+
+AsyncFrameSender::AsyncFrameSender(godrick::mpi::GodrickMPI& handler, const std::string& outPort, const std::string& inPort) :
+    m_handler(handler),
+    m_outPort(outPort),
+    m_inPort(inPort)
+{
+    m_thread = std::thread(&AsyncFrameSender::run, this);
+}
+
+AsyncFrameSender::~AsyncFrameSender()
+{
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+bool AsyncFrameSender::isSupported()
+{
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&provided);
+    return provided == MPI_THREAD_MULTIPLE;
+}
+
+conduit::Node& AsyncFrameSender::acquireBuffer()
+{
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]{ return !m_submitted[m_writeIndex]; });
+    m_waitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The buffer keeps the content of its previous frame, the caller rewrites it in place
+    return m_buffers[m_writeIndex];
+}
+
+void AsyncFrameSender::submit()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_submitted[m_writeIndex] = true;
+        m_operations.emplace_back(Operation::PUSH, m_writeIndex);
+        m_writeIndex = 1 - m_writeIndex;
+    }
+    m_cv.notify_all();
+}
+
+void AsyncFrameSender::requestReceive()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_receiveQueued || m_receiveReady)
+            return;
+        m_receiveQueued = true;
+        m_operations.emplace_back(Operation::RECEIVE, 0);
+    }
+    m_cv.notify_all();
+}
+
+godrick::MessageResponse AsyncFrameSender::receive(std::vector<conduit::Node>& data)
+{
+    requestReceive();
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]{ return m_receiveReady; });
+    m_waitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    m_receiveReady = false;
+    data.swap(m_received);
+    return m_receiveResponse;
+}
+
+void AsyncFrameSender::flush()
+{
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]{ return m_operations.empty(); });
+    m_waitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void AsyncFrameSender::run()
+{
+    std::vector<conduit::Node> received;
+    while(true)
+    {
+        std::pair<Operation, size_t> operation;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_stop || !m_operations.empty(); });
+            if(m_operations.empty())
+                return;
+            // The operation stays in the queue until it is done so that flush() waits for it
+            operation = m_operations.front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        godrick::MessageResponse response = godrick::MessageResponse::ERROR;
+        if(operation.first == Operation::PUSH)
+        {
+            if(!m_handler.push(m_outPort, m_buffers[operation.second], true))
+                spdlog::error("The asynchronous sender failed to push a frame on the port {}.", m_outPort);
+        }
+        else
+            response = m_handler.get(m_inPort, received);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_operations.pop_front();
+            m_exchangeTime += elapsed;
+            if(operation.first == Operation::PUSH)
+            {
+                m_submitted[operation.second] = false;
+                m_nbFramesSent++;
+            }
+            else
+            {
+                m_received.swap(received);
+                m_receiveResponse = response;
+                m_receiveQueued = false;
+                m_receiveReady = true;
+            }
+        }
+        m_cv.notify_all();
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <array>
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+#include <godrick/mpi/godrickMPI.h>
+#include <conduit/conduit.hpp>
+
+// Exchange the messages with the engine from a dedicated thread so that Lammps can run the next interval
+// while the previous frame is serialized and pushed.
+// The thread owns every call to the Godrick handler once created: the pushes on the output port and the receptions
+// on the input port are executed by this thread only, in the order they are queued by the main thread.
+// The frames are built in one of two staging buffers: while the thread pushes one buffer, the main thread fills
+// the other one. The messages must not reference the Lammps memory (no zero copy).
+//
+// To overlap the push with the next interval, the reception of the next commands is queued before the frame is submitted.
+// These commands must not depend on the frame pushed after them, which requires a command lag of at least 1 interval.
+// Lammps keeps calling MPI from the main thread, MPI must provide MPI_THREAD_MULTIPLE and Lammps must use its own communicator.
+class AsyncFrameSender
+{
+public:
+    AsyncFrameSender(godrick::mpi::GodrickMPI& handler, const std::string& outPort, const std::string& inPort);
+    ~AsyncFrameSender();
+
+    // Check if the MPI library supports calls from several threads.
+    static bool isSupported();
+
+    // Return the buffer to fill for the next frame, with the content of the frame sent two frames ago.
+    // Blocks while this buffer is still being pushed.
+    conduit::Node& acquireBuffer();
+    // Queue the push of the buffer returned by the last acquireBuffer().
+    void submit();
+
+    // Queue the reception of the next message on the input port, unless it is already queued.
+    void requestReceive();
+    // Wait for the next message on the input port, queued now if requestReceive() wasn't called.
+    godrick::MessageResponse receive(std::vector<conduit::Node>& data);
+
+    // Wait until all the queued pushes and receptions are done.
+    void flush();
+
+    // Time (s) spent by the thread in the pushes and receptions, i.e. the time the main thread would have spent in them.
+    double getExchangeTime() const { return m_exchangeTime; }
+    // Time (s) spent by the main thread waiting for a free buffer or for a received message.
+    double getWaitTime() const { return m_waitTime; }
+    double getSavedTime() const { return m_exchangeTime - m_waitTime; }
+    uint64_t getNbFramesSent() const { return m_nbFramesSent; }
+
+private:
+    enum class Operation { PUSH, RECEIVE };
+
+    void run();
+
+    godrick::mpi::GodrickMPI& m_handler;
+    std::string m_outPort;
+    std::string m_inPort;
+
+    std::array<conduit::Node, 2> m_buffers;
+    std::array<bool, 2> m_submitted = {false, false};   // Buffer queued and not yet pushed
+    size_t m_writeIndex = 0;
+
+    // Operation and buffer index of the pushes, the first one is being executed by the thread
+    std::deque<std::pair<Operation, size_t>> m_operations;
+    bool m_receiveQueued = false;
+    bool m_receiveReady = false;
+    godrick::MessageResponse m_receiveResponse = godrick::MessageResponse::ERROR;
+    std::vector<conduit::Node> m_received;
+    bool m_stop = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+
+    double m_exchangeTime = 0.0;
+    double m_waitTime = 0.0;
+    uint64_t m_nbFramesSent = 0;
+};
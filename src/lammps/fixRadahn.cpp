@@ -0,0 +1,582 @@
+#include "fixRadahn.h"
+#include "fixRadahnSample.h"
+
+#include <cmath>
+#include <numbers>
+#include <cstring>
+
+#include "atom.h"
+#include "domain.h"
+#include "error.h"
+#include "force.h"
+#include "lammps.h"
+#include "modify.h"
+#include "neighbor.h"
+#include "update.h"
+
+using namespace LAMMPS_NS;
+using namespace FixConst;
+
+namespace
+{
+
+// out = inertia^-1 * in, 0 if the inertia tensor is singular (selection of 1 atom or aligned atoms)
+void solveInertia(const double inertia[3][3], const double in[3], double out[3])
+{
+    double det = inertia[0][0]*(inertia[1][1]*inertia[2][2] - inertia[1][2]*inertia[2][1])
+               - inertia[0][1]*(inertia[1][0]*inertia[2][2] - inertia[1][2]*inertia[2][0])
+               + inertia[0][2]*(inertia[1][0]*inertia[2][1] - inertia[1][1]*inertia[2][0]);
+
+    out[0] = out[1] = out[2] = 0.0;
+    if(std::abs(det) < 1.0e-6)
+        return;
+
+    double inverse[3][3];
+    inverse[0][0] = (inertia[1][1]*inertia[2][2] - inertia[1][2]*inertia[2][1]) / det;
+    inverse[0][1] = (inertia[0][2]*inertia[2][1] - inertia[0][1]*inertia[2][2]) / det;
+    inverse[0][2] = (inertia[0][1]*inertia[1][2] - inertia[0][2]*inertia[1][1]) / det;
+    inverse[1][0] = (inertia[1][2]*inertia[2][0] - inertia[1][0]*inertia[2][2]) / det;
+    inverse[1][1] = (inertia[0][0]*inertia[2][2] - inertia[0][2]*inertia[2][0]) / det;
+    inverse[1][2] = (inertia[0][2]*inertia[1][0] - inertia[0][0]*inertia[1][2]) / det;
+    inverse[2][0] = (inertia[1][0]*inertia[2][1] - inertia[1][1]*inertia[2][0]) / det;
+    inverse[2][1] = (inertia[0][1]*inertia[2][0] - inertia[0][0]*inertia[2][1]) / det;
+    inverse[2][2] = (inertia[0][0]*inertia[1][1] - inertia[0][1]*inertia[1][0]) / det;
+
+    for(int i = 0; i < 3; ++i)
+        out[i] = inverse[i][0]*in[0] + inverse[i][1]*in[1] + inverse[i][2]*in[2];
+}
+
+template<typename T>
+void packValue(std::vector<uint8_t>& buffer, const T& value)
+{
+    auto bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+bool unpackValue(const std::string& buffer, size_t& offset, T& value)
+{
+    if(offset + sizeof(T) > buffer.size())
+        return false;
+    std::memcpy(&value, buffer.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+} // namespace
+
+FixRadahn::FixRadahn(LAMMPS *lammps, int narg, char **arg) : Fix(lammps, narg, arg)
+{
+    if(narg != 3)
+        error->all(FLERR, "Illegal fix radahn command: expected fix ID group-ID radahn");
+
+    time_integrate = 1;
+}
+
+int FixRadahn::setmask()
+{
+    int mask = 0;
+    mask |= INITIAL_INTEGRATE;
+    mask |= POST_FORCE;
+    mask |= FINAL_INTEGRATE;
+    return mask;
+}
+
+void FixRadahn::init()
+{
+    if(atom->map_style == Atom::MAP_NONE)
+        error->all(FLERR, "Fix radahn requires an atom map, see the atom_modify command");
+
+    reset_dt();
+
+    // The atoms are sorted and exchanged by the setup of the run following init()
+    m_prescribedDirty = true;
+}
+
+void FixRadahn::setup(int vflag)
+{
+    // The forces have just been computed again, the actions are added to them.
+    // The setup can run again on the step of the previous run (run N pre no), the completion state is kept in that case.
+    post_force(vflag);
+}
+
+void FixRadahn::reset_dt()
+{
+    m_dtv = update->dt;
+    m_dtf = 0.5 * update->dt * force->ftm2v;
+}
+
+void FixRadahn::setActions(std::vector<Action> actions)
+{
+    for(auto & action : actions)
+    {
+        for(auto & previous : m_actions)
+        {
+            if(previous.origin == action.origin && previous.type == action.type && previous.selection == action.selection)
+            {
+                action.started = previous.started;
+                action.completed = previous.completed;
+                action.completedStep = previous.completedStep;
+                action.initialCenter = previous.initialCenter;
+                // A rotation with new parameters starts again from the current positions
+                if(action.type == ActionType::ROTATE && previous.params == action.params)
+                {
+                    action.rotationStart = previous.rotationStart;
+                    action.rotationOrigin = std::move(previous.rotationOrigin);
+                }
+                break;
+            }
+        }
+    }
+    m_actions = std::move(actions);
+    m_prescribedDirty = true;
+    m_completionStep = -1;
+}
+
+void FixRadahn::packActions(const std::vector<Action>& actions, std::vector<uint8_t>& buffer)
+{
+    packValue(buffer, static_cast<uint64_t>(actions.size()));
+    for(auto & action : actions)
+    {
+        packValue(buffer, static_cast<uint64_t>(action.origin.size()));
+        buffer.insert(buffer.end(), action.origin.begin(), action.origin.end());
+        packValue(buffer, action.type);
+        packValue(buffer, static_cast<uint64_t>(action.selection.size()));
+        for(auto tag : action.selection)
+            packValue(buffer, tag);
+        packValue(buffer, action.params);
+        packValue(buffer, action.check);
+        packValue(buffer, action.distance);
+    }
+}
+
+bool FixRadahn::unpackActions(const std::string& buffer, std::vector<Action>& actions)
+{
+    size_t offset = 0;
+    uint64_t nbActions = 0;
+    if(!unpackValue(buffer, offset, nbActions))
+        return false;
+
+    actions.clear();
+    for(uint64_t a = 0; a < nbActions; ++a)
+    {
+        Action action;
+        uint64_t originSize = 0;
+        if(!unpackValue(buffer, offset, originSize) || offset + originSize > buffer.size())
+            return false;
+        action.origin = buffer.substr(offset, originSize);
+        offset += originSize;
+
+        uint64_t selectionSize = 0;
+        if(!unpackValue(buffer, offset, action.type) || !unpackValue(buffer, offset, selectionSize))
+            return false;
+        action.selection.resize(selectionSize);
+        for(auto & tag : action.selection)
+        {
+            if(!unpackValue(buffer, offset, tag))
+                return false;
+        }
+
+        if(!unpackValue(buffer, offset, action.params) || !unpackValue(buffer, offset, action.check) || !unpackValue(buffer, offset, action.distance))
+            return false;
+        actions.push_back(std::move(action));
+    }
+    return offset == buffer.size();
+}
+
+double FixRadahn::getMass(int i) const
+{
+    if(atom->rmass)
+        return atom->rmass[i];
+    return atom->mass[atom->type[i]];
+}
+
+void FixRadahn::buildPrescribedMap()
+{
+    int nlocal = atom->nlocal;
+    m_prescribed.assign(static_cast<size_t>(nlocal), -1);
+    m_prescribedMember.assign(static_cast<size_t>(nlocal), -1);
+
+    for(size_t a = 0; a < m_actions.size(); ++a)
+    {
+        auto & action = m_actions[a];
+        if(action.completed || (action.type != ActionType::MOVE && action.type != ActionType::ROTATE))
+            continue;
+
+        for(size_t s = 0; s < action.selection.size(); ++s)
+        {
+            int i = atom->map(action.selection[s]);
+            if(i >= 0 && i < nlocal)
+            {
+                m_prescribed[static_cast<size_t>(i)] = static_cast<int>(a);
+                m_prescribedMember[static_cast<size_t>(i)] = static_cast<int>(s);
+            }
+        }
+    }
+    m_prescribedDirty = false;
+}
+
+void FixRadahn::startRotations()
+{
+    for(auto & action : m_actions)
+    {
+        if(action.type != ActionType::ROTATE || action.completed || action.rotationStart >= 0)
+            continue;
+
+        // Each atom is owned by a single proc, the sum gives the positions of the whole selection on every proc
+        std::vector<double> local(3 * action.selection.size(), 0.0);
+        action.rotationOrigin.assign(local.size(), 0.0);
+        for(size_t s = 0; s < action.selection.size(); ++s)
+        {
+            int i = atom->map(action.selection[s]);
+            if(i >= 0 && i < atom->nlocal)
+                domain->unmap(atom->x[i], atom->image[i], &local[3*s]);
+        }
+        MPI_Allreduce(local.data(), action.rotationOrigin.data(), static_cast<int>(local.size()), MPI_DOUBLE, MPI_SUM, world);
+
+        // The positions are the ones of the previous step, the current step is the first one rotated
+        action.rotationStart = update->ntimestep - 1;
+    }
+}
+
+void FixRadahn::rotateAtom(Action& action, int member, int i)
+{
+    // Rotation of the original unwrapped position around the axis (Rodrigues formula), same as fix move rotate
+    auto & p = action.params;
+    double axisNorm = std::sqrt(p[3]*p[3] + p[4]*p[4] + p[5]*p[5]);
+    if(axisNorm == 0.0 || p[6] == 0.0)
+        return;
+    double ax = p[3] / axisNorm;
+    double ay = p[4] / axisNorm;
+    double az = p[5] / axisNorm;
+    double omega = 2.0 * std::numbers::pi / p[6];
+    double angle = omega * m_dtv * static_cast<double>(update->ntimestep - action.rotationStart);
+    double c = std::cos(angle);
+    double s = std::sin(angle);
+
+    const double* origin = &action.rotationOrigin[3 * static_cast<size_t>(member)];
+    double rx = origin[0] - p[0];
+    double ry = origin[1] - p[1];
+    double rz = origin[2] - p[2];
+    double dot = ax*rx + ay*ry + az*rz;
+    double nx = rx*c + (ay*rz - az*ry)*s + ax*dot*(1.0 - c);
+    double ny = ry*c + (az*rx - ax*rz)*s + ay*dot*(1.0 - c);
+    double nz = rz*c + (ax*ry - ay*rx)*s + az*dot*(1.0 - c);
+
+    // The new unwrapped position is moved back in the box of the current image of the atom
+    double **x = atom->x;
+    double unwrap[3];
+    domain->unmap(x[i], atom->image[i], unwrap);
+    x[i][0] += p[0] + nx - unwrap[0];
+    x[i][1] += p[1] + ny - unwrap[1];
+    x[i][2] += p[2] + nz - unwrap[2];
+
+    double **v = atom->v;
+    v[i][0] = omega * (ay*nz - az*ny);
+    v[i][1] = omega * (az*nx - ax*nz);
+    v[i][2] = omega * (ax*ny - ay*nx);
+}
+
+void FixRadahn::initial_integrate(int /*vflag*/)
+{
+    double **x = atom->x;
+    double **v = atom->v;
+    double **f = atom->f;
+    int *mask = atom->mask;
+    int nlocal = atom->nlocal;
+
+    startRotations();
+    if(m_prescribedDirty || m_prescribed.size() != static_cast<size_t>(nlocal))
+        buildPrescribedMap();
+
+    for(int i = 0; i < nlocal; ++i)
+    {
+        int a = m_prescribed[static_cast<size_t>(i)];
+        if(a >= 0)
+        {
+            auto & action = m_actions[static_cast<size_t>(a)];
+            if(action.type == ActionType::MOVE)
+            {
+                for(int d = 0; d < 3; ++d)
+                {
+                    v[i][d] = action.params[static_cast<size_t>(d)];
+                    x[i][d] += m_dtv * v[i][d];
+                }
+            }
+            else
+                rotateAtom(action, m_prescribedMember[static_cast<size_t>(i)], i);
+        }
+        else if(mask[i] & groupbit)
+        {
+            // Velocity Verlet, same as fix nve
+            double dtfm = m_dtf / getMass(i);
+            for(int d = 0; d < 3; ++d)
+            {
+                v[i][d] += dtfm * f[i][d];
+                x[i][d] += m_dtv * v[i][d];
+            }
+        }
+    }
+}
+
+void FixRadahn::final_integrate()
+{
+    double **v = atom->v;
+    double **f = atom->f;
+    int *mask = atom->mask;
+    int nlocal = atom->nlocal;
+
+    // The atoms are exchanged between the procs when the neighbor lists are rebuilt, after initial_integrate
+    if(m_prescribedDirty || neighbor->ago == 0 || m_prescribed.size() != static_cast<size_t>(nlocal))
+        buildPrescribedMap();
+
+    for(int i = 0; i < nlocal; ++i)
+    {
+        if(m_prescribed[static_cast<size_t>(i)] < 0 && (mask[i] & groupbit))
+        {
+            double dtfm = m_dtf / getMass(i);
+            for(int d = 0; d < 3; ++d)
+                v[i][d] += dtfm * f[i][d];
+        }
+    }
+}
+
+void FixRadahn::computeCenters(std::vector<std::array<double, 3>>& centers)
+{
+    // Sum of the unwrapped positions and nb of atoms for each action with a completion criteria, reduced in a single call
+    std::vector<double> local(4 * m_actions.size(), 0.0);
+    std::vector<double> global(4 * m_actions.size(), 0.0);
+    int nlocal = atom->nlocal;
+
+    for(size_t a = 0; a < m_actions.size(); ++a)
+    {
+        auto & action = m_actions[a];
+        if(action.completed || !action.hasCompletion())
+            continue;
+
+        for(auto tag : action.selection)
+        {
+            int i = atom->map(tag);
+            if(i < 0 || i >= nlocal)
+                continue;
+            double unwrap[3];
+            domain->unmap(atom->x[i], atom->image[i], unwrap);
+            local[4*a] += unwrap[0];
+            local[4*a+1] += unwrap[1];
+            local[4*a+2] += unwrap[2];
+            local[4*a+3] += 1.0;
+        }
+    }
+    MPI_Allreduce(local.data(), global.data(), static_cast<int>(global.size()), MPI_DOUBLE, MPI_SUM, world);
+
+    centers.assign(m_actions.size(), {0.0, 0.0, 0.0});
+    for(size_t a = 0; a < m_actions.size(); ++a)
+    {
+        if(global[4*a+3] > 0.0)
+        {
+            for(size_t d = 0; d < 3; ++d)
+                centers[a][d] = global[4*a+d] / global[4*a+3];
+        }
+    }
+}
+
+void FixRadahn::updateCompletion()
+{
+    if(m_completionStep == update->ntimestep)
+        return;
+    m_completionStep = update->ntimestep;
+
+    bool needCenters = false;
+    for(auto & action : m_actions)
+        needCenters |= !action.completed && action.hasCompletion();
+    if(!needCenters)
+        return;
+
+    std::vector<std::array<double, 3>> centers;
+    computeCenters(centers);
+
+    for(size_t a = 0; a < m_actions.size(); ++a)
+    {
+        auto & action = m_actions[a];
+        if(action.completed || !action.hasCompletion())
+            continue;
+
+        if(!action.started)
+        {
+            action.initialCenter = centers[a];
+            action.started = true;
+            continue;
+        }
+
+        // Same criteria as the motors of the engine
+        bool valid = true;
+        for(size_t d = 0; d < 3; ++d)
+        {
+            if(!action.check[d])
+                continue;
+            double done = centers[a][d] - action.initialCenter[d];
+            valid &= (action.distance[d] < 0.0 && done <= action.distance[d]) || (action.distance[d] >= 0.0 && done >= action.distance[d]);
+        }
+
+        if(valid)
+        {
+            action.completed = true;
+            action.completedStep = update->ntimestep;
+            m_prescribedDirty = true;
+        }
+    }
+}
+
+void FixRadahn::applyTorque(const Action& action)
+{
+    double **x = atom->x;
+    double **v = atom->v;
+    double **f = atom->f;
+    int nlocal = atom->nlocal;
+
+    std::vector<int> locals;
+    locals.reserve(action.selection.size());
+    for(auto tag : action.selection)
+    {
+        int i = atom->map(tag);
+        if(i >= 0 && i < nlocal)
+            locals.push_back(i);
+    }
+
+    // Center of mass
+    double local[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    double global[9];
+    for(auto i : locals)
+    {
+        double unwrap[3];
+        domain->unmap(x[i], atom->image[i], unwrap);
+        double massone = getMass(i);
+        local[0] += massone * unwrap[0];
+        local[1] += massone * unwrap[1];
+        local[2] += massone * unwrap[2];
+        local[3] += massone;
+    }
+    MPI_Allreduce(local, global, 4, MPI_DOUBLE, MPI_SUM, world);
+    if(global[3] <= 0.0)
+        return;
+    double xcm[3] = {global[0] / global[3], global[1] / global[3], global[2] / global[3]};
+
+    // Inertia tensor and angular momentum around the center of mass
+    for(auto & value : local)
+        value = 0.0;
+    for(auto i : locals)
+    {
+        double unwrap[3];
+        domain->unmap(x[i], atom->image[i], unwrap);
+        double dx = unwrap[0] - xcm[0];
+        double dy = unwrap[1] - xcm[1];
+        double dz = unwrap[2] - xcm[2];
+        double massone = getMass(i);
+        local[0] += massone * (dy*dy + dz*dz);
+        local[1] += massone * (dx*dx + dz*dz);
+        local[2] += massone * (dx*dx + dy*dy);
+        local[3] -= massone * dx*dy;
+        local[4] -= massone * dy*dz;
+        local[5] -= massone * dx*dz;
+        local[6] += massone * (dy*v[i][2] - dz*v[i][1]);
+        local[7] += massone * (dz*v[i][0] - dx*v[i][2]);
+        local[8] += massone * (dx*v[i][1] - dy*v[i][0]);
+    }
+    MPI_Allreduce(local, global, 9, MPI_DOUBLE, MPI_SUM, world);
+    double inertia[3][3] = {
+        {global[0], global[3], global[5]},
+        {global[3], global[1], global[4]},
+        {global[5], global[4], global[2]}};
+    double angmom[3] = {global[6], global[7], global[8]};
+    double omega[3];
+    solveInertia(inertia, angmom, omega);
+
+    // Same decomposition of the torque into per atom forces as fix addtorque
+    double mvv2e = force->mvv2e;
+    double tlocal[3] = {0.0, 0.0, 0.0};
+    double itorque[3];
+    for(auto i : locals)
+    {
+        double unwrap[3];
+        domain->unmap(x[i], atom->image[i], unwrap);
+        double dx = unwrap[0] - xcm[0];
+        double dy = unwrap[1] - xcm[1];
+        double dz = unwrap[2] - xcm[2];
+        double massone = getMass(i);
+        double omegadotr = omega[0]*dx + omega[1]*dy + omega[2]*dz;
+        tlocal[0] += massone * omegadotr * (dy*omega[2] - dz*omega[1]);
+        tlocal[1] += massone * omegadotr * (dz*omega[0] - dx*omega[2]);
+        tlocal[2] += massone * omegadotr * (dx*omega[1] - dy*omega[0]);
+    }
+    MPI_Allreduce(tlocal, itorque, 3, MPI_DOUBLE, MPI_SUM, world);
+
+    double tcm[3];
+    tcm[0] = action.params[0] - mvv2e * itorque[0];
+    tcm[1] = action.params[1] - mvv2e * itorque[1];
+    tcm[2] = action.params[2] - mvv2e * itorque[2];
+    double domegadt[3];
+    solveInertia(inertia, tcm, domegadt);
+
+    for(auto i : locals)
+    {
+        double unwrap[3];
+        domain->unmap(x[i], atom->image[i], unwrap);
+        double dx = unwrap[0] - xcm[0];
+        double dy = unwrap[1] - xcm[1];
+        double dz = unwrap[2] - xcm[2];
+        double vx = mvv2e * (dz*omega[1] - dy*omega[2]);
+        double vy = mvv2e * (dx*omega[2] - dz*omega[0]);
+        double vz = mvv2e * (dy*omega[0] - dx*omega[1]);
+        double massone = getMass(i);
+        f[i][0] += massone * (dz*domegadt[1] - dy*domegadt[2] + vz*omega[1] - vy*omega[2]);
+        f[i][1] += massone * (dx*domegadt[2] - dz*domegadt[0] + vx*omega[2] - vz*omega[0]);
+        f[i][2] += massone * (dy*domegadt[0] - dx*domegadt[1] + vy*omega[0] - vx*omega[1]);
+    }
+}
+
+void FixRadahn::post_force(int /*vflag*/)
+{
+    // The completion is evaluated on the positions of this step, before adding the forces
+    updateCompletion();
+
+    double **f = atom->f;
+    int nlocal = atom->nlocal;
+    for(auto & action : m_actions)
+    {
+        if(action.completed)
+            continue;
+
+        if(action.type == ActionType::FORCE)
+        {
+            for(auto tag : action.selection)
+            {
+                int i = atom->map(tag);
+                if(i < 0 || i >= nlocal)
+                    continue;
+                f[i][0] += action.params[0];
+                f[i][1] += action.params[1];
+                f[i][2] += action.params[2];
+            }
+        }
+        else if(action.type == ActionType::TORQUE)
+        {
+            applyTorque(action);
+        }
+    }
+}
+
+Fix* LAMMPS_NS::createFixRadahn(LAMMPS* lps, int argc, char** argv)
+{
+    return new FixRadahn(lps, argc, argv);
+}
+
+Fix* LAMMPS_NS::createFixRadahnSample(LAMMPS* lps, int argc, char** argv)
+{
+    return new FixRadahnSample(lps, argc, argv);
+}
+
+void LAMMPS_NS::registerRadahnFixes(LAMMPS* lps)
+{
+    (*lps->modify->fix_map)["radahn"] = &createFixRadahn;
+    (*lps->modify->fix_map)["radahn/sample"] = &createFixRadahnSample;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "fix.h"
+
+namespace LAMMPS_NS {
+
+// fix ID group-ID radahn
+//
+// Time integration (NVE) of the atoms of the group, combined with the actions of the Radahn motors.
+// The motor actions are given in binary form by the driver with setActions() instead of going through
+// fix move/addforce/addtorque commands, and are evaluated every step:
+//  - MOVE/ROTATE: the selected atoms follow a prescribed linear/rotational motion and are excluded from the NVE integration,
+//  - FORCE/TORQUE: a force (per atom) or a torque (on the selection) is added in post_force.
+// MOVE and FORCE actions can have a completion criteria on the displacement of the geometrical center of their selection.
+// Once reached, the action stops being applied on the same step, without waiting for the motor engine.
+//
+// The fix can be registered by the driver directly, or loaded in a regular Lammps executable with "plugin load radahnplugin.so".
+class FixRadahn : public Fix
+{
+public:
+    enum class ActionType : uint8_t
+    {
+        MOVE = 0,
+        ROTATE = 1,
+        FORCE = 2,
+        TORQUE = 3
+    };
+
+    struct Action
+    {
+        std::string origin;
+        ActionType type = ActionType::MOVE;
+        std::vector<tagint> selection;
+
+        // MOVE: vx vy vz, ROTATE: px py pz ax ay az period, FORCE: fx fy fz, TORQUE: tx ty tz
+        std::array<double, 7> params = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+        // Completion criteria on the displacement of the selection center (MOVE and FORCE only)
+        std::array<bool, 3> check = {false, false, false};
+        std::array<double, 3> distance = {0.0, 0.0, 0.0};
+
+        // Runtime state, kept by setActions() for the actions with the same origin and type
+        bool started = false;
+        bool completed = false;
+        bigint completedStep = -1;
+        std::array<double, 3> initialCenter = {0.0, 0.0, 0.0};
+
+        // ROTATE: unwrapped positions of the selection when the rotation started (3 per selected atom), and its step.
+        // As with fix move, the positions are computed from them every step instead of being rotated incrementally.
+        bigint rotationStart = -1;
+        std::vector<double> rotationOrigin;
+
+        bool hasCompletion() const { return check[0] || check[1] || check[2]; }
+    };
+
+    FixRadahn(class LAMMPS *lammps, int narg, char **arg);
+
+    int setmask() override;
+    void init() override;
+    void setup(int vflag) override;
+    void initial_integrate(int vflag) override;
+    void post_force(int vflag) override;
+    void final_integrate() override;
+    void reset_dt() override;
+
+    // Replace the current actions. The state of the actions already running (same origin and type) is preserved.
+    void setActions(std::vector<Action> actions);
+    const std::vector<Action>& getActions() const { return m_actions; }
+
+    // Binary form of the action settings (without the runtime state), used to journal and replay the actions.
+    static void packActions(const std::vector<Action>& actions, std::vector<uint8_t>& buffer);
+    static bool unpackActions(const std::string& buffer, std::vector<Action>& actions);
+
+protected:
+    double m_dtv = 0.0;
+    double m_dtf = 0.0;
+    std::vector<Action> m_actions;
+    // Per local atom, index of the MOVE/ROTATE action moving it (-1 if integrated) and of the atom in its selection.
+    // Rebuilt when the actions change or when the atoms are exchanged between the procs.
+    std::vector<int> m_prescribed;
+    std::vector<int> m_prescribedMember;
+    bool m_prescribedDirty = true;
+    // Step of the last completion evaluation, a setup() on the same step doesn't evaluate it again
+    bigint m_completionStep = -1;
+
+    void buildPrescribedMap();
+    void startRotations();
+    void rotateAtom(Action& action, int member, int i);
+    double getMass(int i) const;
+    void computeCenters(std::vector<std::array<double, 3>>& centers);
+    void updateCompletion();
+    void applyTorque(const Action& action);
+};
+
+// Factories of the fix radahn and radahn/sample styles, shared by the driver, the replay and the plugin
+Fix* createFixRadahn(LAMMPS* lps, int argc, char** argv);
+Fix* createFixRadahnSample(LAMMPS* lps, int argc, char** argv);
+
+// Make the fix radahn and radahn/sample styles available without going through the Lammps plugin package
+void registerRadahnFixes(LAMMPS* lps);
+
+} // LAMMPS_NS
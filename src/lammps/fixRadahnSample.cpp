@@ -0,0 +1,143 @@
+#include "fixRadahnSample.h"
+
+#include "compute.h"
+#include "error.h"
+#include "input.h"
+#include "modify.h"
+#include "output.h"
+#include "thermo.h"
+#include "update.h"
+#include "variable.h"
+
+using namespace LAMMPS_NS;
+using namespace FixConst;
+
+FixRadahnSample::FixRadahnSample(LAMMPS *lammps, int narg, char **arg) : Fix(lammps, narg, arg)
+{
+    if(narg < 4)
+        error->all(FLERR, "Illegal fix radahn/sample command: expected fix ID group-ID radahn/sample field1 field2 ...");
+
+    for(int i = 3; i < narg; ++i)
+    {
+        std::string field(arg[i]);
+        m_fields.push_back(field);
+        if(field.starts_with("c_"))
+            m_types.push_back(FieldType::COMPUTE);
+        else if(field.starts_with("v_"))
+            m_types.push_back(FieldType::VARIABLE);
+        else
+            m_types.push_back(FieldType::KEYWORD);
+    }
+
+    m_computes.resize(m_fields.size(), nullptr);
+    m_variables.resize(m_fields.size(), -1);
+    m_values.resize(m_fields.size(), 0.0);
+
+    nevery = 1;
+    vector_flag = 1;
+    size_vector = static_cast<int>(m_fields.size());
+    global_freq = 1;
+    extvector = 0;
+}
+
+int FixRadahnSample::setmask()
+{
+    int mask = 0;
+    mask |= END_OF_STEP;
+    return mask;
+}
+
+void FixRadahnSample::init()
+{
+    // The computes and variables can be redefined between two runs
+    for(size_t i = 0; i < m_fields.size(); ++i)
+    {
+        if(m_types[i] == FieldType::KEYWORD)
+            continue;
+
+        std::string name = m_fields[i].substr(2);
+        if(m_types[i] == FieldType::COMPUTE)
+        {
+            m_computes[i] = modify->get_compute_by_id(name);
+            if(m_computes[i] == nullptr)
+                error->all(FLERR, "Compute ID {} for fix radahn/sample does not exist", name);
+            if(m_computes[i]->scalar_flag == 0)
+                error->all(FLERR, "Compute {} for fix radahn/sample does not calculate a global scalar", name);
+        }
+        else
+        {
+            m_variables[i] = input->variable->find(name.c_str());
+            if(m_variables[i] < 0)
+                error->all(FLERR, "Variable name {} for fix radahn/sample does not exist", name);
+            if(input->variable->equalstyle(m_variables[i]) == 0)
+                error->all(FLERR, "Variable {} for fix radahn/sample is not equal-style", name);
+        }
+    }
+}
+
+void FixRadahnSample::setup(int vflag)
+{
+    (void)vflag;
+
+    // Request the computes to be current on the last step of the run
+    scheduleSample(update->endstep);
+}
+
+void FixRadahnSample::scheduleSample(bigint step)
+{
+    modify->addstep_compute(step);
+    m_scheduledStep = step;
+}
+
+void FixRadahnSample::end_of_step()
+{
+    if(update->ntimestep != update->endstep)
+    {
+        // Runs started with "pre no" may not call setup(), the last step is flagged on the first step of the run instead
+        if(m_scheduledStep != update->endstep)
+            scheduleSample(update->endstep);
+        return;
+    }
+
+    modify->clearstep_compute();
+    sample();
+    modify->addstep_compute(update->ntimestep + 1);
+}
+
+double FixRadahnSample::compute_vector(int n)
+{
+    return m_values[static_cast<size_t>(n)];
+}
+
+void FixRadahnSample::sample()
+{
+    for(size_t i = 0; i < m_fields.size(); ++i)
+    {
+        switch(m_types[i])
+        {
+            case FieldType::COMPUTE:
+            {
+                Compute* compute = m_computes[i];
+                if((compute->invoked_flag & Compute::INVOKED_SCALAR) == 0)
+                {
+                    compute->compute_scalar();
+                    compute->invoked_flag |= Compute::INVOKED_SCALAR;
+                }
+                m_values[i] = compute->scalar;
+                break;
+            }
+            case FieldType::VARIABLE:
+            {
+                m_values[i] = input->variable->compute_equal(m_variables[i]);
+                break;
+            }
+            case FieldType::KEYWORD:
+            {
+                if(output->thermo->evaluate_keyword(m_fields[i], &m_values[i]) != 0)
+                    error->all(FLERR, "Unknown thermo keyword {} for fix radahn/sample", m_fields[i]);
+                break;
+            }
+        }
+    }
+    m_sampledStep = update->ntimestep;
+}
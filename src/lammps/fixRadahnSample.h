@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "fix.h"
+
+namespace LAMMPS_NS {
+
+// fix ID group-ID radahn/sample field1 field2 ...
+//
+// Evaluate all the requested thermo quantities in one pass on the last step of each run, so the driver can read
+// them at the interval boundary without one library call per field.
+// The fields use the thermo_style custom syntax:
+//  - c_ID: global scalar of a compute,
+//  - v_name: equal-style variable,
+//  - any other word: thermo keyword (step, time, etotal, pe, ...).
+// The computes are flagged for the last step of the run when the run is set up, so their values are current on that step.
+// Runs without setup (run N pre no) flag it on their first step, a one step run must call scheduleSample() before.
+// The values are also available as a global vector, f_ID[i] in Lammps.
+class FixRadahnSample : public Fix
+{
+public:
+    FixRadahnSample(class LAMMPS *lammps, int narg, char **arg);
+
+    int setmask() override;
+    void init() override;
+    void setup(int vflag) override;
+    void end_of_step() override;
+    double compute_vector(int n) override;
+
+    const std::vector<std::string>& getFields() const { return m_fields; }
+    const std::vector<double>& getValues() const { return m_values; }
+    // Check if the values have been sampled on the given step
+    bool hasSample(bigint step) const { return m_sampledStep == step; }
+    // Flag the computes for the step, the values are sampled on that step if it ends the run.
+    void scheduleSample(bigint step);
+
+protected:
+    enum class FieldType
+    {
+        KEYWORD,
+        COMPUTE,
+        VARIABLE
+    };
+
+    std::vector<std::string> m_fields;
+    std::vector<FieldType> m_types;
+    std::vector<class Compute*> m_computes;     // Per field, nullptr if not a compute
+    std::vector<int> m_variables;               // Per field, -1 if not a variable
+    std::vector<double> m_values;
+    bigint m_sampledStep = -1;
+    bigint m_scheduledStep = -1;
+
+    void sample();
+};
+
+} // LAMMPS_NS
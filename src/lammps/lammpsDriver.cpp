@@ -2,11 +2,24 @@
 #include <unordered_map>
 #include <variant>
 #include <ranges>
+#include <memory>
+#include <optional>
+#include <filesystem>
+#include <algorithm>
+
+#include <unistd.h>
 
 #include <godrick/mpi/godrickMPI.h>
 #include <conduit/conduit.hpp>
 
 #include <radahn/core/types.h>
+#include <radahn/core/positionCodec.h>
+#include <radahn/core/deltaCodec.h>
+#include <radahn/core/commandJournal.h>
+#include <radahn/core/checkpoint.h>
+#include <radahn/core/phaseTimers.h>
+#include <radahn/core/shmFrameRing.h>
+#include <radahn/core/frameLayout.h>
 #include <radahn/lmp/lammpsCommandsUtils.h>
 
 #include <lyra/lyra.hpp>
@@ -19,14 +32,24 @@ using json = nlohmann::json;
 #include "lammps.h"
 #include "input.h"
 #include "atom.h"
+#include "comm.h"
+#include "domain.h"
+#include "modify.h"
+#include "update.h"
+#include "timer.h"
+#include "universe.h"
+#include "fixRadahn.h"
+#include "fixRadahnSample.h"
 #include "library.h"
 
+#include "asyncFrameSender.h"
+
 using namespace LAMMPS_NS;
 using namespace radahn::core;
 
 struct Langevin
 {
-    std::vector<int> indices;
+    std::vector<atomIndexes_t> indices;
     std::string name;
     double startTemp;
     double endTemp;
@@ -34,6 +57,144 @@ struct Langevin
     uint64_t seed;
 };
 
+// Decimation of a per-atom field sent to the engine.
+// every = 0: never sent, every = N: sent one frame out of N
+struct FieldExport
+{
+    uint32_t every = 1;
+
+    bool isActive(uint64_t frame) const { return every > 0 && frame % every == 0; }
+};
+
+// Layout of the atoms gathered on the first rank by gatherSortedIDs, with the receive buffers of the gathers
+struct GatherLayout
+{
+    std::vector<int> counts;        // Number of atoms extracted by each rank
+    std::vector<int> displs;
+    std::vector<size_t> order;      // Position in the sorted frame of each gathered atom
+    bool dense = false;             // The gathered IDs are 1..natoms, the frame is indexed by ID - 1
+    std::vector<atomIndexes_t> gatheredIDs;
+    std::vector<int> fieldCounts;
+    std::vector<int> fieldDispls;
+    std::vector<double> gatheredField;
+};
+
+// Buffers reused from one frame to the next so that the steady state loop doesn't allocate them again
+struct FrameBuffers
+{
+    std::vector<size_t> localIndexes;
+    std::vector<atomIndexes_t> ids;
+    std::vector<atomPositions_t> positions;
+    std::vector<atomForces_t> forces;
+    std::vector<atomVelocities_t> velocities;
+    std::unordered_map<std::string, std::variant<double, int32_t> > thermos;
+    std::string thermosPhase;   // The thermo fields depend on the phase
+    uint32_t nbStaleThermos = 0;    // Reused messages which may still hold the thermo fields of the previous phase
+    // Message of the copied frames. The zero copy frames point to the Lammps memory and use their own.
+    conduit::Node message;
+    // Encoded positions and velocities given to the delta encoders, they are not part of the message
+    conduit::Node deltaSource;
+    GatherLayout gatherLayout;
+    // Results of the reductions on the ranks which don't send them
+    conduit::Node reductions;
+    // Frames written in the shared memory ring, their "simdata" is built out of the message which only describes where to find it
+    conduit::Node shmFrame;
+};
+
+// Lookup of the atoms of the reductions requested by the engine, rebuilt only when the requests change.
+// Layout of the buffer: for each request, sum of x, y, z and count, then x, y, z and found count of each tracked atom.
+struct ReductionLayout
+{
+    std::unordered_map<atomIndexes_t, std::vector<size_t>> selectionOffsets;
+    std::unordered_map<atomIndexes_t, std::vector<size_t>> trackedOffsets;
+    std::vector<size_t> requestOffsets;
+    std::vector<double> buffer;
+    std::vector<double> reduced;
+    std::vector<atomIndexes_t> foundIDs;
+    std::vector<atomPositions_t> foundPositions;
+};
+
+struct DataExportSettings
+{
+    FieldExport positions;
+    FieldExport forces;
+    FieldExport velocities;
+    bool zeroCopy = false;
+    // Gather the atoms on the first rank ordered by ID, the engine receives a single sorted chunk
+    bool gatherFrame = false;
+    uint64_t nbFramesSent = 0;
+    PositionEncoding positionEncoding = PositionEncoding::FLOAT64;
+
+    // Lossless XOR compression of the positions and velocities against the previous frame
+    bool deltaEnabled = false;
+    DeltaEncoder positionsDelta;
+    DeltaEncoder velocitiesDelta;
+
+    // Request the engine to checkpoint its state with the next frame
+    bool checkpoint = false;
+
+    // Lammps partition of this process when running an ensemble, tags the frames
+    uint32_t replica = 0;
+
+    // Region of interest: between two full frames, only the atoms selected by the engine are sent
+    bool roiEnabled = false;
+    uint32_t fullFrameEvery = 10;
+    bool roiReceived = false;
+    std::vector<uint8_t> roiMask;               // Indexed by atom ID, 1 if the atom is part of the region of interest
+    std::vector<atomIndexes_t> roiIDs;          // IDs currently set in roiMask
+
+    // Reductions over the motor selections requested by the engine. Once received, only the full frames carry atoms.
+    bool reductionsReceived = false;
+    conduit::Node reductionRequests;
+    ReductionLayout reductionLayout;
+
+    // Frames written in a shared memory ring once the engine, running on the same node, confirmed it mapped it.
+    // Until then, or if the engine runs on another node, the ring is offered with each frame sent through MPI.
+    bool shmEnabled = false;
+    bool shmAccepted = false;
+    std::string hostName;
+    std::unique_ptr<ShmFrameRing> shmRing;
+
+    FrameBuffers buffers;
+
+    // Step of the frame used by the engine to compute the commands applied during the last interval.
+    // With a command lag (more than one token on the engine to simulation communicator), it is older than the previous frame.
+    std::optional<simIt_t> commandSourceIt;
+
+    bool isFullFrame() const
+    {
+        if((!roiEnabled || !roiReceived) && !reductionsReceived)
+            return true;
+        return fullFrameEvery > 0 && nbFramesSent % fullFrameEvery == 0;
+    }
+
+    void updateROI(const conduit::Node& roiNode, uint64_t nbTotalAtoms)
+    {
+        // roiIDs only holds IDs within the mask, they are cleared before the mask is resized
+        for(auto id : roiIDs)
+            roiMask[id] = 0;
+        roiMask.resize(nbTotalAtoms + 1, 0);
+
+        const atomIndexes_t* ids = roiNode.value();
+        auto nbIDs = static_cast<size_t>(roiNode.dtype().number_of_elements());
+        roiIDs.clear();
+        size_t nbRejected = 0;
+        for(size_t i = 0; i < nbIDs; ++i)
+        {
+            if(ids[i] == 0 || ids[i] >= roiMask.size())
+            {
+                nbRejected++;
+                continue;
+            }
+            roiIDs.push_back(ids[i]);
+            roiMask[ids[i]] = 1;
+        }
+        if(nbRejected > 0)
+            spdlog::warn("Ignored {} atom IDs of the region of interest outside of the simulation (1 to {}).", nbRejected, nbTotalAtoms);
+        roiReceived = true;
+    }
+};
+
 std::vector<uint32_t> getAnchorsIds(json& document)
 {
     std::vector<uint32_t> ids;
@@ -52,7 +213,7 @@ std::vector<uint32_t> getAnchorsIds(json& document)
     return ids;
 }
 
-bool executeScript(LAMMPS* lps, const std::string& scriptPath, std::ofstream& commandsHistory)
+bool executeScript(LAMMPS* lps, const std::string& scriptPath, CommandJournalWriter& commandsHistory)
 {
     std::ifstream fdesc(scriptPath);
 
@@ -61,7 +222,9 @@ bool executeScript(LAMMPS* lps, const std::string& scriptPath, std::ofstream& co
     {
         // Execute the script
         lps->input->file(scriptPath.c_str());
-        commandsHistory<<fdesc.rdbuf()<<"\n";
+        std::stringstream content;
+        content<<fdesc.rdbuf();
+        commandsHistory.appendScript(content.str());
     }
     else
         return false;
@@ -108,52 +271,269 @@ SimUnits getUnitStyle(const std::string& scriptPath)
     throw std::runtime_error("Unable to find the units command.");
 }
 
-bool executeCommand(LAMMPS* lps, const std::string& cmd, std::ofstream& commandsHistory)
+// Convert the commands received from the engine into the binary actions of the fix radahn
+void buildRadahnActions(const radahn::lmp::LammpsCommandsUtils& cmdUtil, std::vector<FixRadahn::Action>& actions)
+{
+    auto copySelection = [](const std::vector<atomIndexes_t>& selection, FixRadahn::Action& action)
+    {
+        action.selection.reserve(selection.size());
+        for(auto id : selection)
+            action.selection.push_back(static_cast<tagint>(id));
+    };
+
+    for(auto & cmd : cmdUtil.getCommands())
+    {
+        FixRadahn::Action action;
+        action.origin = cmd->m_origin;
+        if(auto move = std::dynamic_pointer_cast<radahn::lmp::MoveLammpsCommand>(cmd))
+        {
+            action.type = FixRadahn::ActionType::MOVE;
+            action.params = {move->m_vx.m_value, move->m_vy.m_value, move->m_vz.m_value, 0.0, 0.0, 0.0, 0.0};
+            action.check = move->m_check;
+            action.distance = move->m_distance;
+            copySelection(move->m_selection, action);
+        }
+        else if(auto rotate = std::dynamic_pointer_cast<radahn::lmp::RotateLammpsCommand>(cmd))
+        {
+            action.type = FixRadahn::ActionType::ROTATE;
+            action.params = {rotate->m_px.m_value, rotate->m_py.m_value, rotate->m_pz.m_value, rotate->m_ax, rotate->m_ay, rotate->m_az, rotate->m_period.m_value};
+            copySelection(rotate->m_selection, action);
+        }
+        else if(auto addForce = std::dynamic_pointer_cast<radahn::lmp::AddForceLammpsCommand>(cmd))
+        {
+            action.type = FixRadahn::ActionType::FORCE;
+            action.params = {addForce->m_fx.m_value, addForce->m_fy.m_value, addForce->m_fz.m_value, 0.0, 0.0, 0.0, 0.0};
+            action.check = addForce->m_check;
+            action.distance = addForce->m_distance;
+            copySelection(addForce->m_selection, action);
+        }
+        else if(auto addTorque = std::dynamic_pointer_cast<radahn::lmp::AddTorqueLammpsCommand>(cmd))
+        {
+            action.type = FixRadahn::ActionType::TORQUE;
+            action.params = {addTorque->m_tx.m_value, addTorque->m_ty.m_value, addTorque->m_tz.m_value, 0.0, 0.0, 0.0, 0.0};
+            copySelection(addTorque->m_selection, action);
+        }
+        else
+        {
+            // Wait commands don't have any action
+            continue;
+        }
+        actions.push_back(std::move(action));
+    }
+}
+
+bool executeCommand(LAMMPS* lps, const std::string& cmd, CommandJournalWriter& commandsHistory)
 {
     lps->input->one(cmd);
-    commandsHistory<<cmd<<"\n";
+    commandsHistory.appendCommand(cmd);
     return true;
 }
 
+// Create a fix radahn/sample evaluating the thermo fields at the end of each run
+FixRadahnSample* createThermoSampler(LAMMPS* lps, const std::string& fixName, const std::vector<std::string>& thermoFields, CommandJournalWriter& journal)
+{
+    std::stringstream cmdFixSample;
+    cmdFixSample<<"fix "<<fixName<<" all radahn/sample";
+    for(auto & field : thermoFields)
+        cmdFixSample<<" "<<field;
+    executeCommand(lps, cmdFixSample.str(), journal);
+
+    auto sampler = dynamic_cast<FixRadahnSample*>(lps->modify->get_fix_by_id(fixName));
+    if(sampler == nullptr)
+    {
+        spdlog::critical("Unable to retrieve the fix radahn/sample {} after its creation. Abording.", fixName);
+        exit(-1);
+    }
+    return sampler;
+}
+
+// Run the next interval. Without setup, Lammps continues from the state of the previous run ("pre no") and doesn't print
+// the run summary ("post no"): the system is not initialized again (no init() of the fixes, neighbor lists or force field).
+// This doesn't skip the setup() of the fixes, which may still be called on the step where the previous run ended.
+// FixRadahn and FixRadahnSample only redo what changed when that happens.
+// The caller must only skip the setup when no command changing the system (fix, group, compute, ...) was executed since the previous run.
+void runInterval(LAMMPS* lps, uint64_t steps, bool setup, FixRadahnSample* sampler, CommandJournalWriter& journal)
+{
+    if(setup)
+    {
+        executeCommand(lps, "run " + std::to_string(steps), journal);
+        return;
+    }
+
+    // The fixes may not be set up, the sampler can't flag the last step of the run by itself for a one step run
+    if(sampler != nullptr)
+        sampler->scheduleSample(lps->update->ntimestep + static_cast<bigint>(steps));
+    executeCommand(lps, "run " + std::to_string(steps) + " pre no post no", journal);
+}
+
 void extractAtomInformation(
     LAMMPS* lps,
+    const DataExportSettings& exportSettings,
     std::vector<atomIndexes_t>& ids,
     std::vector<atomPositions_t>& pos,
     std::vector<atomForces_t>& forces,
     std::vector<atomVelocities_t>& vel,
-    std::vector<std::string>& thermoFieldsRequested,
-    std::unordered_map<std::string, std::variant<double, int32_t> >& thermo
+    std::vector<size_t>& localIndexes
     )
 {
+    // Selecting the local atoms to send, either all of them or only the ones in the region of interest
+    uint64_t localSize = static_cast<uint64_t>(lps->atom->nlocal);
+    int* id = static_cast<int*>(lps->atom->extract("id"));
+    localIndexes.clear();
+    bool fullFrame = exportSettings.isFullFrame();
+    for(size_t i = 0; i < localSize; ++i)
+    {
+        auto tag = static_cast<size_t>(id[i]);
+        if(fullFrame || (tag < exportSettings.roiMask.size() && exportSettings.roiMask[tag] > 0))
+            localIndexes.push_back(i);
+    }
+
     // Allocating the buffers according to the local proc
+    size_t nbSelected = localIndexes.size();
+    spdlog::info("Extracting {} atoms out of {}.", nbSelected, localSize);
+    ids.resize(nbSelected);
+    for(size_t i = 0; i < nbSelected; ++i)
+        ids[i] = static_cast<atomIndexes_t>(id[localIndexes[i]]);
+
+    // Only the fields requested for this frame are extracted
+    auto copyField = [&localIndexes, nbSelected](double** src, std::vector<double>& dest)
+    {
+        dest.resize(nbSelected * 3);
+        for(size_t i = 0; i < nbSelected; ++i)
+        {
+            auto j = localIndexes[i];
+            dest[3*i] = src[j][0];
+            dest[3*i+1] = src[j][1];
+            dest[3*i+2] = src[j][2];
+        }
+    };
+
+    if(exportSettings.positions.isActive(exportSettings.nbFramesSent))
+        copyField(static_cast<double**>(lps->atom->extract("x")), pos);
+    if(exportSettings.forces.isActive(exportSettings.nbFramesSent))
+        copyField(static_cast<double**>(lps->atom->extract("f")), forces);
+    if(exportSettings.velocities.isActive(exportSettings.nbFramesSent))
+        copyField(static_cast<double**>(lps->atom->extract("v")), vel);
+}
+
+// Gather the extracted IDs on the first rank and sort them. The other ranks end up with an empty list.
+// Collective call, must be followed by gatherSortedField for each extracted field.
+void gatherSortedIDs(MPI_Comm comm, std::vector<atomIndexes_t>& ids, GatherLayout& layout)
+{
+    int rank = 0;
+    int nbRanks = 0;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nbRanks);
+
+    int localCount = static_cast<int>(ids.size());
+    layout.counts.assign(static_cast<size_t>(nbRanks), 0);
+    MPI_Gather(&localCount, 1, MPI_INT, layout.counts.data(), 1, MPI_INT, 0, comm);
+
+    layout.displs.assign(static_cast<size_t>(nbRanks), 0);
+    size_t total = 0;
+    for(size_t r = 0; r < layout.counts.size(); ++r)
+    {
+        layout.displs[r] = static_cast<int>(total);
+        total += static_cast<size_t>(layout.counts[r]);
+    }
+
+    auto & gathered = layout.gatheredIDs;
+    gathered.resize(rank == 0 ? total : 0);
+    MPI_Gatherv(ids.data(), localCount, MPI_UINT32_T, gathered.data(), layout.counts.data(), layout.displs.data(), MPI_UINT32_T, 0, comm);
+
+    ids.clear();
+    layout.order.clear();
+    layout.dense = false;
+    if(rank != 0)
+        return;
+
+    // Full frames contain the IDs 1..natoms and are placed directly, partial frames are sorted
+    layout.dense = computeSortedOrder(gathered.data(), total, layout.order);
+
+    ids.resize(total);
+    for(size_t i = 0; i < total; ++i)
+        ids[layout.order[i]] = gathered[i];
+}
+
+// Gather a per atom field with 3 components in the order computed by gatherSortedIDs
+void gatherSortedField(MPI_Comm comm, GatherLayout& layout, std::vector<double>& field)
+{
+    int rank = 0;
+    MPI_Comm_rank(comm, &rank);
+
+    auto & counts = layout.fieldCounts;
+    auto & displs = layout.fieldDispls;
+    counts.resize(layout.counts.size());
+    displs.resize(layout.displs.size());
+    for(size_t r = 0; r < counts.size(); ++r)
+    {
+        counts[r] = 3*layout.counts[r];
+        displs[r] = 3*layout.displs[r];
+    }
+
+    auto & gathered = layout.gatheredField;
+    gathered.resize(rank == 0 ? 3*layout.order.size() : 0);
+    MPI_Gatherv(field.data(), static_cast<int>(field.size()), MPI_DOUBLE, gathered.data(), counts.data(), displs.data(), MPI_DOUBLE, 0, comm);
+
+    field.resize(gathered.size());
+    for(size_t i = 0; i < layout.order.size(); ++i)
+    {
+        auto j = layout.order[i];
+        field[3*j] = gathered[3*i];
+        field[3*j+1] = gathered[3*i+1];
+        field[3*j+2] = gathered[3*i+2];
+    }
+}
+
+// Zero copy version of extractAtomInformation. 
+// Lammps stores x, f and v as 2D arrays allocated in a single contiguous block (x[0] points to nmax*3 doubles), 
+// so the conduit node can point directly to the Lammps storage instead of copying the data twice.
+// LIFETIME: the external nodes are only valid until the next Lammps command is executed. Any run, group or fix command
+// can reallocate or reorder the per-atom arrays. The node must be pushed with handler.push() and discarded before
+// the Lammps instance is used again.
+// The ids are still copied because Lammps tags (tagint) don't match the type atomIndexes_t expected by the engine.
+void attachAtomInformation(
+    LAMMPS* lps,
+    const DataExportSettings& exportSettings,
+    std::vector<atomIndexes_t>& ids,
+    conduit::Node& simData
+    )
+{
     uint64_t localSize = static_cast<uint64_t>(lps->atom->nlocal);
-    spdlog::info("Extracting {} atoms.", localSize);
-    pos.resize(localSize * 3);
-    forces.resize(localSize * 3);
-    vel.resize(localSize * 3);
+    spdlog::info("Attaching {} atoms.", localSize);
     ids.resize(localSize);
 
     int* id = static_cast<int*>(lps->atom->extract("id"));
-    double** x = static_cast<double**>(lps->atom->extract("x"));
-    double** f = static_cast<double**>(lps->atom->extract("f"));
-    double** v = static_cast<double**>(lps->atom->extract("v"));
-
     for(size_t i = 0; i < localSize; ++i)
-    {
         ids[i] = static_cast<atomIndexes_t>(id[i]);
-        pos[3*i] = x[i][0];
-        pos[3*i+1] = x[i][1];
-        pos[3*i+2] = x[i][2];
-        forces[3*i] = f[i][0];
-        forces[3*i+1] = f[i][1];
-        forces[3*i+2] = f[i][2];
-        vel[3*i] = v[i][0];
-        vel[3*i+1] = v[i][1];
-        vel[3*i+2] = v[i][2];
-    }
+    simData["atomIDs"].set_external(ids.data(), static_cast<conduit::index_t>(localSize));
+
+    auto attachField = [localSize](double** src, conduit::Node& dest)
+    {
+        // Lammps may not have allocated the arrays yet if the proc doesn't own any atom
+        if(localSize > 0)
+            dest.set_external(src[0], static_cast<conduit::index_t>(localSize * 3));
+        else
+            dest = std::vector<double>();
+    };
+
+    if(exportSettings.positions.isActive(exportSettings.nbFramesSent))
+        attachField(static_cast<double**>(lps->atom->extract("x")), simData["atomPositions"]);
+    if(exportSettings.forces.isActive(exportSettings.nbFramesSent))
+        attachField(static_cast<double**>(lps->atom->extract("f")), simData["atomForces"]);
+    if(exportSettings.velocities.isActive(exportSettings.nbFramesSent))
+        attachField(static_cast<double**>(lps->atom->extract("v")), simData["atomVelocities"]);
+}
 
+void extractThermoInformation(
+    LAMMPS* lps,
+    std::vector<std::string>& thermoFieldsRequested,
+    const FixRadahnSample* sampler,
+    std::unordered_map<std::string, std::variant<double, int32_t> >& thermo
+    )
+{
     int32_t* simIt32 = static_cast<int32_t*>(lammps_extract_global(lps, "ntimestep"));
-    thermo.insert({"simIt", static_cast<int32_t>(simIt32[0])});
+    thermo.insert_or_assign("simIt", static_cast<int32_t>(simIt32[0]));
 
 
     /*double temp = lammps_get_thermo(lps, "temp");
@@ -169,10 +549,20 @@ void extractAtomInformation(
     thermo.insert({"kin", kin});*/
 
     double* dt = static_cast<double*>(lammps_extract_global(lps, "dt"));
-    thermo.insert({"dt", dt[0]});
+    thermo.insert_or_assign("dt", dt[0]);
 
     double* sim_t = static_cast<double*>(lammps_extract_global(lps, "atime"));
-    thermo.insert({"sim_t", sim_t[0]});
+    thermo.insert_or_assign("sim_t", sim_t[0]);
+
+    // The sampling fix evaluated all the fields on the last step of the run
+    if(sampler != nullptr && sampler->hasSample(lps->update->ntimestep))
+    {
+        auto & fields = sampler->getFields();
+        auto & values = sampler->getValues();
+        for(size_t i = 0; i < fields.size(); ++i)
+            thermo.insert_or_assign(fields[i], values[i]);
+        return;
+    }
 
     for(auto & field : thermoFieldsRequested)
     {
@@ -182,7 +572,7 @@ void extractAtomInformation(
             double* dptr = static_cast<double*>(lammps_extract_variable(lps, varName.c_str(), NULL));
             if(dptr)
             {
-                thermo.insert({field, *dptr});
+                thermo.insert_or_assign(field, *dptr);
                 lammps_free(dptr);
             }
             else 
@@ -196,7 +586,7 @@ void extractAtomInformation(
             double* dptr = static_cast<double*>(lammps_extract_compute(lps, varName.c_str(), LMP_STYLE_GLOBAL, LMP_TYPE_SCALAR));
             if(dptr)
             {
-                thermo.insert({field, *dptr});
+                thermo.insert_or_assign(field, *dptr);
             }
             else 
             {
@@ -206,34 +596,448 @@ void extractAtomInformation(
         else
         {
             double data = lammps_get_thermo(lps, field.c_str());
-            thermo.insert({field, data});
+            thermo.insert_or_assign(field, data);
         }
     }
    
 }
 
-void sendLammpsData(LAMMPS* lps, uint8_t simUnitValue, godrick::mpi::GodrickMPI& handler, const std::string& phase, std::vector<std::string>& thermoFields)
+void buildReductionLayout(const conduit::Node& requests, ReductionLayout& layout)
+{
+    layout.selectionOffsets.clear();
+    layout.trackedOffsets.clear();
+    layout.requestOffsets.clear();
+    size_t bufferSize = 0;
+    for(conduit::index_t r = 0; r < requests.number_of_children(); ++r)
+    {
+        auto & request = requests.child(r);
+        layout.requestOffsets.push_back(bufferSize);
+
+        const atomIndexes_t* ids = request["ids"].value();
+        auto nbIDs = static_cast<size_t>(request["ids"].dtype().number_of_elements());
+        for(size_t i = 0; i < nbIDs; ++i)
+            layout.selectionOffsets[ids[i]].push_back(bufferSize);
+        bufferSize += 4;
+
+        if(request.has_child("tracked"))
+        {
+            const atomIndexes_t* tracked = request["tracked"].value();
+            auto nbTracked = static_cast<size_t>(request["tracked"].dtype().number_of_elements());
+            for(size_t i = 0; i < nbTracked; ++i)
+                layout.trackedOffsets[tracked[i]].push_back(bufferSize + 4*i);
+            bufferSize += 4*nbTracked;
+        }
+    }
+    layout.buffer.resize(bufferSize);
+    layout.reduced.resize(bufferSize);
+}
+
+// Evaluate the reductions requested by the engine over the local atoms of all the ranks: number of atoms found and
+// geometric center of each selection, positions of the tracked atoms. All the requests are combined in a single MPI_Allreduce
+// so the engine receives a few doubles per motor instead of the atoms. Collective call, all the ranks get the results.
+// The tracked atoms owned by no rank are reported and left out of the results.
+void evaluateReductions(LAMMPS* lps, const conduit::Node& requests, ReductionLayout& layout, conduit::Node& results)
+{
+    auto & buffer = layout.buffer;
+    std::fill(buffer.begin(), buffer.end(), 0.0);
+    auto nlocal = static_cast<size_t>(lps->atom->nlocal);
+    int* id = static_cast<int*>(lps->atom->extract("id"));
+    double** x = static_cast<double**>(lps->atom->extract("x"));
+    for(size_t i = 0; i < nlocal; ++i)
+    {
+        auto tag = static_cast<atomIndexes_t>(id[i]);
+        auto selection = layout.selectionOffsets.find(tag);
+        if(selection != layout.selectionOffsets.end())
+        {
+            for(auto offset : selection->second)
+            {
+                buffer[offset] += x[i][0];
+                buffer[offset+1] += x[i][1];
+                buffer[offset+2] += x[i][2];
+                buffer[offset+3] += 1.0;
+            }
+        }
+        auto tracked = layout.trackedOffsets.find(tag);
+        if(tracked != layout.trackedOffsets.end())
+        {
+            for(auto offset : tracked->second)
+            {
+                buffer[offset] = x[i][0];
+                buffer[offset+1] = x[i][1];
+                buffer[offset+2] = x[i][2];
+                buffer[offset+3] = 1.0;
+            }
+        }
+    }
+    auto & reduced = layout.reduced;
+    MPI_Allreduce(buffer.data(), reduced.data(), static_cast<int>(buffer.size()), MPI_DOUBLE, MPI_SUM, lps->world);
+
+    // The results of the previous frame are rewritten in place while the same motors send requests
+    bool sameMotors = results.dtype().is_object() && results.number_of_children() == requests.number_of_children();
+    for(conduit::index_t r = 0; sameMotors && r < requests.number_of_children(); ++r)
+        sameMotors = results.child_names()[static_cast<size_t>(r)] == requests.child_names()[static_cast<size_t>(r)];
+    if(!sameMotors)
+        results.set(conduit::DataType::object());
+    for(conduit::index_t r = 0; r < requests.number_of_children(); ++r)
+    {
+        auto & request = requests.child(r);
+        auto & result = results.add_child(requests.child_names()[static_cast<size_t>(r)]);
+        auto offset = layout.requestOffsets[static_cast<size_t>(r)];
+        double count = reduced[offset+3];
+        std::array<double, 3> center = {0.0, 0.0, 0.0};
+        if(count > 0.0)
+            center = {reduced[offset] / count, reduced[offset+1] / count, reduced[offset+2] / count};
+        result["count"] = static_cast<uint64_t>(count);
+        result["center"].set(center.data(), 3);
+
+        if(request.has_child("tracked"))
+        {
+            const atomIndexes_t* tracked = request["tracked"].value();
+            auto nbTracked = static_cast<size_t>(request["tracked"].dtype().number_of_elements());
+            auto & foundIDs = layout.foundIDs;
+            auto & foundPositions = layout.foundPositions;
+            foundIDs.clear();
+            foundPositions.clear();
+            for(size_t i = 0; i < nbTracked; ++i)
+            {
+                const double* trackedValues = &reduced[offset + 4 + 4*i];
+                if(trackedValues[3] > 0.0)
+                {
+                    foundIDs.push_back(tracked[i]);
+                    foundPositions.insert(foundPositions.end(), trackedValues, trackedValues + 3);
+                }
+                else if(lps->comm->me == 0)
+                    spdlog::warn("The atom {} tracked by {} is not part of the simulation, its position is not sent.", tracked[i], request.name());
+            }
+            result["trackedIDs"] = foundIDs;
+            result.add_child("trackedPositions") = foundPositions;
+        }
+        else if(result.has_child("trackedIDs"))
+        {
+            result.remove("trackedIDs");
+            result.remove("trackedPositions");
+        }
+    }
+}
+
+// Save the atom positions, velocities and image flags with the step and the driver counters.
+// Lammps restart files don't contain the fixes and computes, they are rebuilt from the configuration when resuming.
+// The atoms are written by a journaled write_dump in <checkpoint>.dump, Lammps gathers them on the rank 0 which writes the file.
+// The checkpoint file with the counters is written last, it marks the checkpoint as complete. Collective call.
+void writeCheckpoint(LAMMPS* lps, int rank, const std::string& folder, const std::string& prefix, uint64_t nveStep, uint64_t nbFramesSent, CommandJournalWriter& journal)
+{
+    auto step = static_cast<simIt_t>(lps->update->ntimestep);
+    auto path = getCheckpointPath(folder, prefix, step);
+    if(rank == 0)
+        std::filesystem::create_directories(folder);
+
+    // Full precision so that the resumed trajectory starts from the same state
+    executeCommand(lps, "write_dump all custom " + path + ".dump id x y z vx vy vz ix iy iz modify sort id format float %.17g", journal);
+
+    if(rank != 0)
+        return;
+
+    conduit::Node state;
+    state["step"] = static_cast<uint64_t>(lps->update->ntimestep);
+    state["time"] = lps->update->atime + static_cast<double>(lps->update->ntimestep - lps->update->atimestep) * lps->update->dt;
+    state["natoms"] = static_cast<uint64_t>(lps->atom->natoms);
+    state["nveStep"] = nveStep;
+    state["nbFramesSent"] = nbFramesSent;
+
+    state.save(path, "conduit_bin");
+    pruneCheckpoints(folder, prefix, 2);
+    spdlog::info("Checkpoint written for the step {}.", step);
+}
+
+// Restore the atoms saved by writeCheckpoint and move Lammps to the checkpoint step
+bool readCheckpoint(LAMMPS* lps, const std::string& path, uint64_t& nveStep, uint64_t& nbFramesSent, CommandJournalWriter& journal)
+{
+    conduit::Node state;
+    state.load(path, "conduit_bin");
+
+    auto natoms = static_cast<uint64_t>(lps->atom->natoms);
+    if(!state.has_child("natoms") || state["natoms"].to_uint64() != natoms)
+    {
+        spdlog::error("The checkpoint {} doesn't match the {} atoms of the simulation.", path, natoms);
+        return false;
+    }
+
+    // Journaled as well, the replay of the session restores the same atoms
+    std::stringstream cmdReadDump;
+    cmdReadDump<<"read_dump "<<path<<".dump "<<state["step"].to_uint64()<<" x y z vx vy vz ix iy iz replace yes";
+    executeCommand(lps, cmdReadDump.str(), journal);
+
+    std::stringstream cmdResetTimestep;
+    cmdResetTimestep<<"reset_timestep "<<state["step"].to_uint64()<<" time "<<state["time"].to_float64();
+    executeCommand(lps, cmdResetTimestep.str(), journal);
+
+    nveStep = state["nveStep"].to_uint64();
+    nbFramesSent = state["nbFramesSent"].to_uint64();
+    return true;
+}
+
+// Breakdown of the last run from the Lammps timers (s), averaged over the ranks like the Lammps summary. Collective call.
+void extractLammpsTimers(LAMMPS* lps, conduit::Node& thermosData)
+{
+    const std::array<std::pair<Timer::ttype, const char*>, 7> categories = {{
+        {Timer::PAIR, "lmp_pair"}, {Timer::BOND, "lmp_bond"}, {Timer::KSPACE, "lmp_kspace"}, {Timer::NEIGH, "lmp_neigh"},
+        {Timer::COMM, "lmp_comm"}, {Timer::MODIFY, "lmp_modify"}, {Timer::OUTPUT, "lmp_output"}
+    }};
+
+    std::array<double, 7> local;
+    for(size_t i = 0; i < categories.size(); ++i)
+        local[i] = lps->timer->get_wall(categories[i].first);
+
+    std::array<double, 7> sum;
+    MPI_Allreduce(local.data(), sum.data(), static_cast<int>(local.size()), MPI_DOUBLE, MPI_SUM, lps->world);
+
+    int nbRanks = 1;
+    MPI_Comm_size(lps->world, &nbRanks);
+    for(size_t i = 0; i < categories.size(); ++i)
+        thermosData[categories[i].second] = sum[i] / nbRanks;
+}
+
+// Remove from a reused message the optional fields of the previous frame which are not part of the next one.
+// The fields present in both frames are kept and rewritten in place.
+void removeStaleFields(conduit::Node& rootMsg, const DataExportSettings& exportSettings, bool fullFrame, bool firstRank)
+{
+    // The offer and the description of the shared memory frame are rewritten at every frame while they are sent
+    static const std::string shmKey = "shm";
+    static const std::string shmOfferKey = "shmOffer";
+    if(!exportSettings.shmAccepted && rootMsg.has_child(shmKey))
+        rootMsg.remove(shmKey);
+    if((exportSettings.shmAccepted || !exportSettings.shmEnabled) && rootMsg.has_child(shmOfferKey))
+        rootMsg.remove(shmOfferKey);
+    if(!rootMsg.has_child("simdata"))
+        return;
+
+    auto frame = exportSettings.nbFramesSent;
+    bool positions = exportSettings.positions.isActive(frame);
+    bool velocities = exportSettings.velocities.isActive(frame);
+    bool delta = exportSettings.deltaEnabled;
+    static const std::array<std::string, 11> fields = {
+        "atomPositions", "atomPositionsDelta", "positionEncoding", "positionScale", "positionOffset",
+        "atomForces", "atomVelocities", "atomVelocitiesDelta", "sorted", "reductions", "checkpoint"};
+    const std::array<bool, 11> present = {
+        positions && !delta, positions && delta, positions, 
+        positions && exportSettings.positionEncoding == PositionEncoding::FIXED16, positions && exportSettings.positionEncoding == PositionEncoding::FIXED16,
+        exportSettings.forces.isActive(frame), velocities && !delta, velocities && delta,
+        exportSettings.gatherFrame && fullFrame && firstRank, exportSettings.reductionsReceived && firstRank, exportSettings.checkpoint};
+
+    auto & simData = rootMsg["simdata"];
+    for(size_t i = 0; i < fields.size(); ++i)
+    {
+        if(!present[i] && simData.has_child(fields[i]))
+            simData.remove(fields[i]);
+    }
+}
+
+// Number of frames the driver can write in the ring before the engine releases the oldest one.
+// The commands of a frame are needed to run the next intervals, this is enough for a command lag up to 6
+// (checked by the workflow with --shm, see workflow/lammpsSteered.py).
+constexpr uint32_t shmRingSlots = 8;
+
+// Move the frame to the shared memory ring, the message only describes where to find it.
+// Until the engine maps the ring, simData is the "simdata" of the message and the ring is offered with it.
+void writeFrameToSharedMemory(LAMMPS* lps, DataExportSettings& exportSettings, conduit::Node& rootMsg, const conduit::Node& simData)
+{
+    if(!exportSettings.shmRing)
+    {
+        // Slots sized for the first frame, with a margin for the atoms migrating between the ranks
+        auto slotSize = std::max<uint64_t>(2 * static_cast<uint64_t>(simData.total_bytes_compact()), 1 << 20);
+        auto name = "/radahn_" + std::to_string(getpid()) + "_" + std::to_string(lps->comm->me);
+        exportSettings.shmRing = ShmFrameRing::create(name, shmRingSlots, slotSize);
+        if(!exportSettings.shmRing)
+        {
+            spdlog::warn("Unable to create the shared memory ring, the frames are sent through MPI.");
+            exportSettings.shmEnabled = false;
+            return;
+        }
+    }
+
+    if(!exportSettings.shmAccepted)
+    {
+        rootMsg["shmOffer"]["name"] = exportSettings.shmRing->getName();
+        rootMsg["shmOffer"]["host"] = exportSettings.hostName;
+        return;
+    }
+
+    uint64_t seq = 0;
+    std::string schema;
+    auto status = exportSettings.shmRing->write(simData, seq, schema);
+    if(status == ShmFrameRing::WriteStatus::TOO_LARGE)
+    {
+        spdlog::warn("The frame exceeds the {} bytes of the shared memory slots, sending it through MPI.", exportSettings.shmRing->getSlotSize());
+        if(rootMsg.has_child("shm"))
+            rootMsg.remove("shm");
+        rootMsg["simdata"].set(simData);
+        return;
+    }
+    if(status == ShmFrameRing::WriteStatus::READER_GONE)
+    {
+        spdlog::critical("The engine stopped reading the shared memory ring. Abording.");
+        exit(-1);
+    }
+    rootMsg["shm"]["name"] = exportSettings.shmRing->getName();
+    rootMsg["shm"]["seq"] = seq;
+    rootMsg["shm"]["schema"] = schema;
+}
+
+// The engine lists the rings it mapped in its answers
+void checkSharedMemoryAccepted(const conduit::Node& msg, DataExportSettings& exportSettings)
+{
+    if(!exportSettings.shmRing || exportSettings.shmAccepted || !msg.has_child("shmAccepted"))
+        return;
+
+    for(conduit::index_t i = 0; i < msg["shmAccepted"].number_of_children(); ++i)
+    {
+        if(msg["shmAccepted"].child(i).as_string() == exportSettings.shmRing->getName())
+        {
+            spdlog::info("The engine reads the frames from the shared memory ring {}.", exportSettings.shmRing->getName());
+            exportSettings.shmAccepted = true;
+            exportSettings.shmRing->unlink();
+        }
+    }
+}
+
+// The timers of the driver phases measured since the previous frame are added to the thermos as time_<phase>,
+// then restarted. The push of a frame is reported with the next one.
+// When a sender is given, the message is built in one of its staging buffers and pushed by its thread.
+void sendLammpsData(LAMMPS* lps, uint8_t simUnitValue, godrick::mpi::GodrickMPI& handler, const std::string& phase, std::vector<std::string>& thermoFields, const FixRadahnSample* sampler, DataExportSettings& exportSettings, PhaseTimers& timers, AsyncFrameSender* sender)
 {
+    timers.start("extract");
     double simItD = lammps_get_thermo(lps, "step");
     simIt_t simIt = static_cast<simIt_t>(simItD);
 
-    // Extracting atom information
-    std::vector<atomIndexes_t> ids;
-    std::vector<atomPositions_t> pos;
-    std::vector<atomForces_t> forces;
-    std::vector<atomVelocities_t> vel;
-    std::unordered_map<std::string, std::variant<double, int32_t> > thermos;
-    extractAtomInformation(lps, ids, pos, forces, vel, thermoFields, thermos);
+    // The zero copy path can only send the complete local arrays with their native precision, 
+    // partial frames and encoded positions are always copied.
+    // Lammps keeps running while the asynchronous sender pushes the message, it can't reference the Lammps memory either.
+    bool fullFrame = exportSettings.isFullFrame();
+    bool zeroCopy = exportSettings.zeroCopy && !exportSettings.gatherFrame && sender == nullptr && fullFrame && exportSettings.positionEncoding == PositionEncoding::FLOAT64 && !exportSettings.deltaEnabled;
+
+    // The messages of the copied frames are reused, their values are rewritten in place
+    std::optional<conduit::Node> zeroCopyMsg;
+    conduit::Node& rootMsg = sender != nullptr ? sender->acquireBuffer() : (zeroCopy ? zeroCopyMsg.emplace() : exportSettings.buffers.message);
+    removeStaleFields(rootMsg, exportSettings, fullFrame, lps->comm->me == 0);
 
-    conduit::Node rootMsg;
-    conduit::Node& simData = rootMsg.add_child("simdata");
+    // Once the engine maps the shared memory ring, the frame is built out of the message and kept between two frames as well
+    bool shmFrame = exportSettings.shmEnabled && exportSettings.shmAccepted;
+    if(shmFrame)
+    {
+        if(rootMsg.has_child("simdata"))
+            rootMsg.remove("simdata");
+        removeStaleFields(exportSettings.buffers.shmFrame, exportSettings, fullFrame, lps->comm->me == 0);
+    }
+    conduit::Node& simData = (shmFrame ? exportSettings.buffers.shmFrame : rootMsg).add_child("simdata");
     simData["simIt"] = simIt;
-    simData["atomIDs"] = ids;
-    simData["atomPositions"] = pos;
-    simData["atomForces"] = forces;
-    simData["atomVelocities"] = vel;
+
+    // Extracting atom information
+    // Only the fields active for this frame are added to the message. The receiver should check with has_child.
+    auto & ids = exportSettings.buffers.ids;
+    auto & pos = exportSettings.buffers.positions;
+    auto & forces = exportSettings.buffers.forces;
+    auto & vel = exportSettings.buffers.velocities;
+    if(zeroCopy)
+    {
+        // The node points to the Lammps memory, rootMsg must not be used after the push
+        attachAtomInformation(lps, exportSettings, ids, simData);
+    }
+    else
+    {
+        extractAtomInformation(lps, exportSettings, ids, pos, forces, vel, exportSettings.buffers.localIndexes);
+        if(exportSettings.gatherFrame)
+        {
+            // The other ranks send their message without atoms to complete the gather with the engine
+            auto & layout = exportSettings.buffers.gatherLayout;
+            gatherSortedIDs(lps->world, ids, layout);
+            if(exportSettings.positions.isActive(exportSettings.nbFramesSent))
+                gatherSortedField(lps->world, layout, pos);
+            if(exportSettings.forces.isActive(exportSettings.nbFramesSent))
+                gatherSortedField(lps->world, layout, forces);
+            if(exportSettings.velocities.isActive(exportSettings.nbFramesSent))
+                gatherSortedField(lps->world, layout, vel);
+
+            // Only a frame with the atoms 1..natoms is indexed by ID, the IDs may have gaps (deleted atoms)
+            if(fullFrame && layout.dense)
+                simData["sorted"] = static_cast<uint8_t>(1);
+            else if(simData.has_child("sorted"))
+                simData.remove("sorted");
+        }
+        simData["atomIDs"] = ids;
+        if(exportSettings.positions.isActive(exportSettings.nbFramesSent))
+        {
+            // With the delta compression, the encoded positions stay out of the message, only their encoding settings are sent
+            auto & deltaSource = exportSettings.buffers.deltaSource;
+            auto & encoded = exportSettings.deltaEnabled ? deltaSource : simData;
+            auto nbClamped = encodePositions(exportSettings.positionEncoding, pos.data(), ids.size(), lps->domain->boxlo, lps->domain->boxhi, encoded);
+            if(nbClamped > 0)
+                spdlog::warn("{} coordinates were outside of the simulation box and have been clamped by the {} encoding.", nbClamped, to_string(exportSettings.positionEncoding));
+
+            if(exportSettings.deltaEnabled)
+            {
+                exportSettings.positionsDelta.encode(ids.data(), ids.size(), deltaSource["atomPositions"], simData.add_child("atomPositionsDelta"));
+                simData.add_child("positionEncoding") = deltaSource.child("positionEncoding").as_uint8();
+                if(exportSettings.positionEncoding == PositionEncoding::FIXED16)
+                {
+                    simData["positionScale"].set(deltaSource["positionScale"].as_float64_ptr(), 3);
+                    simData["positionOffset"].set(deltaSource["positionOffset"].as_float64_ptr(), 3);
+                }
+            }
+        }
+        if(exportSettings.forces.isActive(exportSettings.nbFramesSent))
+            simData["atomForces"] = forces;
+        if(exportSettings.velocities.isActive(exportSettings.nbFramesSent))
+        {
+            if(exportSettings.deltaEnabled)
+            {
+                auto & velNode = exportSettings.buffers.deltaSource["atomVelocities"];
+                velNode.set_external(vel.data(), static_cast<conduit::index_t>(vel.size()));
+                exportSettings.velocitiesDelta.encode(ids.data(), ids.size(), velNode, simData.add_child("atomVelocitiesDelta"));
+            }
+            else
+                simData["atomVelocities"] = vel;
+        }
+    }
     simData["units"] = simUnitValue;
     simData["phase"] = std::string(phase); // NVT/NVE
+    simData["fullFrame"] = static_cast<uint8_t>(fullFrame ? 1 : 0);
+    simData["replica"] = exportSettings.replica;
+
+    // The results are identical on all the ranks, only the first one sends them
+    if(exportSettings.reductionsReceived)
+    {
+        auto & reductions = lps->comm->me == 0 ? simData["reductions"] : exportSettings.buffers.reductions;
+        evaluateReductions(lps, exportSettings.reductionRequests, exportSettings.reductionLayout, reductions);
+    }
+    if(exportSettings.checkpoint)
+    {
+        simData["checkpoint"] = static_cast<uint8_t>(1);
+        exportSettings.checkpoint = false;
+    }
+
+    // The thermos stay in the message, they are copied by the engine in the KVS
+    if(exportSettings.shmEnabled)
+        writeFrameToSharedMemory(lps, exportSettings, rootMsg, simData);
+
+    timers.stop("extract");
+
+    timers.start("thermo");
+    // The thermo fields of the previous phase are not sent anymore. The phase of the message can't be checked
+    // when its frame was written in shared memory, the two staging buffers of the asynchronous sender are cleared instead.
+    auto & thermos = exportSettings.buffers.thermos;
+    if(exportSettings.buffers.thermosPhase != phase)
+    {
+        thermos.clear();
+        exportSettings.buffers.thermosPhase = phase;
+        exportSettings.buffers.nbStaleThermos = 2;
+    }
+    if(exportSettings.buffers.nbStaleThermos > 0)
+    {
+        if(rootMsg.has_child("thermos"))
+            rootMsg.remove("thermos");
+        exportSettings.buffers.nbStaleThermos--;
+    }
+    extractThermoInformation(lps, thermoFields, sampler, thermos);
 
     conduit::Node& thermosData = rootMsg.add_child("thermos");
     for(auto & t : thermos)
@@ -243,7 +1047,29 @@ void sendLammpsData(LAMMPS* lps, uint8_t simUnitValue, godrick::mpi::GodrickMPI&
         else
             thermosData[t.first] = std::get<int32_t>(t.second);
     }
-    handler.push("atoms", rootMsg, true);
+    extractLammpsTimers(lps, thermosData);
+    if(exportSettings.commandSourceIt)
+        thermosData["cmd_source_it"] = *exportSettings.commandSourceIt;
+    timers.stop("thermo");
+
+    timers.exportTo(thermosData, "time_");
+    timers.clear();
+
+    timers.start("send");
+    if(sender != nullptr)
+        sender->submit();
+    else
+        handler.push("atoms", rootMsg, true);
+    timers.stop("send");
+    exportSettings.nbFramesSent++;
+}
+
+// The messages of the engine are received by the thread of the sender when the frames are sent asynchronously
+godrick::MessageResponse receiveFromEngine(godrick::mpi::GodrickMPI& handler, AsyncFrameSender* sender, std::vector<conduit::Node>& receivedData)
+{
+    if(sender != nullptr)
+        return sender->receive(receivedData);
+    return handler.get("in", receivedData);
 }
 
 int main(int argc, char** argv)
@@ -256,6 +1082,9 @@ int main(int argc, char** argv)
     std::string lmpInitialState;
     std::string lmpConfigFile;
     uint32_t intervalSteps = 100;
+    // Bounds of the NVE interval length suggested by the motor engine, 0 to use intervalSteps
+    uint32_t minIntervalSteps = 0;
+    uint32_t maxIntervalSteps = 0;
     uint64_t currentStep = 0;
     std::string ffType = "";
 
@@ -277,6 +1106,32 @@ int main(int argc, char** argv)
     // NVE
     uint64_t maxNVESteps  = 1000;
     std::vector<Langevin> thermostats;
+
+    // Data export
+    DataExportSettings exportSettings;
+
+    // Motors applied through the fix radahn instead of Lammps commands
+    bool useFixRadahn = false;
+    const std::string fixRadahnName = "radahnMotors";
+
+    // Push the frames and receive the commands from a dedicated thread, overlapped with the next interval
+    bool asyncSend = false;
+
+    // Skip the Lammps setup of the intervals when nothing changed since the previous one
+    bool persistentRun = false;
+
+    // Send the frames through shared memory when the engine runs on the same node
+    bool useSharedMemory = false;
+
+    std::string journalPath = "full.journal.radahn";
+
+    // Checkpoints
+    uint32_t checkpointEvery = 0;
+    std::string checkpointFolder = "checkpoint";
+    bool resume = false;
+
+    // Ensemble of independent copies of the system, one per Lammps partition
+    uint32_t nbReplicas = 1;
     
 
     auto cli = lyra::cli()
@@ -295,9 +1150,48 @@ int main(int argc, char** argv)
         | lyra::opt( intervalSteps, "interalsteps")
             ["--intervalsteps"]
             ("Number of steps to run between checking the inputs.")
+        | lyra::opt( minIntervalSteps, "minintervalsteps")
+            ["--minintervalsteps"]
+            ("Minimum number of steps of an NVE interval when following the interval length suggested by the motor engine. Default to intervalsteps.")
+        | lyra::opt( maxIntervalSteps, "maxintervalsteps")
+            ["--maxintervalsteps"]
+            ("Maximum number of steps of an NVE interval when following the interval length suggested by the motor engine. Default to intervalsteps.")
         | lyra::opt( lmpConfigFile, "lmpconfig")
             ["--lmpconfig"]
             ("Path to the configuration file for Lammps.")
+        | lyra::opt( exportSettings.zeroCopy)
+            ["--zerocopy"]
+            ("Send the atom positions, forces and velocities directly from the Lammps memory instead of copying them first.")
+        | lyra::opt( exportSettings.gatherFrame)
+            ["--gatherframe"]
+            ("Gather the atoms on the first rank ordered by ID before sending them, the engine receives a single sorted frame. Disables --zerocopy.")
+        | lyra::opt( useFixRadahn)
+            ["--fixradahn"]
+            ("Apply the motors and the time integration with the fix radahn, evaluated every step, instead of fix move/addforce/addtorque commands.")
+        | lyra::opt( journalPath, "journal")
+            ["--journal"]
+            ("Path to the binary journal of the Lammps commands, to use with radahn-replay. Default to full.journal.radahn.")
+        | lyra::opt( checkpointEvery, "checkpointevery")
+            ["--checkpointevery"]
+            ("Write a checkpoint of the simulation and of the motor engine every N NVE intervals. 0 to disable.")
+        | lyra::opt( checkpointFolder, "checkpointdir")
+            ["--checkpointdir"]
+            ("Folder shared with the motor engine to store the checkpoints. Default to checkpoint.")
+        | lyra::opt( resume)
+            ["--resume"]
+            ("Restart from the last checkpoint completed by both the simulation and the motor engine. The NVT phase is skipped.")
+        | lyra::opt( asyncSend)
+            ["--asyncsend"]
+            ("Push the frames from a separate thread while Lammps computes the next interval. Requires MPI_THREAD_MULTIPLE and a command lag of at least 1 interval.")
+        | lyra::opt( persistentRun)
+            ["--persistentrun"]
+            ("Continue the previous run without the Lammps setup (run N pre no post no) when no motor command changed since the previous interval.")
+        | lyra::opt( useSharedMemory)
+            ["--shm"]
+            ("Write the frames in a shared memory ring read in place by the engine when it runs on the same node. Falls back to MPI otherwise.")
+        | lyra::opt( nbReplicas, "replicas")
+            ["--replicas"]
+            ("Split the processes in N Lammps partitions, each running a replica of the system with its own seeds. Default to 1.")
         ;
 
     auto result = cli.parse( { argc, argv } );
@@ -310,6 +1204,33 @@ int main(int argc, char** argv)
     spdlog::info("Starting the task {}.", taskName);
     spdlog::info("Running the Lammps simulation for {} steps with an output frequency of {} steps.", maxNVESteps, intervalSteps);
 
+    if(minIntervalSteps == 0)
+        minIntervalSteps = intervalSteps;
+    if(maxIntervalSteps == 0)
+        maxIntervalSteps = intervalSteps;
+    if(minIntervalSteps > maxIntervalSteps)
+    {
+        spdlog::critical("The minimum interval length {} is larger than the maximum interval length {}.", minIntervalSteps, maxIntervalSteps);
+        exit(-1);
+    }
+    if(minIntervalSteps != maxIntervalSteps)
+        spdlog::info("The NVE interval length follows the motor engine between {} and {} steps.", minIntervalSteps, maxIntervalSteps);
+    if(nbReplicas == 0)
+    {
+        spdlog::critical("At least one replica is required.");
+        exit(-1);
+    }
+
+    // The asynchronous sender calls MPI from a second thread, MPI must be initialized with the proper thread level
+    // before Godrick initializes it with the default one.
+    int mpiInitialized = 0;
+    MPI_Initialized(&mpiInitialized);
+    if(asyncSend && mpiInitialized == 0)
+    {
+        int provided = MPI_THREAD_SINGLE;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    }
+
     auto handler = godrick::mpi::GodrickMPI();
 
     spdlog::info("Loading the workflow configuration {}.", configFile);
@@ -321,15 +1242,70 @@ int main(int argc, char** argv)
         exit(-1);
     }
 
+    // Once the sender is created, its thread is the only one calling the handler
+    MPI_Comm taskComm = handler.getTaskCommunicator();
+    std::unique_ptr<AsyncFrameSender> frameSender;
+    if(asyncSend)
+    {
+        if(AsyncFrameSender::isSupported())
+        {
+            // The collectives of Lammps and of Godrick run concurrently, they can't share a communicator
+            MPI_Comm lammpsComm;
+            MPI_Comm_dup(taskComm, &lammpsComm);
+            taskComm = lammpsComm;
+            frameSender = std::make_unique<AsyncFrameSender>(handler, "atoms", "in");
+            spdlog::info("The frames will be sent asynchronously.");
+        }
+        else
+            spdlog::warn("The MPI library does not provide MPI_THREAD_MULTIPLE, the frames will be sent synchronously.");
+    }
+
     // Setting up Lammps
-    LAMMPS* lps = new LAMMPS(0, NULL, handler.getTaskCommunicator());
-    //int rank = handler.getTaskRank();
+    // With several replicas, the processes of the task are split in Lammps partitions of equal size
+    std::vector<std::string> lmpArgs({"lammps"});
+    if(nbReplicas > 1)
+    {
+        int taskSize = 0;
+        MPI_Comm_size(taskComm, &taskSize);
+        auto nbProcs = static_cast<uint32_t>(taskSize);
+        if(nbProcs % nbReplicas != 0)
+        {
+            spdlog::critical("The {} processes of the task cannot be split in {} replicas of the same size.", nbProcs, nbReplicas);
+            exit(-1);
+        }
+        lmpArgs.push_back("-partition");
+        lmpArgs.push_back(std::to_string(nbReplicas) + "x" + std::to_string(nbProcs / nbReplicas));
+    }
+    std::vector<char*> lmpArgv;
+    for(auto & arg : lmpArgs)
+        lmpArgv.push_back(arg.data());
+    LAMMPS* lps = new LAMMPS(static_cast<int>(lmpArgv.size()), lmpArgv.data(), taskComm);
+
+    // Rank within the partition, the replica is run by its own set of processes
+    int rank = 0;
+    MPI_Comm_rank(lps->world, &rank);
+    exportSettings.replica = static_cast<uint32_t>(lps->universe->iworld);
+    if(useSharedMemory)
+    {
+        char hostName[256] = {};
+        gethostname(hostName, sizeof(hostName) - 1);
+        exportSettings.hostName = hostName;
+        exportSettings.shmEnabled = true;
+    }
+    const auto checkpointPrefix = getSimulationCheckpointPrefix(exportSettings.replica, nbReplicas);
+    if(nbReplicas > 1)
+    {
+        spdlog::info("Running the replica {} of {}.", exportSettings.replica, nbReplicas);
+        if(!journalPath.empty())
+            journalPath += ".r" + std::to_string(exportSettings.replica);
+    }
 
-    // Creating the log file for the commands
-    std::ofstream logFile("full.log.lammps");
+    // Binary journal of the commands, replayed or printed with radahn-replay. 
+    // All the ranks of a replica execute the same commands, only the first one writes it.
+    CommandJournalWriter journal(rank == 0 ? journalPath : std::string());
 
-    //std::stringstream logFile;
-    executeScript(lps, lmpInitialState, logFile);
+    registerRadahnFixes(lps);
+    executeScript(lps, lmpInitialState, journal);
     auto simUnitStyle = getUnitStyle(lmpInitialState);
     auto simUnitValue = static_cast<std::underlying_type<radahn::core::SimUnits>::type>(simUnitStyle);
 
@@ -387,11 +1363,8 @@ int main(int argc, char** argv)
             {
                 std::stringstream commandGroup;
                 commandGroup << "group " << permanentAnchorName << " id";
-                for(auto & id : anchorIDS)
-                {
-                    commandGroup << " " << id;
-                }
-                executeCommand(lps, commandGroup.str(), logFile);
+                radahn::lmp::LammpsCommandsUtils::writeIdSelection(commandGroup, anchorIDS);
+                executeCommand(lps, commandGroup.str(), journal);
                 hasPermanentAnchor = true;
             }
         }
@@ -426,6 +1399,78 @@ int main(int argc, char** argv)
             }
         }
 
+        // Check for the per-atom fields to send to the engine
+        // Ex: "export": {"fields": {"positions": {"every": 1}, "forces": {"every": 10}, "velocities": {"every": 0}}}
+        if(document.contains("export") && document["export"].contains("fields"))
+        {
+            auto & fieldsNode = document["export"]["fields"];
+            for(auto & [fieldName, fieldNode] : fieldsNode.items())
+            {
+                FieldExport field;
+                field.every = fieldNode.value("every", 1u);
+
+                if(fieldName.compare("positions") == 0)
+                    exportSettings.positions = field;
+                else if(fieldName.compare("forces") == 0)
+                    exportSettings.forces = field;
+                else if(fieldName.compare("velocities") == 0)
+                    exportSettings.velocities = field;
+                else
+                {
+                    spdlog::critical("Unknown per-atom field \"{}\" requested in \"export\". Supported fields are positions, forces and velocities. Abording.", fieldName);
+                    exit(-1);
+                }
+            }
+
+            // The engine needs the positions every interval to update the motors
+            if(exportSettings.positions.every != 1)
+            {
+                spdlog::critical("The positions must be exported every interval (\"every\": 1), the motor engine requires them. Abording.");
+                exit(-1);
+            }
+            spdlog::info("Exporting positions every {} frame(s), forces every {} frame(s), velocities every {} frame(s) (0 = never).", 
+                exportSettings.positions.every, exportSettings.forces.every, exportSettings.velocities.every);
+        }
+
+        // Check for the wire encoding of the positions
+        // Ex: "export": {"positionEncoding": "float32"}, supported values are float64, float32 and fixed16
+        if(document.contains("export") && document["export"].contains("positionEncoding"))
+        {
+            auto encodingName = document["export"]["positionEncoding"].get<std::string>();
+            try
+            {
+                exportSettings.positionEncoding = radahn::core::positionEncodingFromString(encodingName);
+            }
+            catch(const std::invalid_argument& e)
+            {
+                spdlog::critical("Unknown position encoding \"{}\" requested in \"export\". Supported encodings are float64, float32 and fixed16. Abording.", encodingName);
+                exit(-1);
+            }
+            spdlog::info("Sending the positions with the {} encoding.", encodingName);
+        }
+
+        // Check for the temporal compression
+        // Ex: "export": {"delta": true, "keyframeEvery": 20}
+        if(document.contains("export"))
+        {
+            exportSettings.deltaEnabled = document["export"].value("delta", false);
+            uint32_t keyframeEvery = document["export"].value("keyframeEvery", 20u);
+            exportSettings.positionsDelta.m_keyframeEvery = keyframeEvery;
+            exportSettings.velocitiesDelta.m_keyframeEvery = keyframeEvery;
+            if(exportSettings.deltaEnabled)
+                spdlog::info("Delta compression enabled for the positions and velocities with a keyframe every {} frame(s) (0 = only the first one).", keyframeEvery);
+        }
+
+        // Check for the region of interest
+        // Ex: "export": {"roi": true, "fullFrameEvery": 10}
+        if(document.contains("export"))
+        {
+            exportSettings.roiEnabled = document["export"].value("roi", false);
+            exportSettings.fullFrameEvery = document["export"].value("fullFrameEvery", 10u);
+            if(exportSettings.roiEnabled)
+                spdlog::info("Region of interest enabled, sending all the atoms every {} frame(s) (0 = only the first one).", exportSettings.fullFrameEvery);
+        }
+
         // check for NVT
         if(document.contains("nvtConfig"))
         {
@@ -462,27 +1507,53 @@ int main(int argc, char** argv)
             }
         }
     }
-    logFile.flush();
+    journal.flush();
+
+    // The replicas only differ by their random seeds
+    if(nbReplicas > 1)
+    {
+        seedNVT += exportSettings.replica;
+        seedCreateVel += exportSettings.replica;
+        for(auto & thermostat : thermostats)
+            thermostat.seed += exportSettings.replica;
+    }
+
+    // The checkpoints are taken during the NVE phase, the thermalization is already done when resuming
+    std::optional<simIt_t> resumeStep;
+    if(resume)
+    {
+        resumeStep = findLastCheckpoint(checkpointFolder, {checkpointPrefix, "engine"});
+        if(!resumeStep)
+        {
+            spdlog::critical("No complete checkpoint found in {}. Unable to resume.", checkpointFolder);
+            exit(-1);
+        }
+        spdlog::info("Resuming from the checkpoint of the step {}.", *resumeStep);
+        enableNVT = false;
+    }
+
+    // Time spent in each phase of the loops, sent with the frames
+    PhaseTimers timers;
 
     // NVT Section
     currentStep = 0;
     if(enableNVT && nvtType.compare("nvtPhase") == 0)
     {
-        executeCommand(lps, "#### PHASE NVT Start from Timestep " + std::to_string(currentStep) + " #####################################", logFile);
+        executeCommand(lps, "#### PHASE NVT Start from Timestep " + std::to_string(currentStep) + " #####################################", journal);
 
         // We first need to initialize the velocities before doing the NVT loop
         if(hasPermanentAnchor)
         {
             std::string cmdFreeGroup = "group freeGlobal subtract all " + permanentAnchorName;
-            executeCommand(lps, cmdFreeGroup, logFile);
+            executeCommand(lps, cmdFreeGroup, journal);
 
             std::stringstream cmdCreateVelocities;
             // https://docs.lammps.org/velocity.html
             cmdCreateVelocities<<"velocity freeGlobal create "<<startTemp<<" "<<seedNVT;
-            executeCommand(lps, cmdCreateVelocities.str(), logFile);
+            executeCommand(lps, cmdCreateVelocities.str(), journal);
 
             //std::string cmdFreeUngroup = "group freeGlobal delete";
-            //executeCommand(lps, cmdFreeUngroup, logFile);
+            //executeCommand(lps, cmdFreeUngroup, journal);
 
             // Create the NVT fix 
             std::stringstream cmdFixLangevin;
@@ -493,18 +1564,18 @@ int main(int argc, char** argv)
             cmdFixLangevin<< " "<<endTemp;
             cmdFixLangevin<< " "<<damp.m_value; // Was converted to the right unit when loaded
             cmdFixLangevin<< " "<<seedNVT;
-            executeCommand(lps, cmdFixLangevin.str(), logFile);
+            executeCommand(lps, cmdFixLangevin.str(), journal);
 
             std::stringstream cmdFixNVT;
             cmdFixNVT<<"fix nvtnve freeGlobal nve";
-            executeCommand(lps, cmdFixNVT.str(), logFile);
+            executeCommand(lps, cmdFixNVT.str(), journal);
         }
         else 
         {
             std::stringstream cmdCreateVelocities;
             // https://docs.lammps.org/velocity.html
             cmdCreateVelocities<<"velocity all create "<<startTemp<<" "<<seedNVT;
-            executeCommand(lps, cmdCreateVelocities.str(), logFile);
+            executeCommand(lps, cmdCreateVelocities.str(), journal);
 
             // Create the NVT fix 
             std::stringstream cmdFixLangevin;
@@ -515,16 +1586,16 @@ int main(int argc, char** argv)
             cmdFixLangevin<< " "<<endTemp;
             cmdFixLangevin<< " "<<damp.m_value; // Was converted to the right unit when loaded
             cmdFixLangevin<< " "<<seedNVT;
-            executeCommand(lps, cmdFixLangevin.str(), logFile);
+            executeCommand(lps, cmdFixLangevin.str(), journal);
 
             std::stringstream cmdFixNVT;
             cmdFixNVT<<"fix nvtnve all nve";
-            executeCommand(lps, cmdFixNVT.str(), logFile);
+            executeCommand(lps, cmdFixNVT.str(), journal);
         }
 
         // Flushing the commands we have executed to file
         // This is costly, but during the debugging stage where the simulation might break, it's a necessary cost.
-        logFile.flush();
+        journal.flush();
         
         std::vector<std::string> thermoFieldsNVT({"step", "time", "etotal", "pe", "epair"});
         // DEBUG FOR KEVIN. THIS IS SETUP In THE INPUT
@@ -534,13 +1605,18 @@ int main(int argc, char** argv)
             thermoFieldsNVT.push_back("v_LJ");
             thermoFieldsNVT.push_back("v_TORSION");
         }
+        auto samplerNVT = createThermoSampler(lps, "radahnSampleNVT", thermoFieldsNVT, journal);
 
         // At this point, everything is declared, we just have to call run
+        // Nothing changes between the NVT intervals, only the first one needs the setup
         std::vector<conduit::Node> receivedData;
+        bool needSetup = true;
         while(currentStep < nbNVTSteps)
         {
-            executeCommand(lps, "#### LOOP NVT Start from Timestep " + std::to_string(currentStep) + " #####################################", logFile);
-            auto resultReceive = handler.get("in", receivedData);
+            executeCommand(lps, "#### LOOP NVT Start from Timestep " + std::to_string(currentStep) + " #####################################", journal);
+            timers.start("get");
+            auto resultReceive = receiveFromEngine(handler, frameSender.get(), receivedData);
+            timers.stop("get");
             if( resultReceive == godrick::MessageResponse::TERMINATE )
             {
                 spdlog::info("Lammps received a terminate message from the engine. Exiting the loop.");
@@ -557,111 +1633,120 @@ int main(int argc, char** argv)
                 spdlog::info("Lammps received a token.");
             }
 
-            // During the NVT phase, we don't expect anything from the motor engine, no need to check the message content further.
+            // During the NVT phase, we don't expect any command from the motor engine, only the shared memory handshake.
+            if(resultReceive == godrick::MessageResponse::MESSAGES)
+                checkSharedMemoryAccepted(receivedData[0], exportSettings);
+
+            // The next message is received while Lammps runs, before the frame of this interval is pushed
+            if(frameSender && currentStep + intervalSteps < nbNVTSteps)
+                frameSender->requestReceive();
 
             // Advance the simulation
-            executeCommand(lps, "run " + std::to_string(intervalSteps), logFile);
+            timers.start("run");
+            runInterval(lps, intervalSteps, needSetup || !persistentRun, samplerNVT, journal);
+            needSetup = false;
+            timers.stop("run");
 
             // Sending the simulation data 
-            sendLammpsData(lps, simUnitValue, handler, "NVT", thermoFieldsNVT);
+            sendLammpsData(lps, simUnitValue, handler, "NVT", thermoFieldsNVT, samplerNVT, exportSettings, timers, frameSender.get());
 
             // Not using simIt to avoid potential rounding errors from double to uint64
             currentStep += intervalSteps; 
 
-            executeCommand(lps, "#### LOOP NVT End at Timestep " + std::to_string(currentStep) + " #########################################", logFile);
+            executeCommand(lps, "#### LOOP NVT End at Timestep " + std::to_string(currentStep) + " #########################################", journal);
 
             // Flushing the commands we have executed to file
             // This is costly, but during the debugging stage where the simulation might break, it's a necessary cost.
-            logFile.flush();
+            journal.flush();
         }
 
         // NVT phase is complete, cleaning things up
         if(hasPermanentAnchor)
         {
             std::string unfixNVE{"unfix nvtnve"};
-            executeCommand(lps, unfixNVE, logFile);
+            executeCommand(lps, unfixNVE, journal);
 
             std::string unfixlangevin{"unfix nvtlangevin"};
-            executeCommand(lps, unfixlangevin, logFile);
+            executeCommand(lps, unfixlangevin, journal);
 
             std::string ungroup{"group freeGlobal delete"};
-            executeCommand(lps, ungroup, logFile);
+            executeCommand(lps, ungroup, journal);
         }
         else 
         {
             std::string unfixNVE{"unfix nvtnve"};
-            executeCommand(lps, unfixNVE, logFile);
+            executeCommand(lps, unfixNVE, journal);
 
             std::string unfixlangevin{"unfix nvtlangevin"};
-            executeCommand(lps, unfixlangevin, logFile);
+            executeCommand(lps, unfixlangevin, journal);
         }
+        executeCommand(lps, "unfix radahnSampleNVT", journal);
 
-        executeCommand(lps, "#### PHASE NVT END at Timestep " + std::to_string(currentStep) + " #####################################", logFile);
+        executeCommand(lps, "#### PHASE NVT END at Timestep " + std::to_string(currentStep) + " #####################################", journal);
     }
     else if(enableNVT && nvtType.compare("createVelocity") == 0)
     {
         // We first need to initialize the velocities before doing the NVT loop
         if(hasPermanentAnchor)
         {
-            executeCommand(lps, "#### LOOP NVT Start from Timestep " + std::to_string(currentStep) + " #####################################", logFile);
+            executeCommand(lps, "#### LOOP NVT Start from Timestep " + std::to_string(currentStep) + " #####################################", journal);
             
             std::string cmdFreeGroup = "group freeGlobal subtract all " + permanentAnchorName;
-            executeCommand(lps, cmdFreeGroup, logFile);
+            executeCommand(lps, cmdFreeGroup, journal);
 
             std::stringstream cmdCreateVelocities;
             // https://docs.lammps.org/velocity.html
             cmdCreateVelocities<<"velocity freeGlobal create "<<tempCreateVel<<" "<<seedCreateVel;
-            executeCommand(lps, cmdCreateVelocities.str(), logFile);
+            executeCommand(lps, cmdCreateVelocities.str(), journal);
 
             std::string ungroup{"group freeGlobal delete"};
-            executeCommand(lps, ungroup, logFile);
+            executeCommand(lps, ungroup, journal);
 
-            executeCommand(lps, "#### PHASE NVT END at Timestep " + std::to_string(currentStep) + " #####################################", logFile);
+            executeCommand(lps, "#### PHASE NVT END at Timestep " + std::to_string(currentStep) + " #####################################", journal);
         }
         else 
         {
-            executeCommand(lps, "#### LOOP NVT Start from Timestep " + std::to_string(currentStep) + " #####################################", logFile);
+            executeCommand(lps, "#### LOOP NVT Start from Timestep " + std::to_string(currentStep) + " #####################################", journal);
 
             std::stringstream cmdCreateVelocities;
             // https://docs.lammps.org/velocity.html
             cmdCreateVelocities<<"velocity all create "<<tempCreateVel<<" "<<seedCreateVel;
-            executeCommand(lps, cmdCreateVelocities.str(), logFile);
+            executeCommand(lps, cmdCreateVelocities.str(), journal);
 
-            executeCommand(lps, "#### PHASE NVT END at Timestep " + std::to_string(currentStep) + " #####################################", logFile);
+            executeCommand(lps, "#### PHASE NVT END at Timestep " + std::to_string(currentStep) + " #####################################", journal);
         }
     }
     // Flushing the commands we have executed to file
-    logFile.flush();
+    journal.flush();
 
     // PRE NVE Section
     std::vector<std::string> thermoFields({"step", "time", "etotal", "pe", "epair"});
     std::vector<std::string> thermoGroups;
-    executeCommand(lps, "#### PRE NVE Start from Timestep " + std::to_string(currentStep) + " #####################################", logFile);
+    executeCommand(lps, "#### PRE NVE Start from Timestep " + std::to_string(currentStep) + " #####################################", journal);
     if(thermostats.size() > 0)
     {
         for(auto & thermostat : thermostats)
         {
             std::stringstream cmdGroup;
             cmdGroup<<"group "<<thermostat.name<<" id";
-            for(auto & id : thermostat.indices)
-                cmdGroup<<" "<<id;
-            executeCommand(lps, cmdGroup.str(), logFile);
+            radahn::lmp::LammpsCommandsUtils::writeIdSelection(cmdGroup, thermostat.indices);
+            executeCommand(lps, cmdGroup.str(), journal);
 
             thermoGroups.push_back(thermostat.name);
 
             std::stringstream cmdComputeTemp;
             cmdComputeTemp<<"compute temp_"<<thermostat.name<<" "<<thermostat.name<<" temp";
-            executeCommand(lps, cmdComputeTemp.str(), logFile);
+            executeCommand(lps, cmdComputeTemp.str(), journal);
             thermoFields.push_back("c_temp_" + thermostat.name);
 
             std::stringstream cmdComputeKe;
             cmdComputeKe<<"compute ke_"<<thermostat.name<<" "<<thermostat.name<<" ke";
-            executeCommand(lps,cmdComputeKe.str(), logFile);
+            executeCommand(lps,cmdComputeKe.str(), journal);
             thermoFields.push_back("c_ke_" + thermostat.name);
 
             std::stringstream cmdFixLangevin;
             cmdFixLangevin<<"fix lgv"<<thermostat.name<<" "<<thermostat.name<<" langevin "<<thermostat.startTemp<<" "<<thermostat.endTemp<<" "<<thermostat.damp.m_value<<" "<<thermostat.seed;
-            executeCommand(lps,cmdFixLangevin.str(), logFile);
+            executeCommand(lps,cmdFixLangevin.str(), journal);
         }  
     }
 
@@ -670,12 +1755,12 @@ int main(int argc, char** argv)
         cmdGroupMobile<<"group mobileAtoms subtract all "<<permanentAnchorName;
     else
         cmdGroupMobile<<"group mobileAtoms union all";
-    executeCommand(lps, cmdGroupMobile.str(), logFile);
+    executeCommand(lps, cmdGroupMobile.str(), journal);
     std::string cmdMobileComputeTemp{"compute temp_mobileAtoms mobileAtoms temp"};
-    executeCommand(lps, cmdMobileComputeTemp, logFile);
+    executeCommand(lps, cmdMobileComputeTemp, journal);
     thermoFields.push_back("c_temp_mobileAtoms");
     std::string cmdMobileComputeKE{"compute ke_mobileAtoms mobileAtoms ke"};
-    executeCommand(lps, cmdMobileComputeKE, logFile);
+    executeCommand(lps, cmdMobileComputeKE, journal);
     thermoFields.push_back("c_ke_mobileAtoms");
 
     std::stringstream cmdGroupThermalized;
@@ -689,33 +1774,33 @@ int main(int argc, char** argv)
     {
         cmdGroupThermalized<<"group thermalizedAtoms empty";
     }
-    executeCommand(lps, cmdGroupThermalized.str(), logFile);
+    executeCommand(lps, cmdGroupThermalized.str(), journal);
     std::string cmdThermalizedComputeTemp{"compute temp_thermalizedAtoms thermalizedAtoms temp"};
-    executeCommand(lps, cmdThermalizedComputeTemp, logFile);
+    executeCommand(lps, cmdThermalizedComputeTemp, journal);
     thermoFields.push_back("c_temp_thermalizedAtoms");
     std::string cmdThermalizedComputeKE{"compute ke_thermalizedAtoms thermalizedAtoms ke"};
-    executeCommand(lps, cmdThermalizedComputeKE, logFile);
+    executeCommand(lps, cmdThermalizedComputeKE, journal);
     thermoFields.push_back("c_ke_thermalizedAtoms");
 
     std::string cmdGroupNonThermalized{"group nonthermalizedAtoms subtract mobileAtoms thermalizedAtoms"};
-    executeCommand(lps, cmdGroupNonThermalized, logFile);
+    executeCommand(lps, cmdGroupNonThermalized, journal);
     std::string cmdNonThermalizedComputeTemp{"compute temp_nonthermalizedAtoms nonthermalizedAtoms temp"};
-    executeCommand(lps, cmdNonThermalizedComputeTemp, logFile);
+    executeCommand(lps, cmdNonThermalizedComputeTemp, journal);
     thermoFields.push_back("c_temp_nonthermalizedAtoms");
     std::string cmdNonThermalizedComputeKE{"compute ke_nonthermalizedAtoms nonthermalizedAtoms ke"};
-    executeCommand(lps, cmdNonThermalizedComputeKE, logFile);
+    executeCommand(lps, cmdNonThermalizedComputeKE, journal);
     thermoFields.push_back("c_ke_nonthermalizedAtoms");
 
     if(hasPermanentAnchor)
     {
         std::stringstream cmdAnchorComputeTemp;
         cmdAnchorComputeTemp<<"compute temp_"<<permanentAnchorName<<" "<<permanentAnchorName<<" temp";
-        executeCommand(lps, cmdAnchorComputeTemp.str(), logFile);
+        executeCommand(lps, cmdAnchorComputeTemp.str(), journal);
         thermoFields.push_back("c_temp_" + permanentAnchorName);
 
         std::stringstream cmdAnchorComputeKE;
         cmdAnchorComputeKE<<"compute ke_"<<permanentAnchorName<<" "<<permanentAnchorName<<" ke";
-        executeCommand(lps, cmdAnchorComputeKE.str(), logFile);
+        executeCommand(lps, cmdAnchorComputeKE.str(), journal);
         thermoFields.push_back("c_ke_" + permanentAnchorName);
     }
 
@@ -727,23 +1812,77 @@ int main(int argc, char** argv)
         thermoFields.push_back("v_TORSION");
     }
 
-    executeCommand(lps, "thermo 50", logFile);
+    executeCommand(lps, "thermo 50", journal);
     std::stringstream cmdThermoStyle;
     cmdThermoStyle<<"thermo_style custom";
     for(auto & field : thermoFields)
         cmdThermoStyle<<" "<<field;
-    executeCommand(lps, cmdThermoStyle.str(), logFile);
-    executeCommand(lps, "thermo_modify lost error flush yes", logFile);
+    executeCommand(lps, cmdThermoStyle.str(), journal);
+    executeCommand(lps, "thermo_modify lost error flush yes", journal);
+    auto sampler = createThermoSampler(lps, "radahnSample", thermoFields, journal);
 
-    executeCommand(lps, "#### PRE NVE End from Timestep " + std::to_string(currentStep) + " #####################################", logFile);
+    executeCommand(lps, "#### PRE NVE End from Timestep " + std::to_string(currentStep) + " #####################################", journal);
 
     // NVE Section
+    // The command util keeps track of the motors applied in Lammps across the iterations, only the differences 
+    // with the previous iteration are sent to Lammps
+    auto cmdUtil = radahn::lmp::LammpsCommandsUtils();
+    if(hasPermanentAnchor)
+        cmdUtil.declarePermanentAnchorGroup(permanentAnchorName);
+
+    // With the fix radahn, a single fix integrates the mobile atoms and applies the motors for the whole NVE phase
+    FixRadahn* fixRadahn = nullptr;
+    std::set<std::string> completedActions;
+    if(useFixRadahn)
+    {
+        executeCommand(lps, "fix " + fixRadahnName + " mobileAtoms radahn", journal);
+        fixRadahn = dynamic_cast<FixRadahn*>(lps->modify->get_fix_by_id(fixRadahnName));
+        if(fixRadahn == nullptr)
+        {
+            spdlog::critical("Unable to retrieve the fix radahn after its creation. Abording.");
+            exit(-1);
+        }
+    }
+
     std::vector<conduit::Node> receivedData;
     uint64_t currentNVEStep = 0;
+    uint64_t nbNVEIntervals = 0;
+
+    // The first interval is set up after the groups, computes and fixes declared above.
+    // The next ones only need it when the motors change the fixes applied in Lammps.
+    bool needSetup = true;
+    std::vector<uint8_t> previousActions;
+    if(resumeStep)
+    {
+        if(!readCheckpoint(lps, getCheckpointPath(checkpointFolder, checkpointPrefix, *resumeStep), currentNVEStep, exportSettings.nbFramesSent, journal))
+        {
+            spdlog::critical("Unable to restore the checkpoint of the step {}. Abording.", *resumeStep);
+            exit(-1);
+        }
+        currentStep = *resumeStep;
+        executeCommand(lps, "run 0", journal);
+
+        // The commands computed by the engine for this step were lost, sending the checkpoint frame again
+        // so that the first interval runs with the motors. One initial token is consumed here,
+        // the first message received in the loop is the answer to this frame.
+        sendLammpsData(lps, simUnitValue, handler, "NVE", thermoFields, sampler, exportSettings, timers, frameSender.get());
+        // Any other answer would shift the commands of every next interval by one frame
+        if(receiveFromEngine(handler, frameSender.get(), receivedData) != godrick::MessageResponse::TOKEN)
+        {
+            spdlog::critical("Expected the initial token of the engine when resuming. Abording.");
+            exit(-1);
+        }
+    }
+
     while(currentNVEStep < maxNVESteps)
     {
-        executeCommand(lps, "#### LOOP NVE Start from Timestep " + std::to_string(currentStep) + " #####################################", logFile);
-        auto resultReceive = handler.get("in", receivedData);
+        // Without suggestion from the motor engine, the default interval is used
+        uint64_t nextIntervalSteps = std::clamp(intervalSteps, minIntervalSteps, maxIntervalSteps);
+
+        executeCommand(lps, "#### LOOP NVE Start from Timestep " + std::to_string(currentStep) + " #####################################", journal);
+        timers.start("get");
+        auto resultReceive = receiveFromEngine(handler, frameSender.get(), receivedData);
+        timers.stop("get");
         if( resultReceive == godrick::MessageResponse::TERMINATE )
         {
             spdlog::info("Lammps received a terminate message from the engine. Exiting the loop.");
@@ -762,68 +1901,160 @@ int main(int argc, char** argv)
 
 
         // Gathering the commands we will need to execute
-        auto cmdUtil = radahn::lmp::LammpsCommandsUtils();
-        if(hasPermanentAnchor)
-            cmdUtil.declarePermanentAnchorGroup(permanentAnchorName);
-
+        timers.start("commands");
         if(resultReceive == godrick::MessageResponse::MESSAGES)
         {
             spdlog::info("Lammps received a regular message.");
+            checkSharedMemoryAccepted(receivedData[0], exportSettings);
+
+            // With an ensemble, the engine sends the commands of every replica in the same message
+            conduit::Node& replicaCmds = receivedData[0].has_child("replicas") ? receivedData[0]["replicas"].child(static_cast<conduit::index_t>(exportSettings.replica)) : receivedData[0];
 
             // Check that we have lammps commands
-            if(receivedData[0].has_child("lmpcmds"))
+            if(replicaCmds.has_child("lmpcmds"))
             {
                 //auto cmdUtil = radahn::core::LammpsCommandsUtils();
-                if(!cmdUtil.loadCommandsFromConduit(receivedData[0]))
+                if(!cmdUtil.loadCommandsFromConduit(replicaCmds))
                 {
                     spdlog::error("Something went wrong when try to parse the lammps commands. Abording the simulation loop.");
                     break;
                 }                
             }
+
+            // The engine sends the atoms it needs for the next frame
+            if(exportSettings.roiEnabled && replicaCmds.has_child("roi"))
+                exportSettings.updateROI(replicaCmds["roi"], static_cast<uint64_t>(lps->atom->natoms));
+
+            // Or only the reductions it needs over the motor selections
+            if(replicaCmds.has_child("reductions"))
+            {
+                // The motors send the same requests until they change, the lookup of their atoms is only rebuilt then
+                conduit::Node diffInfo;
+                if(!exportSettings.reductionsReceived || exportSettings.reductionRequests.diff(replicaCmds["reductions"], diffInfo, 0.0))
+                {
+                    exportSettings.reductionRequests = replicaCmds["reductions"];
+                    buildReductionLayout(exportSettings.reductionRequests, exportSettings.reductionLayout);
+                }
+                exportSettings.reductionsReceived = true;
+            }
+
+            // The frame the commands were computed from, it precedes the last frame sent when running with a command lag
+            if(receivedData[0].has_child("sourceIt"))
+            {
+                exportSettings.commandSourceIt = receivedData[0]["sourceIt"].to_uint64();
+                executeCommand(lps, "#### Commands computed from the frame of the step " + std::to_string(*exportSettings.commandSourceIt), journal);
+            }
+
+            // The engine estimates when the next motor reaches its target
+            if(receivedData[0].has_child("nextInterval"))
+                nextIntervalSteps = std::clamp(receivedData[0]["nextInterval"].to_uint64(), static_cast<uint64_t>(minIntervalSteps), static_cast<uint64_t>(maxIntervalSteps));
         }
+        nextIntervalSteps = std::min(nextIntervalSteps, maxNVESteps - currentNVEStep);
+
+        // The next commands are received while Lammps runs, before the frame of this interval is pushed
+        if(frameSender && currentNVEStep + nextIntervalSteps < maxNVESteps)
+            frameSender->requestReceive();
 
         // All the commands are registed to the util object, now we can generate the correspinding Lammps commands
+        // Only the motors which started, stopped or changed since the last iteration generate commands. 
+        // The time integration fix is updated by the util as well if needed.
+        if(fixRadahn)
+        {
+            // The motors are given to the fix directly, no Lammps command is generated
+            std::vector<FixRadahn::Action> actions;
+            buildRadahnActions(cmdUtil, actions);
 
+            // Journaled so the session can be replayed without the motor engine
+            std::vector<uint8_t> packedActions;
+            FixRadahn::packActions(actions, packedActions);
+            journal.appendBlob("actions/" + fixRadahnName, packedActions);
 
-        // Create the commands for the motors
-        std::vector<std::string> doCommands;
-        cmdUtil.writeDoCommands(doCommands);
-        for(auto & cmd : doCommands)
-            executeCommand(lps, cmd, logFile);
+            // Changing the forces applied by the fix requires its setup to apply them on the first step
+            needSetup |= packedActions != previousActions;
+            previousActions = std::move(packedActions);
 
-        // Create the time integration command
-        executeCommand(lps, "#### Start INTEGRATION ", logFile);
-        std::stringstream cmdFixNVE;
-        cmdFixNVE<<"fix NVE "<<cmdUtil.getIntegrationGroup()<<" nve";
-        executeCommand(lps, cmdFixNVE.str(), logFile);
+            fixRadahn->setActions(std::move(actions));
+            cmdUtil.clearCommands();
+        }
+        else
+        {
+            std::vector<std::string> updateCommands;
+            cmdUtil.writeUpdateCommands(updateCommands);
+            for(auto & cmd : updateCommands)
+            {
+                executeCommand(lps, cmd, journal);
+                needSetup |= !cmd.starts_with("#");
+            }
+        }
+        timers.stop("commands");
 
         // Advance the simulation
-        executeCommand(lps, "run " + std::to_string(intervalSteps), logFile);
-
-        // Undo the time integration
-        std::stringstream cmdUnfixNVE;
-        cmdUnfixNVE<<"unfix NVE";
-        executeCommand(lps, cmdUnfixNVE.str(), logFile);
-        executeCommand(lps, "#### End INTEGRATION ", logFile);
+        executeCommand(lps, "#### Start INTEGRATION ", journal);
+        timers.start("run");
+        runInterval(lps, nextIntervalSteps, needSetup || !persistentRun, sampler, journal);
+        needSetup = false;
+        timers.stop("run");
+        executeCommand(lps, "#### End INTEGRATION ", journal);
+
+        if(fixRadahn)
+        {
+            for(auto & action : fixRadahn->getActions())
+            {
+                if(action.completed && completedActions.count(action.origin) == 0)
+                {
+                    spdlog::info("Motor {} reached its target at the step {} and was stopped by the fix radahn.", action.origin, action.completedStep);
+                    completedActions.insert(action.origin);
+                }
+            }
+        }
 
-        // Undo the motors commands
-        std::vector<std::string> undoCommands;
-        cmdUtil.writeUndoCommands(undoCommands);
-        for(auto & cmd : undoCommands)
-            executeCommand(lps, cmd, logFile);
+        // The checkpoint is written before the frame, the engine saves its state after processing it
+        nbNVEIntervals++;
+        if(checkpointEvery > 0 && nbNVEIntervals % checkpointEvery == 0)
+        {
+            timers.start("checkpoint");
+            writeCheckpoint(lps, rank, checkpointFolder, checkpointPrefix, currentNVEStep + nextIntervalSteps, exportSettings.nbFramesSent, journal);
+            timers.stop("checkpoint");
+            exportSettings.checkpoint = true;
+        }
 
         // Sending the simulation data 
-        sendLammpsData(lps, simUnitValue, handler, "NVE", thermoFields);
+        sendLammpsData(lps, simUnitValue, handler, "NVE", thermoFields, sampler, exportSettings, timers, frameSender.get());
 
         // Not using simIt to avoid potential rounding errors from double to uint64
-        currentStep += intervalSteps; 
-        currentNVEStep += intervalSteps;
+        currentStep += nextIntervalSteps; 
+        currentNVEStep += nextIntervalSteps;
 
-        executeCommand(lps, "#### LOOP NVE End at Timestep " + std::to_string(currentStep) + " #########################################", logFile);
+        executeCommand(lps, "#### LOOP NVE End at Timestep " + std::to_string(currentStep) + " #########################################", journal);
 
         // Flushing the commands we have executed to file
-        logFile.flush();
+        journal.flush();
+    }
+
+    // Remove the motors and the time integration still applied
+    if(fixRadahn)
+    {
+        executeCommand(lps, "unfix " + fixRadahnName, journal);
     }
+    else
+    {
+        std::vector<std::string> clearCommands;
+        cmdUtil.writeClearCommands(clearCommands);
+        for(auto & cmd : clearCommands)
+            executeCommand(lps, cmd, journal);
+    }
+    executeCommand(lps, "unfix radahnSample", journal);
+    journal.flush();
+
+    if(frameSender)
+    {
+        // All the frames must be pushed before closing the ports
+        frameSender->flush();
+        spdlog::info("{} frames sent asynchronously. Time in the pushes and receptions: {:.3f}s, time waiting for the sender: {:.3f}s, time overlapped with Lammps: {:.3f}s.", 
+            frameSender->getNbFramesSent(), frameSender->getExchangeTime(), frameSender->getWaitTime(), frameSender->getSavedTime());
+        frameSender.reset();
+    }
+
     spdlog::info("Lammps done. Closing godrick...");
 
     handler.close();
@@ -0,0 +1,29 @@
+// Entry point to load the fix radahn in a regular Lammps executable with "plugin load radahnplugin.so".
+// Requires Lammps to be built with the PLUGIN package. The lammpsDriver registers the fix directly and doesn't need it.
+
+#include "lammpsplugin.h"
+#include "version.h"
+
+#include "fixRadahn.h"
+
+using namespace LAMMPS_NS;
+
+extern "C" void lammpsplugin_init(void *lmp, void *handle, void *regfunc)
+{
+    lammpsplugin_t plugin;
+    auto registerPlugin = reinterpret_cast<lammpsplugin_regfunc>(regfunc);
+
+    plugin.version = LAMMPS_VERSION;
+    plugin.style = "fix";
+    plugin.name = "radahn";
+    plugin.info = "Radahn motors and NVE time integration";
+    plugin.author = "Radahn";
+    plugin.creator.v2 = reinterpret_cast<lammpsplugin_factory2 *>(&createFixRadahn);
+    plugin.handle = handle;
+    (*registerPlugin)(&plugin, lmp);
+
+    plugin.name = "radahn/sample";
+    plugin.info = "Radahn thermo sampling at the end of each run";
+    plugin.creator.v2 = reinterpret_cast<lammpsplugin_factory2 *>(&createFixRadahnSample);
+    (*registerPlugin)(&plugin, lmp);
+}
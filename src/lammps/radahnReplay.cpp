@@ -0,0 +1,124 @@
+// Replay a command journal written by the lammpsDriver against a fresh Lammps instance,
+// or print it as a Lammps script with --print.
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <radahn/core/commandJournal.h>
+
+#include <lyra/lyra.hpp>
+#include <spdlog/spdlog.h>
+
+// lammps includes
+#include "lammps.h"
+#include "input.h"
+#include "modify.h"
+#include "library.h"
+#include "fixRadahn.h"
+
+using namespace LAMMPS_NS;
+using namespace radahn::core;
+
+bool applyBlob(LAMMPS* lps, const JournalEntry& entry)
+{
+    const std::string actionsPrefix = "actions/";
+    if(entry.tag.starts_with(actionsPrefix))
+    {
+        auto fixName = entry.tag.substr(actionsPrefix.size());
+        auto fix = dynamic_cast<FixRadahn*>(lps->modify->get_fix_by_id(fixName));
+        if(fix == nullptr)
+        {
+            spdlog::error("The journal sets the actions of the fix {} which doesn't exist.", fixName);
+            return false;
+        }
+
+        std::vector<FixRadahn::Action> actions;
+        if(!FixRadahn::unpackActions(entry.content, actions))
+        {
+            spdlog::error("Unable to read the actions of the fix {} from the journal.", fixName);
+            return false;
+        }
+        fix->setActions(std::move(actions));
+        return true;
+    }
+
+    spdlog::error("Unknown journal data {}.", entry.tag);
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    std::string journalPath;
+    bool printOnly = false;
+
+    auto cli = lyra::cli()
+        | lyra::opt( journalPath, "journal" )
+            ["--journal"]
+            ("Path to the journal written by the lammpsDriver.")
+        | lyra::opt( printOnly)
+            ["--print"]
+            ("Print the journal as a Lammps script instead of executing it.")
+        ;
+
+    auto result = cli.parse( { argc, argv } );
+    if ( !result )
+    {
+        spdlog::critical("Unable to parse the command line: {}.", result.errorMessage());
+        exit(1);
+    }
+    if(journalPath.empty())
+    {
+        spdlog::critical("No journal given, use --journal.");
+        exit(1);
+    }
+
+    CommandJournalReader reader;
+    if(!reader.open(journalPath))
+        exit(-1);
+
+    JournalEntry entry;
+    if(printOnly)
+    {
+        while(reader.next(entry))
+        {
+            if(entry.type == JournalRecord::BLOB)
+                std::cout << "# " << entry.tag << " (" << entry.content.size() << " bytes)\n";
+            else
+                std::cout << entry.content << "\n";
+        }
+        return 0;
+    }
+
+    MPI_Init(&argc, &argv);
+
+    LAMMPS* lps = new LAMMPS(0, NULL, MPI_COMM_WORLD);
+    registerRadahnFixes(lps);
+
+    uint64_t nbEntries = 0;
+    bool success = true;
+    while(success && reader.next(entry))
+    {
+        switch(entry.type)
+        {
+            case JournalRecord::COMMAND:
+                lps->input->one(entry.content);
+                break;
+            case JournalRecord::SCRIPT:
+                lammps_commands_string(lps, entry.content.c_str());
+                break;
+            case JournalRecord::BLOB:
+                success = applyBlob(lps, entry);
+                break;
+            default:
+                break;
+        }
+        nbEntries++;
+    }
+    spdlog::info("{} journal entries replayed.", nbEntries);
+
+    delete lps;
+    MPI_Finalize();
+
+    return success ? 0 : -1;
+}
@@ -1,5 +1,7 @@
 #include <radahn/core/atomSet.h>
 
+#include <spdlog/spdlog.h>
+
 /*radahn::core::AtomSet::AtomSet(const AtomSet& ref)
 {
     m_selection = ref.m_selection;
@@ -10,6 +12,16 @@
 
 bool radahn::core::AtomSet::selectAtoms(radahn::core::simIt_t currentIt, const std::vector<atomIndexes_t>& indices, const std::vector<atomPositions_t>& positions)
 {
+    if(m_reductionPending && m_reducedIt == currentIt)
+    {
+        m_reductionPending = false;
+        m_reduced = true;
+        m_currentIt = currentIt;
+        return m_reducedCount == m_selection.size();
+    }
+    m_reductionPending = false;
+    m_reduced = false;
+
     m_indices.clear();
     m_positions.clear();
 
@@ -29,9 +41,41 @@ bool radahn::core::AtomSet::selectAtoms(radahn::core::simIt_t currentIt, const s
     return m_indices.size() == m_selection.size();
 }
 
-std::vector<radahn::core::atomPositions_t> radahn::core::AtomSet::computePositionCenter() const
+void radahn::core::AtomSet::setReducedState(radahn::core::simIt_t currentIt, const conduit::Node& reduction)
 {
-    std::vector<radahn::core::atomPositions_t> center = {0.0, 0.0, 0.0};
+    m_reductionPending = true;
+    m_reducedIt = currentIt;
+    m_reducedCount = reduction["count"].to_uint64();
+    const atomPositions_t* center = reduction["center"].value();
+    m_reducedCenter = {center[0], center[1], center[2]};
+
+    m_indices.clear();
+    m_positions.clear();
+    if(reduction.has_child("trackedIDs"))
+    {
+        const atomIndexes_t* indices = reduction["trackedIDs"].value();
+        m_indices.assign(indices, indices + reduction["trackedIDs"].dtype().number_of_elements());
+        auto & trackedPositions = reduction.child("trackedPositions");
+        const atomPositions_t* positions = trackedPositions.value();
+        m_positions.assign(positions, positions + trackedPositions.dtype().number_of_elements());
+    }
+}
+
+void radahn::core::AtomSet::writeReductionRequest(conduit::Node& request, std::span<const atomIndexes_t> trackedIndices) const
+{
+    request["ids"] = m_vecSelection;
+    if(!trackedIndices.empty())
+        request["tracked"].set(trackedIndices.data(), static_cast<conduit::index_t>(trackedIndices.size()));
+    else if(request.has_child("tracked"))
+        request.remove("tracked");
+}
+
+std::array<radahn::core::atomPositions_t, 3> radahn::core::AtomSet::computePositionCenter() const
+{
+    if(m_reduced)
+        return m_reducedCenter;
+
+    std::array<radahn::core::atomPositions_t, 3> center = {0.0, 0.0, 0.0};
     if(m_indices.size() > 0)
     {
         for(size_t i = 0; i < m_indices.size(); ++i)
@@ -47,4 +91,55 @@ std::vector<radahn::core::atomPositions_t> radahn::core::AtomSet::computePositio
     }
 
     return center;
-}
\ No newline at end of file
+}
+
+std::array<radahn::core::atomPositions_t, 3> radahn::core::AtomSet::getSelectedAtomPosition(size_t selectionIndex) const
+{
+    // HYPOTHESIS: without reduction, the atoms are always sorted, the selected positions follow the selection order
+    size_t i = selectionIndex;
+    if(m_reduced)
+    {
+        auto id = m_vecSelection[selectionIndex];
+        i = 0;
+        while(i < m_indices.size() && m_indices[i] != id)
+            ++i;
+        if(i == m_indices.size())
+        {
+            spdlog::error("The atom {} is not part of the reduced state of the selection.", id);
+            return {0.0, 0.0, 0.0};
+        }
+    }
+    return {m_positions[3*i], m_positions[3*i+1], m_positions[3*i+2]};
+}
+
+void radahn::core::AtomSet::saveState(conduit::Node& node) const
+{
+    node["currentIt"] = m_currentIt;
+    node["indices"] = m_indices;
+    node["positions"] = m_positions;
+    if(m_reduced)
+    {
+        node["reducedCount"] = m_reducedCount;
+        node["reducedCenter"].set(m_reducedCenter.data(), 3);
+    }
+}
+
+void radahn::core::AtomSet::loadState(const conduit::Node& node)
+{
+    m_currentIt = node["currentIt"].to_uint64();
+
+    const atomIndexes_t* indices = node["indices"].value();
+    m_indices.assign(indices, indices + node["indices"].dtype().number_of_elements());
+
+    const atomPositions_t* positions = node["positions"].value();
+    m_positions.assign(positions, positions + node["positions"].dtype().number_of_elements());
+
+    m_reductionPending = false;
+    m_reduced = node.has_child("reducedCenter");
+    if(m_reduced)
+    {
+        m_reducedCount = node["reducedCount"].to_uint64();
+        const atomPositions_t* center = node["reducedCenter"].value();
+        m_reducedCenter = {center[0], center[1], center[2]};
+    }
+}
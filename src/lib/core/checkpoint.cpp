@@ -0,0 +1,89 @@
+#include <radahn/core/checkpoint.h>
+
+#include <filesystem>
+#include <set>
+#include <map>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+
+// Steps of the checkpoints found for the prefix, with the files belonging to each of them
+std::map<radahn::core::simIt_t, std::vector<std::filesystem::path>> listCheckpoints(const std::string& folder, const std::string& prefix)
+{
+    std::map<radahn::core::simIt_t, std::vector<std::filesystem::path>> checkpoints;
+    std::error_code ec;
+    if(!std::filesystem::is_directory(folder, ec))
+        return checkpoints;
+
+    const std::string start = prefix + ".";
+    for(auto & entry : std::filesystem::directory_iterator(folder, ec))
+    {
+        auto name = entry.path().filename().string();
+        if(!name.starts_with(start))
+            continue;
+
+        auto extension = name.find(".ckpt", start.size());
+        if(extension == std::string::npos || extension == start.size())
+            continue;
+
+        auto stepStr = name.substr(start.size(), extension - start.size());
+        if(stepStr.find_first_not_of("0123456789") != std::string::npos)
+            continue;
+
+        checkpoints[std::stoull(stepStr)].push_back(entry.path());
+    }
+    return checkpoints;
+}
+
+} // namespace
+
+std::string radahn::core::getCheckpointPath(const std::string& folder, const std::string& prefix, simIt_t step)
+{
+    return (std::filesystem::path(folder) / (prefix + "." + std::to_string(step) + ".ckpt")).string();
+}
+
+std::string radahn::core::getSimulationCheckpointPrefix(uint32_t replica, uint32_t nbReplicas)
+{
+    if(nbReplicas <= 1)
+        return "lammps";
+    return "lammps.r" + std::to_string(replica);
+}
+
+std::optional<radahn::core::simIt_t> radahn::core::findLastCheckpoint(const std::string& folder, const std::vector<std::string>& prefixes)
+{
+    std::optional<std::set<simIt_t>> commonSteps;
+    for(auto & prefix : prefixes)
+    {
+        std::set<simIt_t> steps;
+        for(auto & [step, files] : listCheckpoints(folder, prefix))
+        {
+            // The companion files of an interrupted checkpoint are left without the checkpoint file
+            std::error_code ec;
+            if((!commonSteps || commonSteps->count(step) > 0) && std::filesystem::exists(getCheckpointPath(folder, prefix, step), ec))
+                steps.insert(step);
+        }
+        commonSteps = steps;
+    }
+
+    if(!commonSteps || commonSteps->empty())
+        return std::nullopt;
+    return *commonSteps->rbegin();
+}
+
+void radahn::core::pruneCheckpoints(const std::string& folder, const std::string& prefix, size_t keep)
+{
+    auto checkpoints = listCheckpoints(folder, prefix);
+    while(checkpoints.size() > keep)
+    {
+        for(auto & file : checkpoints.begin()->second)
+        {
+            std::error_code ec;
+            std::filesystem::remove(file, ec);
+            if(ec)
+                spdlog::warn("Unable to remove the old checkpoint file {}: {}.", file.string(), ec.message());
+        }
+        checkpoints.erase(checkpoints.begin());
+    }
+}
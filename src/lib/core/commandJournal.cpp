@@ -0,0 +1,435 @@
+#include <radahn/core/commandJournal.h>
+
+#include <array>
+#include <cctype>
+#include <charconv>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+
+constexpr std::array<char, 8> journalMagic = {'R', 'D', 'H', 'N', 'J', 'R', 'N', 'L'};
+constexpr uint32_t journalVersion = 2;
+constexpr char argumentMarker = '\x01';
+// Runs of integers at least this long are atom selections
+constexpr size_t minSelectionSize = 4;
+
+bool isNumber(std::string_view field)
+{
+    if(field.empty() || !(std::isdigit(static_cast<unsigned char>(field[0])) || field[0] == '-' || field[0] == '.'))
+        return false;
+    double value = 0.0;
+    auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+    return error == std::errc() && end == field.data() + field.size();
+}
+
+bool isInteger(std::string_view field)
+{
+    return !field.empty() && field.find_first_not_of("0123456789") == std::string_view::npos;
+}
+
+} // namespace
+
+radahn::core::CommandJournalWriter::CommandJournalWriter(const std::string& path, size_t bufferSize, size_t maxStrings) :
+    m_bufferSize(bufferSize),
+    m_maxStrings(maxStrings)
+{
+    if(path.empty())
+        return;
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if(!m_file.is_open())
+    {
+        spdlog::error("Unable to open the command journal {}.", path);
+        return;
+    }
+
+    m_file.write(journalMagic.data(), journalMagic.size());
+    m_file.write(reinterpret_cast<const char*>(&journalVersion), sizeof(journalVersion));
+    m_buffer.reserve(m_bufferSize);
+    m_thread = std::thread(&CommandJournalWriter::run, this);
+}
+
+radahn::core::CommandJournalWriter::~CommandJournalWriter()
+{
+    close();
+}
+
+void radahn::core::CommandJournalWriter::appendCommand(const std::string& cmd)
+{
+    if(!isOpen())
+        return;
+
+    // Fields separated by single spaces, the empty fields keep the spacing of the command
+    std::vector<std::string_view> fields;
+    std::string_view remaining(cmd);
+    while(true)
+    {
+        auto end = remaining.find(' ');
+        fields.push_back(remaining.substr(0, end));
+        if(end == std::string_view::npos)
+            break;
+        remaining.remove_prefix(end + 1);
+    }
+
+    std::string pattern;
+    std::vector<std::pair<JournalArgument, std::string_view>> arguments;
+    for(size_t f = 0; f < fields.size(); ++f)
+    {
+        if(f > 0)
+            pattern += ' ';
+
+        size_t last = f;
+        while(last + 1 < fields.size() && isInteger(fields[f]) && isInteger(fields[last + 1]))
+            last++;
+        if(last + 1 - f >= minSelectionSize)
+        {
+            auto start = static_cast<size_t>(fields[f].data() - cmd.data());
+            auto end = static_cast<size_t>(fields[last].data() - cmd.data()) + fields[last].size();
+            arguments.emplace_back(JournalArgument::INTERNED, std::string_view(cmd).substr(start, end - start));
+            pattern += argumentMarker;
+            f = last;
+        }
+        else if(isNumber(fields[f]))
+        {
+            arguments.emplace_back(JournalArgument::INLINE, fields[f]);
+            pattern += argumentMarker;
+        }
+        else
+            pattern += fields[f];
+    }
+
+    // The strings are defined before the record referencing them. If the table is reset in the middle,
+    // the strings interned before are defined again.
+    uint64_t patternId = 0;
+    std::vector<uint64_t> ids(arguments.size(), 0);
+    uint64_t nbResets = 0;
+    do
+    {
+        nbResets = m_nbResets;
+        patternId = intern(pattern);
+        for(size_t a = 0; a < arguments.size(); ++a)
+        {
+            if(arguments[a].first == JournalArgument::INTERNED)
+                ids[a] = intern(std::string(arguments[a].second));
+        }
+    } while(nbResets != m_nbResets);
+
+    m_buffer.push_back(static_cast<uint8_t>(JournalRecord::COMMAND));
+    writeVarint(patternId);
+    writeVarint(arguments.size());
+    for(size_t a = 0; a < arguments.size(); ++a)
+    {
+        m_buffer.push_back(static_cast<uint8_t>(arguments[a].first));
+        if(arguments[a].first == JournalArgument::INTERNED)
+            writeVarint(ids[a]);
+        else
+            writeBytes(arguments[a].second);
+    }
+
+    if(m_buffer.size() >= m_bufferSize)
+        flush();
+}
+
+void radahn::core::CommandJournalWriter::appendScript(const std::string& content)
+{
+    if(!isOpen())
+        return;
+
+    auto id = intern(content);
+    m_buffer.push_back(static_cast<uint8_t>(JournalRecord::SCRIPT));
+    writeVarint(id);
+
+    if(m_buffer.size() >= m_bufferSize)
+        flush();
+}
+
+void radahn::core::CommandJournalWriter::appendBlob(const std::string& tag, std::span<const uint8_t> payload)
+{
+    if(!isOpen())
+        return;
+
+    uint64_t tagId = 0;
+    uint64_t payloadId = 0;
+    uint64_t nbResets = 0;
+    do
+    {
+        nbResets = m_nbResets;
+        tagId = intern(tag);
+        payloadId = intern(std::string(payload.begin(), payload.end()));
+    } while(nbResets != m_nbResets);
+    m_buffer.push_back(static_cast<uint8_t>(JournalRecord::BLOB));
+    writeVarint(tagId);
+    writeVarint(payloadId);
+
+    if(m_buffer.size() >= m_bufferSize)
+        flush();
+}
+
+void radahn::core::CommandJournalWriter::flush()
+{
+    if(!isOpen() || m_buffer.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(std::move(m_buffer));
+    }
+    m_cv.notify_one();
+
+    m_buffer = std::vector<uint8_t>();
+    m_buffer.reserve(m_bufferSize);
+}
+
+void radahn::core::CommandJournalWriter::close()
+{
+    if(!isOpen())
+        return;
+
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+    m_file.close();
+}
+
+uint64_t radahn::core::CommandJournalWriter::intern(const std::string& value)
+{
+    auto it = m_strings.find(value);
+    if(it != m_strings.end())
+        return it->second;
+
+    if(m_strings.size() >= m_maxStrings)
+    {
+        m_buffer.push_back(static_cast<uint8_t>(JournalRecord::RESET));
+        m_strings.clear();
+        m_nbResets++;
+    }
+
+    uint64_t id = m_strings.size();
+    m_strings.emplace(value, id);
+
+    m_buffer.push_back(static_cast<uint8_t>(JournalRecord::STRING));
+    writeVarint(id);
+    writeBytes(value);
+    return id;
+}
+
+void radahn::core::CommandJournalWriter::writeBytes(std::string_view value)
+{
+    writeVarint(value.size());
+    m_buffer.insert(m_buffer.end(), value.begin(), value.end());
+}
+
+void radahn::core::CommandJournalWriter::writeVarint(uint64_t value)
+{
+    while(value >= 0x80)
+    {
+        m_buffer.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    m_buffer.push_back(static_cast<uint8_t>(value));
+}
+
+void radahn::core::CommandJournalWriter::run()
+{
+    while(true)
+    {
+        std::vector<uint8_t> data;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_stop || !m_pending.empty(); });
+            if(m_pending.empty())
+                return;
+            data = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+
+        m_file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        m_file.flush();
+    }
+}
+
+bool radahn::core::CommandJournalReader::open(const std::string& path)
+{
+    m_file.open(path, std::ios::binary);
+    if(!m_file.is_open())
+    {
+        spdlog::error("Unable to open the command journal {}.", path);
+        return false;
+    }
+
+    std::array<char, 8> magic;
+    uint32_t version = 0;
+    m_file.read(magic.data(), magic.size());
+    m_file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if(!m_file || magic != journalMagic)
+    {
+        spdlog::error("The file {} is not a command journal.", path);
+        return false;
+    }
+    if(version != journalVersion)
+    {
+        spdlog::error("Unsupported command journal version {}.", version);
+        return false;
+    }
+
+    m_strings.clear();
+    return true;
+}
+
+bool radahn::core::CommandJournalReader::next(JournalEntry& entry)
+{
+    while(true)
+    {
+        char type = 0;
+        if(!m_file.get(type))
+            return false;
+
+        switch(JournalRecord(static_cast<uint8_t>(type)))
+        {
+            case JournalRecord::STRING:
+            {
+                uint64_t id = 0;
+                std::string value;
+                if(!readString(id, value))
+                    return false;
+                if(id != m_strings.size())
+                {
+                    spdlog::error("Unexpected string id {} in the command journal.", id);
+                    return false;
+                }
+                m_strings.push_back(std::move(value));
+                break;
+            }
+            case JournalRecord::RESET:
+            {
+                m_strings.clear();
+                break;
+            }
+            case JournalRecord::COMMAND:
+            {
+                entry.type = JournalRecord::COMMAND;
+                entry.tag.clear();
+                return readCommand(entry.content);
+            }
+            case JournalRecord::SCRIPT:
+            {
+                uint64_t id = 0;
+                entry.type = JournalRecord::SCRIPT;
+                entry.tag.clear();
+                return readVarint(id) && resolve(id, entry.content);
+            }
+            case JournalRecord::BLOB:
+            {
+                uint64_t tagId = 0;
+                uint64_t payloadId = 0;
+                entry.type = JournalRecord::BLOB;
+                return readVarint(tagId) && readVarint(payloadId) && resolve(tagId, entry.tag) && resolve(payloadId, entry.content);
+            }
+            default:
+            {
+                spdlog::error("Unknown record type {} in the command journal.", static_cast<uint32_t>(static_cast<uint8_t>(type)));
+                return false;
+            }
+        }
+    }
+}
+
+bool radahn::core::CommandJournalReader::readVarint(uint64_t& value)
+{
+    value = 0;
+    for(uint32_t shift = 0; shift < 64; shift += 7)
+    {
+        char byte = 0;
+        if(!m_file.get(byte))
+        {
+            spdlog::error("The command journal ends in the middle of a record.");
+            return false;
+        }
+        auto bits = static_cast<uint8_t>(byte);
+        value |= static_cast<uint64_t>(bits & 0x7F) << shift;
+        if((bits & 0x80) == 0)
+            return true;
+    }
+
+    spdlog::error("Invalid integer in the command journal.");
+    return false;
+}
+
+bool radahn::core::CommandJournalReader::readBytes(std::string& value)
+{
+    uint64_t size = 0;
+    if(!readVarint(size))
+        return false;
+
+    value.resize(size);
+    if(!m_file.read(value.data(), static_cast<std::streamsize>(size)))
+    {
+        spdlog::error("The command journal ends in the middle of a string.");
+        return false;
+    }
+    return true;
+}
+
+bool radahn::core::CommandJournalReader::readString(uint64_t& id, std::string& value)
+{
+    return readVarint(id) && readBytes(value);
+}
+
+bool radahn::core::CommandJournalReader::readCommand(std::string& command)
+{
+    uint64_t patternId = 0;
+    uint64_t nbArguments = 0;
+    std::string pattern;
+    if(!readVarint(patternId) || !resolve(patternId, pattern) || !readVarint(nbArguments))
+        return false;
+
+    command.clear();
+    size_t start = 0;
+    for(uint64_t a = 0; a < nbArguments; ++a)
+    {
+        char kind = 0;
+        std::string argument;
+        if(!m_file.get(kind))
+        {
+            spdlog::error("The command journal ends in the middle of a record.");
+            return false;
+        }
+        if(JournalArgument(static_cast<uint8_t>(kind)) == JournalArgument::INTERNED)
+        {
+            uint64_t id = 0;
+            if(!readVarint(id) || !resolve(id, argument))
+                return false;
+        }
+        else if(!readBytes(argument))
+            return false;
+
+        auto marker = pattern.find(argumentMarker, start);
+        if(marker == std::string::npos)
+        {
+            spdlog::error("The command template {} has less arguments than its command.", patternId);
+            return false;
+        }
+        command.append(pattern, start, marker - start);
+        command += argument;
+        start = marker + 1;
+    }
+    command.append(pattern, start, std::string::npos);
+    return true;
+}
+
+bool radahn::core::CommandJournalReader::resolve(uint64_t id, std::string& value) const
+{
+    if(id >= m_strings.size())
+    {
+        spdlog::error("Reference to the undefined string {} in the command journal.", id);
+        return false;
+    }
+    value = m_strings[id];
+    return true;
+}
@@ -0,0 +1,205 @@
+#include <radahn/core/deltaCodec.h>
+
+#include <bit>
+#include <algorithm>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+
+size_t getWordSize(const conduit::DataType& dtype)
+{
+    if(dtype.is_float64())
+        return 8;
+    if(dtype.is_float32())
+        return 4;
+    if(dtype.is_uint16())
+        return 2;
+    return 0;
+}
+
+uint64_t readWord(const conduit::Node& values, size_t wordSize, size_t index)
+{
+    switch(wordSize)
+    {
+        case 8:
+            return std::bit_cast<uint64_t>(values.as_float64_ptr()[index]);
+        case 4:
+            return std::bit_cast<uint32_t>(values.as_float32_ptr()[index]);
+        default:
+            return values.as_uint16_ptr()[index];
+    }
+}
+
+uint8_t significantBytes(uint64_t word)
+{
+    return static_cast<uint8_t>((64 - std::countl_zero(word) + 7) / 8);
+}
+
+// Make the node a compact array of the data type, keeping its memory if it already is one
+template<typename T>
+T* resizeArray(conduit::Node& node, const conduit::DataType& dtype)
+{
+    if(node.dtype().id() != dtype.id() || node.dtype().number_of_elements() != dtype.number_of_elements() || !node.dtype().is_compact())
+        node.set(dtype);
+    return static_cast<T*>(node.element_ptr(0));
+}
+
+} // namespace
+
+void radahn::core::DeltaEncoder::encode(const atomIndexes_t* ids, size_t nbAtoms, const conduit::Node& values, conduit::Node& dest)
+{
+    size_t wordSize = getWordSize(values.dtype());
+    if(wordSize == 0)
+        throw std::invalid_argument("Unsupported data type given to DeltaEncoder::encode: " + values.dtype().name());
+
+    bool keyframe = m_keyframeEvery > 0 && m_nbFrames % m_keyframeEvery == 0;
+
+    auto & useReference = m_useReference;
+    auto & sizes = m_sizes;
+    auto & payload = m_payload;
+    useReference.assign(nbAtoms, 0);
+    sizes.assign((3*nbAtoms + 1) / 2, 0);
+    payload.clear();
+    payload.reserve(3*nbAtoms*wordSize);
+
+    for(size_t i = 0; i < nbAtoms; ++i)
+    {
+        size_t id = ids[i];
+        if(id >= m_lastFrame.size())
+        {
+            m_lastFrame.resize(id + 1, 0);
+            m_reference.resize(3*(id + 1), 0);
+        }
+
+        // The reference is only shared with the decoder if this rank sent the atom in the previous frame
+        bool hasReference = !keyframe && m_lastFrame[id] > 0 && m_lastFrame[id] == m_nbFrames;
+        useReference[i] = hasReference ? 1 : 0;
+
+        for(size_t c = 0; c < 3; ++c)
+        {
+            size_t component = 3*i + c;
+            uint64_t word = readWord(values, wordSize, component);
+            uint64_t delta = hasReference ? word ^ m_reference[3*id + c] : word;
+            m_reference[3*id + c] = word;
+
+            uint8_t nbBytes = significantBytes(delta);
+            sizes[component / 2] |= static_cast<uint8_t>(nbBytes << (4 * (component % 2)));
+            for(uint8_t b = 0; b < nbBytes; ++b)
+                payload.push_back(static_cast<uint8_t>(delta >> (8 * b)));
+        }
+        m_lastFrame[id] = m_nbFrames + 1;
+    }
+    m_nbFrames++;
+
+    dest["wordSize"] = static_cast<uint8_t>(wordSize);
+    dest["keyframe"] = static_cast<uint8_t>(keyframe ? 1 : 0);
+    std::copy(useReference.begin(), useReference.end(), resizeArray<uint8_t>(dest["reference"], conduit::DataType::uint8(static_cast<conduit::index_t>(useReference.size()))));
+    std::copy(sizes.begin(), sizes.end(), resizeArray<uint8_t>(dest["sizes"], conduit::DataType::uint8(static_cast<conduit::index_t>(sizes.size()))));
+    std::copy(payload.begin(), payload.end(), resizeArray<uint8_t>(dest["payload"], conduit::DataType::uint8(static_cast<conduit::index_t>(payload.size()))));
+}
+
+bool radahn::core::DeltaDecoder::decode(const atomIndexes_t* ids, size_t nbAtoms, const conduit::Node& src, conduit::Node& values)
+{
+    if(!src.has_child("wordSize") || !src.has_child("reference") || !src.has_child("sizes") || !src.has_child("payload"))
+    {
+        spdlog::error("Incomplete delta encoded field received.");
+        return false;
+    }
+
+    // Every array is checked before being read, a truncated message must not be read past its end
+    size_t wordSize = src["wordSize"].as_uint8();
+    if(wordSize != 8 && wordSize != 4 && wordSize != 2)
+    {
+        spdlog::error("Unsupported word size {} in a delta encoded field.", wordSize);
+        return false;
+    }
+    if(static_cast<size_t>(src["reference"].dtype().number_of_elements()) < nbAtoms
+        || static_cast<size_t>(src["sizes"].dtype().number_of_elements()) < (3*nbAtoms + 1) / 2)
+    {
+        spdlog::error("Delta encoded field received with less entries than its {} atoms.", nbAtoms);
+        return false;
+    }
+
+    const uint8_t* useReference = src["reference"].as_uint8_ptr();
+    const uint8_t* sizes = src["sizes"].as_uint8_ptr();
+    const uint8_t* payload = src["payload"].as_uint8_ptr();
+    auto payloadSize = static_cast<size_t>(src["payload"].dtype().number_of_elements());
+
+    // The references are only updated once the whole field is decoded, a rejected message leaves the decoder unchanged
+    auto & words = m_words;
+    words.resize(3*nbAtoms);
+    size_t offset = 0;
+    for(size_t i = 0; i < nbAtoms; ++i)
+    {
+        size_t id = ids[i];
+        bool known = id < m_known.size() && m_known[id] > 0;
+        if(useReference[i] > 0 && !known)
+        {
+            spdlog::error("Received a delta for the atom {} without any previous value.", id);
+            return false;
+        }
+
+        for(size_t c = 0; c < 3; ++c)
+        {
+            size_t component = 3*i + c;
+            size_t nbBytes = (sizes[component / 2] >> (4 * (component % 2))) & 0xF;
+            if(nbBytes > wordSize || offset + nbBytes > payloadSize)
+            {
+                spdlog::error("Delta encoded payload is shorter than expected.");
+                return false;
+            }
+
+            uint64_t delta = 0;
+            for(size_t b = 0; b < nbBytes; ++b)
+                delta |= static_cast<uint64_t>(payload[offset + b]) << (8 * b);
+            offset += nbBytes;
+
+            words[component] = useReference[i] > 0 ? delta ^ m_reference[3*id + c] : delta;
+        }
+    }
+
+    for(size_t i = 0; i < nbAtoms; ++i)
+    {
+        size_t id = ids[i];
+        if(id >= m_known.size())
+        {
+            m_known.resize(id + 1, 0);
+            m_reference.resize(3*(id + 1), 0);
+        }
+        for(size_t c = 0; c < 3; ++c)
+            m_reference[3*id + c] = words[3*i + c];
+        m_known[id] = 1;
+    }
+
+    auto nbValues = static_cast<conduit::index_t>(words.size());
+    switch(wordSize)
+    {
+        case 8:
+        {
+            double* decoded = resizeArray<double>(values, conduit::DataType::float64(nbValues));
+            for(size_t i = 0; i < words.size(); ++i)
+                decoded[i] = std::bit_cast<double>(words[i]);
+            return true;
+        }
+        case 4:
+        {
+            float* decoded = resizeArray<float>(values, conduit::DataType::float32(nbValues));
+            for(size_t i = 0; i < words.size(); ++i)
+                decoded[i] = std::bit_cast<float>(static_cast<uint32_t>(words[i]));
+            return true;
+        }
+        case 2:
+        {
+            uint16_t* decoded = resizeArray<uint16_t>(values, conduit::DataType::uint16(nbValues));
+            for(size_t i = 0; i < words.size(); ++i)
+                decoded[i] = static_cast<uint16_t>(words[i]);
+            return true;
+        }
+    }
+
+    spdlog::error("Unsupported word size {} in a delta encoded field.", wordSize);
+    return false;
+}
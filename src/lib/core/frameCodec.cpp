@@ -0,0 +1,145 @@
+#include <radahn/core/frameCodec.h>
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+
+constexpr std::array<char, 8> frameMagic = {'R', 'D', 'H', 'N', 'F', 'R', 'M', 'E'};
+
+template<typename T>
+void writeLE(uint8_t* dst, T value)
+{
+    std::memcpy(dst, &value, sizeof(T));
+    if constexpr (std::endian::native == std::endian::big)
+        std::reverse(dst, dst + sizeof(T));
+}
+
+template<typename T>
+T readLE(const uint8_t* src)
+{
+    std::array<uint8_t, sizeof(T)> bytes;
+    std::memcpy(bytes.data(), src, sizeof(T));
+    if constexpr (std::endian::native == std::endian::big)
+        std::reverse(bytes.begin(), bytes.end());
+
+    T value;
+    std::memcpy(&value, bytes.data(), sizeof(T));
+    return value;
+}
+
+// The values are copied as a block on little-endian hosts
+template<typename T>
+void writeValues(uint8_t* dst, const std::vector<radahn::core::atomPositions_t>& positions)
+{
+    if constexpr (std::endian::native == std::endian::little && std::is_same_v<T, radahn::core::atomPositions_t>)
+        std::memcpy(dst, positions.data(), positions.size() * sizeof(T));
+    else
+    {
+        for(size_t i = 0; i < positions.size(); ++i)
+            writeLE<T>(dst + i * sizeof(T), static_cast<T>(positions[i]));
+    }
+}
+
+template<typename T>
+void readValues(const uint8_t* src, size_t nbValues, std::vector<radahn::core::atomPositions_t>& outPositions)
+{
+    auto offset = outPositions.size();
+    outPositions.resize(offset + nbValues);
+    if constexpr (std::endian::native == std::endian::little && std::is_same_v<T, radahn::core::atomPositions_t>)
+        std::memcpy(outPositions.data() + offset, src, nbValues * sizeof(T));
+    else
+    {
+        for(size_t i = 0; i < nbValues; ++i)
+            outPositions[offset + i] = static_cast<radahn::core::atomPositions_t>(readLE<T>(src + i * sizeof(T)));
+    }
+}
+
+} // namespace
+
+bool radahn::core::encodePositionsFrame(simIt_t it, const std::vector<atomPositions_t>& positions, PositionEncoding dtype, std::vector<uint8_t>& out)
+{
+    size_t valueSize = 0;
+    switch(dtype)
+    {
+        case PositionEncoding::FLOAT64:
+            valueSize = sizeof(double);
+            break;
+        case PositionEncoding::FLOAT32:
+            valueSize = sizeof(float);
+            break;
+        default:
+            spdlog::error("The encoding {} is not supported by the binary frames.", to_string(dtype));
+            return false;
+    }
+
+    out.resize(frameHeaderSize + positions.size() * valueSize);
+    uint8_t* header = out.data();
+    std::memcpy(header, frameMagic.data(), frameMagic.size());
+    writeLE<uint16_t>(header + 8, frameSchemaVersion);
+    header[10] = static_cast<uint8_t>(FrameKind::POSITIONS);
+    header[11] = static_cast<uint8_t>(dtype);
+    writeLE<uint32_t>(header + 12, 0);
+    writeLE<uint64_t>(header + 16, it);
+    writeLE<uint64_t>(header + 24, positions.size() / 3);
+
+    if(dtype == PositionEncoding::FLOAT64)
+        writeValues<double>(out.data() + frameHeaderSize, positions);
+    else
+        writeValues<float>(out.data() + frameHeaderSize, positions);
+    return true;
+}
+
+bool radahn::core::decodePositionsFrame(std::span<const uint8_t> frame, simIt_t& it, std::vector<atomPositions_t>& outPositions)
+{
+    if(frame.size() < frameHeaderSize || std::memcmp(frame.data(), frameMagic.data(), frameMagic.size()) != 0)
+    {
+        spdlog::error("The message is not a Radahn frame.");
+        return false;
+    }
+
+    const uint8_t* header = frame.data();
+    auto version = readLE<uint16_t>(header + 8);
+    if(version != frameSchemaVersion)
+    {
+        spdlog::error("Unsupported frame schema version {}.", version);
+        return false;
+    }
+    if(header[10] != static_cast<uint8_t>(FrameKind::POSITIONS))
+    {
+        spdlog::error("Unsupported frame kind {}.", header[10]);
+        return false;
+    }
+
+    auto dtype = PositionEncoding(header[11]);
+    size_t valueSize = 0;
+    if(dtype == PositionEncoding::FLOAT64)
+        valueSize = sizeof(double);
+    else if(dtype == PositionEncoding::FLOAT32)
+        valueSize = sizeof(float);
+    else
+    {
+        spdlog::error("Unsupported frame dtype {}.", header[11]);
+        return false;
+    }
+
+    it = readLE<uint64_t>(header + 16);
+    auto nbValues = 3 * readLE<uint64_t>(header + 24);
+    if(frame.size() != frameHeaderSize + nbValues * valueSize)
+    {
+        spdlog::error("The frame of the step {} has {} bytes, expected {}.", it, frame.size(), frameHeaderSize + nbValues * valueSize);
+        return false;
+    }
+
+    if(dtype == PositionEncoding::FLOAT64)
+        readValues<double>(header + frameHeaderSize, nbValues, outPositions);
+    else
+        readValues<float>(header + frameHeaderSize, nbValues, outPositions);
+    return true;
+}
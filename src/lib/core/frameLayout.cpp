@@ -0,0 +1,25 @@
+#include <radahn/core/frameLayout.h>
+
+#include <algorithm>
+#include <numeric>
+
+bool radahn::core::computeSortedOrder(const atomIndexes_t* ids, size_t nbAtoms, std::vector<size_t>& order)
+{
+    // Each ID appears once, IDs within 1..nbAtoms are a permutation of it
+    order.resize(nbAtoms);
+    bool dense = true;
+    for(size_t i = 0; i < nbAtoms && dense; ++i)
+    {
+        dense = ids[i] >= 1 && ids[i] <= nbAtoms;
+        order[i] = static_cast<size_t>(ids[i]) - 1;
+    }
+    if(dense)
+        return true;
+
+    std::vector<size_t> perm(nbAtoms);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::sort(perm.begin(), perm.end(), [ids](size_t a, size_t b){ return ids[a] < ids[b]; });
+    for(size_t i = 0; i < nbAtoms; ++i)
+        order[perm[i]] = i;
+    return false;
+}
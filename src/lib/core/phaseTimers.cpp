@@ -0,0 +1,47 @@
+#include <radahn/core/phaseTimers.h>
+
+#include <spdlog/spdlog.h>
+
+// The entries of the maps are kept once created so that the steady state loop doesn't allocate.
+// A phase which is not running has a default start time.
+void radahn::core::PhaseTimers::start(const std::string& phase)
+{
+    m_started[phase] = clock::now();
+}
+
+void radahn::core::PhaseTimers::stop(const std::string& phase)
+{
+    auto end = clock::now();
+    auto started = m_started.find(phase);
+    if(started == m_started.end() || started->second == clock::time_point())
+    {
+        spdlog::warn("The timer of the phase {} is stopped but was not started.", phase);
+        return;
+    }
+
+    m_durations[phase] += std::chrono::duration<double>(end - started->second).count();
+    started->second = clock::time_point();
+}
+
+double radahn::core::PhaseTimers::get(const std::string& phase) const
+{
+    auto duration = m_durations.find(phase);
+    return duration != m_durations.end() ? duration->second : 0.0;
+}
+
+void radahn::core::PhaseTimers::exportTo(conduit::Node& node, const std::string& prefix) const
+{
+    // The key buffer keeps its capacity, add_child doesn't split the name as a path
+    for(auto & [phase, duration] : m_durations)
+    {
+        m_key.assign(prefix);
+        m_key.append(phase);
+        node.add_child(m_key) = duration;
+    }
+}
+
+void radahn::core::PhaseTimers::clear()
+{
+    for(auto & [phase, duration] : m_durations)
+        duration = 0.0;
+}
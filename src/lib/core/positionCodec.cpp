@@ -0,0 +1,175 @@
+#include <radahn/core/positionCodec.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <array>
+
+#include <spdlog/spdlog.h>
+
+uint64_t radahn::core::encodePositions(
+    PositionEncoding encoding,
+    const atomPositions_t* positions,
+    uint64_t nbAtoms,
+    const double boxLo[3],
+    const double boxHi[3],
+    conduit::Node& simData)
+{
+    // The values are written in the memory of the nodes, which is reused when simData is kept between two frames
+    // with the same number of atoms.
+    uint64_t nbClamped = 0;
+    simData.add_child("positionEncoding") = static_cast<uint8_t>(encoding);    // Not split as a path, no copy of the name
+
+    auto nbValues = static_cast<conduit::index_t>(3*nbAtoms);
+    auto & posNode = simData["atomPositions"];
+    switch(encoding)
+    {
+        case PositionEncoding::FLOAT64:
+        {
+            posNode.set(positions, nbValues);
+            break;
+        }
+        case PositionEncoding::FLOAT32:
+        {
+            posNode.set(conduit::DataType::float32(nbValues));
+            float* encoded = posNode.as_float32_ptr();
+            for(size_t i = 0; i < 3*nbAtoms; ++i)
+                encoded[i] = static_cast<float>(positions[i]);
+            break;
+        }
+        case PositionEncoding::FIXED16:
+        {
+            constexpr double maxValue = static_cast<double>(std::numeric_limits<uint16_t>::max());
+            std::array<double, 3> scale;
+            std::array<double, 3> offset;
+            for(size_t axis = 0; axis < 3; ++axis)
+            {
+                offset[axis] = boxLo[axis];
+                double extent = boxHi[axis] - boxLo[axis];
+                scale[axis] = extent > 0.0 ? extent / maxValue : 1.0;
+            }
+
+            posNode.set(conduit::DataType::uint16(nbValues));
+            uint16_t* encoded = posNode.as_uint16_ptr();
+            for(size_t i = 0; i < nbAtoms; ++i)
+            {
+                for(size_t axis = 0; axis < 3; ++axis)
+                {
+                    double value = std::round((positions[3*i+axis] - offset[axis]) / scale[axis]);
+                    if(value < 0.0 || value > maxValue)
+                    {
+                        value = std::clamp(value, 0.0, maxValue);
+                        nbClamped++;
+                    }
+                    encoded[3*i+axis] = static_cast<uint16_t>(value);
+                }
+            }
+            simData["positionScale"].set(scale.data(), 3);
+            simData["positionOffset"].set(offset.data(), 3);
+            break;
+        }
+    }
+
+    return nbClamped;
+}
+
+bool radahn::core::decodePositions(const conduit::Node& simData, std::vector<atomPositions_t>& outPositions)
+{
+    auto encoding = PositionEncoding::FLOAT64;
+    if(simData.has_child("positionEncoding"))
+        encoding = PositionEncoding(simData.child("positionEncoding").as_uint8());
+
+    auto & posNode = simData["atomPositions"];
+    auto nbValues = static_cast<size_t>(posNode.dtype().number_of_elements());
+
+    switch(encoding)
+    {
+        case PositionEncoding::FLOAT64:
+        {
+            const double* positions = posNode.as_float64_ptr();
+            outPositions.insert(outPositions.end(), positions, positions + nbValues);
+            return true;
+        }
+        case PositionEncoding::FLOAT32:
+        {
+            const float* positions = posNode.as_float32_ptr();
+            for(size_t i = 0; i < nbValues; ++i)
+                outPositions.push_back(static_cast<atomPositions_t>(positions[i]));
+            return true;
+        }
+        case PositionEncoding::FIXED16:
+        {
+            if(!simData.has_child("positionScale") || !simData.has_child("positionOffset"))
+            {
+                spdlog::error("Received fixed16 positions without their scale and offset.");
+                return false;
+            }
+            const uint16_t* positions = posNode.as_uint16_ptr();
+            const double* scale = simData["positionScale"].as_float64_ptr();
+            const double* offset = simData["positionOffset"].as_float64_ptr();
+            for(size_t i = 0; i < nbValues; ++i)
+                outPositions.push_back(offset[i%3] + static_cast<double>(positions[i]) * scale[i%3]);
+            return true;
+        }
+    }
+
+    spdlog::error("Unknown position encoding {} received.", static_cast<uint32_t>(encoding));
+    return false;
+}
+
+bool radahn::core::scatterPositions(const conduit::Node& simData, const atomIndexes_t* ids, uint64_t nbAtoms, atomPositions_t* outPositions)
+{
+    auto encoding = PositionEncoding::FLOAT64;
+    if(simData.has_child("positionEncoding"))
+        encoding = PositionEncoding(simData.child("positionEncoding").as_uint8());
+
+    auto & posNode = simData["atomPositions"];
+    if(static_cast<uint64_t>(posNode.dtype().number_of_elements()) != 3*nbAtoms)
+    {
+        spdlog::error("Received {} coordinates for {} atoms.", posNode.dtype().number_of_elements(), nbAtoms);
+        return false;
+    }
+
+    // Lammps indices are 1-based
+    auto scatter = [&](auto decode)
+    {
+        for(uint64_t i = 0; i < nbAtoms; ++i)
+        {
+            auto dst = outPositions + 3*(static_cast<uint64_t>(ids[i])-1);
+            for(uint64_t axis = 0; axis < 3; ++axis)
+                dst[axis] = decode(3*i+axis, axis);
+        }
+    };
+
+    switch(encoding)
+    {
+        case PositionEncoding::FLOAT64:
+        {
+            const double* positions = posNode.as_float64_ptr();
+            scatter([positions](uint64_t i, uint64_t) { return positions[i]; });
+            return true;
+        }
+        case PositionEncoding::FLOAT32:
+        {
+            const float* positions = posNode.as_float32_ptr();
+            scatter([positions](uint64_t i, uint64_t) { return static_cast<atomPositions_t>(positions[i]); });
+            return true;
+        }
+        case PositionEncoding::FIXED16:
+        {
+            if(!simData.has_child("positionScale") || !simData.has_child("positionOffset"))
+            {
+                spdlog::error("Received fixed16 positions without their scale and offset.");
+                return false;
+            }
+            const uint16_t* positions = posNode.as_uint16_ptr();
+            const double* scale = simData["positionScale"].as_float64_ptr();
+            const double* offset = simData["positionOffset"].as_float64_ptr();
+            scatter([=](uint64_t i, uint64_t axis) { return offset[axis] + static_cast<double>(positions[i]) * scale[axis]; });
+            return true;
+        }
+    }
+
+    spdlog::error("Unknown position encoding {} received.", static_cast<uint32_t>(encoding));
+    return false;
+}
@@ -0,0 +1,245 @@
+#include <radahn/core/shmFrameRing.h>
+
+#include <new>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+
+constexpr uint64_t ringMagic = 0x474E49524E484452;     // "RDHNRING"
+constexpr uint32_t ringVersion = 2;
+constexpr size_t slotAlignment = 64;
+
+constexpr size_t alignUp(size_t value)
+{
+    return (value + slotAlignment - 1) / slotAlignment * slotAlignment;
+}
+
+// Names of the segments created by this process and not removed yet, removed by an exit handler
+// when the process exits without destroying its rings
+std::mutex ownedSegmentsMutex;
+std::vector<std::string> ownedSegments;
+
+void unlinkOwnedSegments()
+{
+    std::lock_guard<std::mutex> lock(ownedSegmentsMutex);
+    for(auto & name : ownedSegments)
+        shm_unlink(name.c_str());
+    ownedSegments.clear();
+}
+
+void registerOwnedSegment(const std::string& name)
+{
+    static bool handlerRegistered = false;
+    std::lock_guard<std::mutex> lock(ownedSegmentsMutex);
+    if(!handlerRegistered)
+    {
+        std::atexit(&unlinkOwnedSegments);
+        handlerRegistered = true;
+    }
+    ownedSegments.push_back(name);
+}
+
+void unregisterOwnedSegment(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(ownedSegmentsMutex);
+    ownedSegments.erase(std::remove(ownedSegments.begin(), ownedSegments.end(), name), ownedSegments.end());
+}
+
+} // namespace
+
+radahn::core::ShmFrameRing::ShmFrameRing(const std::string& name, void* segment, size_t segmentSize, bool owner) :
+    m_name(name),
+    m_segment(segment),
+    m_segmentSize(segmentSize),
+    m_owner(owner),
+    m_header(static_cast<ShmRingHeader*>(segment))
+{
+}
+
+radahn::core::ShmFrameRing::~ShmFrameRing()
+{
+    munmap(m_segment, m_segmentSize);
+    unlink();
+}
+
+void radahn::core::ShmFrameRing::unlink()
+{
+    if(!m_owner)
+        return;
+    shm_unlink(m_name.c_str());
+    unregisterOwnedSegment(m_name);
+    m_owner = false;
+}
+
+std::unique_ptr<radahn::core::ShmFrameRing> radahn::core::ShmFrameRing::create(const std::string& name, uint32_t nbSlots, uint64_t slotSize)
+{
+    slotSize = alignUp(slotSize);
+    size_t segmentSize = alignUp(sizeof(ShmRingHeader)) + nbSlots * slotSize;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if(fd < 0)
+    {
+        spdlog::error("Unable to create the shared memory segment {}.", name);
+        return nullptr;
+    }
+    if(ftruncate(fd, static_cast<off_t>(segmentSize)) != 0)
+    {
+        spdlog::error("Unable to allocate {} bytes for the shared memory segment {}.", segmentSize, name);
+        close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    void* segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(segment == MAP_FAILED)
+    {
+        spdlog::error("Unable to map the shared memory segment {}.", name);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    // The magic is written last, a reader opening the segment before ignores it
+    auto header = new (segment) ShmRingHeader();
+    header->version = ringVersion;
+    header->nbSlots = nbSlots;
+    header->slotSize = slotSize;
+    header->writeSeq.store(0);
+    header->readSeq.store(0);
+    header->readerPid.store(0);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = ringMagic;
+
+    registerOwnedSegment(name);
+    return std::unique_ptr<ShmFrameRing>(new ShmFrameRing(name, segment, segmentSize, true));
+}
+
+std::unique_ptr<radahn::core::ShmFrameRing> radahn::core::ShmFrameRing::open(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if(fd < 0)
+        return nullptr;
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ShmRingHeader))
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    auto segmentSize = static_cast<size_t>(info.st_size);
+    void* segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(segment == MAP_FAILED)
+        return nullptr;
+
+    auto header = static_cast<ShmRingHeader*>(segment);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(header->magic != ringMagic || header->version != ringVersion
+        || segmentSize < alignUp(sizeof(ShmRingHeader)) + header->nbSlots * header->slotSize)
+    {
+        spdlog::error("The shared memory segment {} is not a frame ring.", name);
+        munmap(segment, segmentSize);
+        return nullptr;
+    }
+
+    header->readerPid.store(static_cast<int64_t>(getpid()), std::memory_order_release);
+    return std::unique_ptr<ShmFrameRing>(new ShmFrameRing(name, segment, segmentSize, false));
+}
+
+uint64_t radahn::core::ShmFrameRing::getSlotSize() const
+{
+    return m_header->slotSize;
+}
+
+uint8_t* radahn::core::ShmFrameRing::getSlot(uint64_t seq)
+{
+    return static_cast<uint8_t*>(m_segment) + alignUp(sizeof(ShmRingHeader)) + (seq % m_header->nbSlots) * m_header->slotSize;
+}
+
+bool radahn::core::ShmFrameRing::isReaderAlive() const
+{
+    auto pid = m_header->readerPid.load(std::memory_order_acquire);
+    return pid == 0 || kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+}
+
+radahn::core::ShmFrameRing::WriteStatus radahn::core::ShmFrameRing::write(const conduit::Node& node, uint64_t& seq, std::string& schema)
+{
+    conduit::Schema compactSchema;
+    node.schema().compact_to(compactSchema);
+    if(static_cast<uint64_t>(compactSchema.total_bytes_compact()) > m_header->slotSize)
+        return WriteStatus::TOO_LARGE;
+
+    // The reader releases the frames once processed, it is at most a few frames behind
+    seq = m_header->writeSeq.load(std::memory_order_relaxed);
+    auto waitStart = std::chrono::steady_clock::now();
+    auto nextCheck = waitStart + std::chrono::milliseconds(100);
+    // The reader takes a whole interval to process a frame, the writer backs off up to 1 ms instead of spinning on a core
+    // that Lammps could use
+    auto backoff = std::chrono::microseconds(10);
+    while(seq - m_header->readSeq.load(std::memory_order_acquire) >= m_header->nbSlots)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if(now >= nextCheck)
+        {
+            if(!isReaderAlive())
+            {
+                spdlog::error("The reader of the shared memory ring {} exited without releasing its slots.", m_name);
+                return WriteStatus::READER_GONE;
+            }
+            if(now - waitStart > writeTimeout)
+            {
+                spdlog::error("No slot of the shared memory ring {} was released by the engine in {} s.", m_name, writeTimeout.count());
+                return WriteStatus::READER_GONE;
+            }
+            nextCheck = now + std::chrono::milliseconds(100);
+        }
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(2 * backoff, std::chrono::microseconds(1000));
+    }
+
+    conduit::Node slot;
+    slot.set_external(compactSchema, getSlot(seq));
+    slot.update_compatible(node);
+    schema = compactSchema.to_json();
+
+    m_header->writeSeq.store(seq + 1, std::memory_order_release);
+    return WriteStatus::WRITTEN;
+}
+
+bool radahn::core::ShmFrameRing::view(uint64_t seq, const std::string& schema, conduit::Node& out)
+{
+    if(seq >= m_header->writeSeq.load(std::memory_order_acquire) || seq < m_header->readSeq.load(std::memory_order_relaxed))
+    {
+        spdlog::error("The frame {} is not available in the shared memory ring {}.", seq, m_name);
+        return false;
+    }
+
+    conduit::Schema frameSchema(schema);
+    if(static_cast<uint64_t>(frameSchema.total_bytes_compact()) > m_header->slotSize)
+    {
+        spdlog::error("The frame {} of the shared memory ring {} exceeds its slot.", seq, m_name);
+        return false;
+    }
+    out.set_external(frameSchema, getSlot(seq));
+    return true;
+}
+
+void radahn::core::ShmFrameRing::release(uint64_t seq)
+{
+    m_header->readSeq.store(seq + 1, std::memory_order_release);
+}
@@ -0,0 +1,72 @@
+#include <radahn/core/workerPool.h>
+
+#include <algorithm>
+
+radahn::core::WorkerPool::WorkerPool(size_t nbThreads)
+{
+    m_threads.reserve(nbThreads);
+    for(size_t i = 0; i < nbThreads; ++i)
+        m_threads.emplace_back(&WorkerPool::workerLoop, this, i);
+}
+
+radahn::core::WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for(auto & thread : m_threads)
+        thread.join();
+}
+
+void radahn::core::WorkerPool::runTask(size_t nbWorkers, void* task, void (*call)(void*))
+{
+    size_t nbHelpers = std::min(nbWorkers > 0 ? nbWorkers - 1 : 0, m_threads.size());
+    if(nbHelpers > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = task;
+            m_call = call;
+            m_nbActive = nbHelpers;
+            m_nbRunning = nbHelpers;
+            m_generation++;
+        }
+        m_start.notify_all();
+    }
+
+    call(task);
+
+    if(nbHelpers > 0)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_nbRunning == 0; });
+    }
+}
+
+void radahn::core::WorkerPool::workerLoop(size_t index)
+{
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true)
+    {
+        m_start.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+        if(m_stop)
+            return;
+
+        // The threads which are not needed for this run wait for the next one
+        generation = m_generation;
+        if(index >= m_nbActive)
+            continue;
+
+        auto task = m_task;
+        auto call = m_call;
+        lock.unlock();
+        call(task);
+        lock.lock();
+
+        if(--m_nbRunning == 0)
+            m_done.notify_one();
+    }
+}
@@ -3,6 +3,7 @@
 #include <spdlog/spdlog.h>
 
 #include <ranges>
+#include <algorithm>
 
 using namespace radahn::core;
 
@@ -34,6 +35,17 @@ bool radahn::lmp::MoveLammpsCommand::loadFromConduit(conduit::Node& node)
     auto selectionSpan = std::span<atomIndexes_t>( selection, static_cast<size_t>(nbAtoms));
     m_selection = std::vector<atomIndexes_t>(selectionSpan.begin(), selectionSpan.end());
 
+    if(node.has_child("completion"))
+    {
+        const uint8_t* check = node["completion"]["check"].as_uint8_ptr();
+        const double* distance = node["completion"]["distance"].as_float64_ptr();
+        for(size_t i = 0; i < 3; ++i)
+        {
+            m_check[i] = check[i] > 0;
+            m_distance[i] = distance[i];
+        }
+    }
+
     m_origin = node["origin"].as_char8_str();
     //spdlog::info("Reading the origin {}", m_origin);
 
@@ -45,14 +57,18 @@ bool radahn::lmp::MoveLammpsCommand::writeDoCommands(std::vector<std::string>& c
     // Create the group
     std::stringstream cmd1;
     cmd1<<"group "<<m_origin<<"GRP id";
-    for(auto & id : m_selection)
-        cmd1<<" "<<id;
+    LammpsCommandsUtils::writeIdSelection(cmd1, m_selection);
     cmds.push_back(cmd1.str());
 
     // Create the move command
-    std::stringstream cmd2;
-    cmd2<<"fix "<<m_origin<<"ID "<<m_origin<<"GRP move linear "<<m_vx.m_value<<" "<<m_vy.m_value<<" "<<m_vz.m_value<<"\n";
-    cmds.push_back(cmd2.str());
+    return writeFixCommands(cmds);
+}
+
+bool radahn::lmp::MoveLammpsCommand::writeFixCommands(std::vector<std::string>& cmds) const
+{
+    std::stringstream cmd;
+    cmd<<"fix "<<m_origin<<"ID "<<m_origin<<"GRP move linear "<<m_vx.m_value<<" "<<m_vy.m_value<<" "<<m_vz.m_value<<"\n";
+    cmds.push_back(cmd.str());
 
     return true;
 }
@@ -60,9 +76,7 @@ bool radahn::lmp::MoveLammpsCommand::writeDoCommands(std::vector<std::string>& c
 bool radahn::lmp::MoveLammpsCommand::writeUndoCommands(std::vector<std::string>& cmds) const
 {
     // Undo the fix
-    std::stringstream cmd1;
-    cmd1<<"unfix "<<m_origin<<"ID";
-    cmds.push_back(cmd1.str());
+    writeUnfixCommands(cmds);
 
     // Undo the grp 
     std::stringstream cmd2;
@@ -72,6 +86,15 @@ bool radahn::lmp::MoveLammpsCommand::writeUndoCommands(std::vector<std::string>&
     return true;
 }
 
+bool radahn::lmp::MoveLammpsCommand::writeUnfixCommands(std::vector<std::string>& cmds) const
+{
+    std::stringstream cmd;
+    cmd<<"unfix "<<m_origin<<"ID";
+    cmds.push_back(cmd.str());
+
+    return true;
+}
+
 std::string radahn::lmp::MoveLammpsCommand::getGroupName() const
 {
     std::stringstream ss;
@@ -107,6 +130,17 @@ bool radahn::lmp::AddForceLammpsCommand::loadFromConduit(conduit::Node& node)
     auto selectionSpan = std::span<atomIndexes_t>( selection, static_cast<size_t>(nbAtoms));
     m_selection = std::vector<atomIndexes_t>(selectionSpan.begin(), selectionSpan.end());
 
+    if(node.has_child("completion"))
+    {
+        const uint8_t* check = node["completion"]["check"].as_uint8_ptr();
+        const double* distance = node["completion"]["distance"].as_float64_ptr();
+        for(size_t i = 0; i < 3; ++i)
+        {
+            m_check[i] = check[i] > 0;
+            m_distance[i] = distance[i];
+        }
+    }
+
     m_origin = node["origin"].as_char8_str();
     //spdlog::info("Reading the origin {}", m_origin);
 
@@ -118,14 +152,18 @@ bool radahn::lmp::AddForceLammpsCommand::writeDoCommands(std::vector<std::string
     // Create the group
     std::stringstream cmd1;
     cmd1<<"group "<<m_origin<<"GRP id";
-    for(auto & id : m_selection)
-        cmd1<<" "<<id;
+    LammpsCommandsUtils::writeIdSelection(cmd1, m_selection);
     cmds.push_back(cmd1.str());
 
     // Create the move command
-    std::stringstream cmd2;
-    cmd2<<"fix "<<m_origin<<"ID "<<m_origin<<"GRP addforce "<<m_fx.m_value<<" "<<m_fy.m_value<<" "<<m_fz.m_value<<"\n";
-    cmds.push_back(cmd2.str());
+    return writeFixCommands(cmds);
+}
+
+bool radahn::lmp::AddForceLammpsCommand::writeFixCommands(std::vector<std::string>& cmds) const
+{
+    std::stringstream cmd;
+    cmd<<"fix "<<m_origin<<"ID "<<m_origin<<"GRP addforce "<<m_fx.m_value<<" "<<m_fy.m_value<<" "<<m_fz.m_value<<"\n";
+    cmds.push_back(cmd.str());
 
     return true;
 }
@@ -133,9 +171,7 @@ bool radahn::lmp::AddForceLammpsCommand::writeDoCommands(std::vector<std::string
 bool radahn::lmp::AddForceLammpsCommand::writeUndoCommands(std::vector<std::string>& cmds) const
 {
     // Undo the fix
-    std::stringstream cmd1;
-    cmd1<<"unfix "<<m_origin<<"ID";
-    cmds.push_back(cmd1.str());
+    writeUnfixCommands(cmds);
 
     // Undo the grp 
     std::stringstream cmd2;
@@ -145,6 +181,15 @@ bool radahn::lmp::AddForceLammpsCommand::writeUndoCommands(std::vector<std::stri
     return true;
 }
 
+bool radahn::lmp::AddForceLammpsCommand::writeUnfixCommands(std::vector<std::string>& cmds) const
+{
+    std::stringstream cmd;
+    cmd<<"unfix "<<m_origin<<"ID";
+    cmds.push_back(cmd.str());
+
+    return true;
+}
+
 std::string radahn::lmp::AddForceLammpsCommand::getGroupName() const
 {
     std::stringstream ss;
@@ -191,14 +236,18 @@ bool radahn::lmp::AddTorqueLammpsCommand::writeDoCommands(std::vector<std::strin
     // Create the group
     std::stringstream cmd1;
     cmd1<<"group "<<m_origin<<"GRP id";
-    for(auto & id : m_selection)
-        cmd1<<" "<<id;
+    LammpsCommandsUtils::writeIdSelection(cmd1, m_selection);
     cmds.push_back(cmd1.str());
 
     // Create the move command
-    std::stringstream cmd2;
-    cmd2<<"fix "<<m_origin<<"ID "<<m_origin<<"GRP addtorque "<<m_tx.m_value<<" "<<m_ty.m_value<<" "<<m_tz.m_value<<"\n";
-    cmds.push_back(cmd2.str());
+    return writeFixCommands(cmds);
+}
+
+bool radahn::lmp::AddTorqueLammpsCommand::writeFixCommands(std::vector<std::string>& cmds) const
+{
+    std::stringstream cmd;
+    cmd<<"fix "<<m_origin<<"ID "<<m_origin<<"GRP addtorque "<<m_tx.m_value<<" "<<m_ty.m_value<<" "<<m_tz.m_value<<"\n";
+    cmds.push_back(cmd.str());
 
     return true;
 }
@@ -206,9 +255,7 @@ bool radahn::lmp::AddTorqueLammpsCommand::writeDoCommands(std::vector<std::strin
 bool radahn::lmp::AddTorqueLammpsCommand::writeUndoCommands(std::vector<std::string>& cmds) const
 {
     // Undo the fix
-    std::stringstream cmd1;
-    cmd1<<"unfix "<<m_origin<<"ID";
-    cmds.push_back(cmd1.str());
+    writeUnfixCommands(cmds);
 
     // Undo the grp 
     std::stringstream cmd2;
@@ -218,6 +265,15 @@ bool radahn::lmp::AddTorqueLammpsCommand::writeUndoCommands(std::vector<std::str
     return true;
 }
 
+bool radahn::lmp::AddTorqueLammpsCommand::writeUnfixCommands(std::vector<std::string>& cmds) const
+{
+    std::stringstream cmd;
+    cmd<<"unfix "<<m_origin<<"ID";
+    cmds.push_back(cmd.str());
+
+    return true;
+}
+
 std::string radahn::lmp::AddTorqueLammpsCommand::getGroupName() const
 {
     std::stringstream ss;
@@ -272,14 +328,18 @@ bool radahn::lmp::RotateLammpsCommand::writeDoCommands(std::vector<std::string>&
     // Create the group
     std::stringstream cmd1;
     cmd1<<"group "<<m_origin<<"GRP id";
-    for(auto & id : m_selection)
-        cmd1<<" "<<id;
+    LammpsCommandsUtils::writeIdSelection(cmd1, m_selection);
     cmds.push_back(cmd1.str());
 
     // Create the move command
-    std::stringstream cmd2;
-    cmd2<<"fix "<<m_origin<<"ID "<<m_origin<<"GRP move rotate "<<m_px.m_value<<" "<<m_py.m_value<<" "<<m_pz.m_value<<" "<<m_ax<<" "<<m_ay<<" "<<m_az<<" "<<m_period.m_value<<"\n";
-    cmds.push_back(cmd2.str());
+    return writeFixCommands(cmds);
+}
+
+bool radahn::lmp::RotateLammpsCommand::writeFixCommands(std::vector<std::string>& cmds) const
+{
+    std::stringstream cmd;
+    cmd<<"fix "<<m_origin<<"ID "<<m_origin<<"GRP move rotate "<<m_px.m_value<<" "<<m_py.m_value<<" "<<m_pz.m_value<<" "<<m_ax<<" "<<m_ay<<" "<<m_az<<" "<<m_period.m_value<<"\n";
+    cmds.push_back(cmd.str());
 
     return true;
 }
@@ -287,9 +347,7 @@ bool radahn::lmp::RotateLammpsCommand::writeDoCommands(std::vector<std::string>&
 bool radahn::lmp::RotateLammpsCommand::writeUndoCommands(std::vector<std::string>& cmds) const
 {
     // Undo the fix
-    std::stringstream cmd1;
-    cmd1<<"unfix "<<m_origin<<"ID";
-    cmds.push_back(cmd1.str());
+    writeUnfixCommands(cmds);
 
     // Undo the grp 
     std::stringstream cmd2;
@@ -299,6 +357,15 @@ bool radahn::lmp::RotateLammpsCommand::writeUndoCommands(std::vector<std::string
     return true;
 }
 
+bool radahn::lmp::RotateLammpsCommand::writeUnfixCommands(std::vector<std::string>& cmds) const
+{
+    std::stringstream cmd;
+    cmd<<"unfix "<<m_origin<<"ID";
+    cmds.push_back(cmd.str());
+
+    return true;
+}
+
 std::string radahn::lmp::RotateLammpsCommand::getGroupName() const
 {
     std::stringstream ss;
@@ -436,6 +503,41 @@ bool radahn::lmp::LammpsCommandsUtils::writeDoCommands(std::vector<std::string>&
     }
 
     // Create the moveable group for the integration process
+    writeIntegrationCommands(nonIntegrationGroup, cmdsStr);
+
+    cmdsStr.push_back("#### END DO motor commands");
+
+    return result;
+}
+
+bool radahn::lmp::LammpsCommandsUtils::writeUndoCommands(std::vector<std::string>& cmds) const
+{
+    cmds.push_back("#### Start UNDO motor commands");
+
+    // Do this in the reverse order as do
+    std::stringstream cmd1;
+    cmd1<<"group "<<m_integrateGroupName<<" delete";
+    cmds.push_back(cmd1.str());
+
+    std::stringstream cmd2;
+    cmd2<<"group "<<m_nonIntegrateGroupName<<" delete";
+    cmds.push_back(cmd2.str());
+
+    bool result = true;
+    for(auto & cmd : m_cmds | std::views::reverse)
+    {
+        result &= cmd->writeUndoCommands(cmds);
+    }
+
+    cmds.push_back("#### End UNDO motor commands");
+
+    return result;
+}
+
+
+
+void radahn::lmp::LammpsCommandsUtils::writeIntegrationCommands(const std::vector<std::string>& nonIntegrationGroup, std::vector<std::string>& cmds) const
+{
     if(nonIntegrationGroup.size() == 0)
     {
         // All the groups can be moved
@@ -445,14 +547,14 @@ bool radahn::lmp::LammpsCommandsUtils::writeDoCommands(std::vector<std::string>&
             // No unmovable motors, but a permanent anchor
             std::stringstream cmd1;
             cmd1<<"group "<<m_nonIntegrateGroupName<<" union "<<m_permanentAnchorName;
-            cmdsStr.push_back(cmd1.str());
+            cmds.push_back(cmd1.str());
         }
         else 
         {   
             // No permanent anchor, no unmovable motors
             std::stringstream cmd1;
             cmd1<<"group "<<m_nonIntegrateGroupName<<" empty";
-            cmdsStr.push_back(cmd1.str());
+            cmds.push_back(cmd1.str());
         }
     }
     else
@@ -466,41 +568,133 @@ bool radahn::lmp::LammpsCommandsUtils::writeDoCommands(std::vector<std::string>&
         {
             cmd1<<" "<<m_permanentAnchorName;
         }
-        cmdsStr.push_back(cmd1.str());
+        cmds.push_back(cmd1.str());
     }
     std::stringstream ss;
-    ss<<"group "<<m_integrateGroupName<<" subtract all nonintegrateGRP";
-    cmdsStr.push_back(ss.str());
-
-    cmdsStr.push_back("#### END DO motor commands");
+    ss<<"group "<<m_integrateGroupName<<" subtract all "<<m_nonIntegrateGroupName;
+    cmds.push_back(ss.str());
 
-    return result;
 }
 
-bool radahn::lmp::LammpsCommandsUtils::writeUndoCommands(std::vector<std::string>& cmds) const
+bool radahn::lmp::LammpsCommandsUtils::writeUpdateCommands(std::vector<std::string>& cmds)
 {
-    cmds.push_back("#### Start UNDO motor commands");
+    cmds.push_back("#### Start UPDATE motor commands");
 
-    // Do this in the reverse order as do
-    std::stringstream cmd1;
-    cmd1<<"group "<<m_integrateGroupName<<" delete";
-    cmds.push_back(cmd1.str());
+    std::map<std::string, std::shared_ptr<LammpsCommand>> requestedCmds;
+    std::map<std::string, std::vector<atomIndexes_t>> requestedNonIntegrated;
+    for(auto & cmd : m_cmds)
+    {
+        requestedCmds[cmd->m_origin] = cmd;
+        if(!cmd->needMotionIntegration())
+        {
+            auto selection = cmd->getSelection();
+            requestedNonIntegrated[cmd->getGroupName()] = std::vector<atomIndexes_t>(selection.begin(), selection.end());
+        }
+    }
+    m_cmds.clear();
 
-    std::stringstream cmd2;
-    cmd2<<"group "<<m_nonIntegrateGroupName<<" delete";
-    cmds.push_back(cmd2.str());
+    // The integration groups are static in Lammps, they have to be rebuilt when the atoms excluded from the time integration change.
+    // Lammps refuses to delete a group used by a fix, so the NVE fix is removed first.
+    bool integrationChanged = !m_integrationApplied || requestedNonIntegrated != m_appliedNonIntegrated;
+    if(integrationChanged && m_integrationApplied)
+    {
+        cmds.push_back("unfix " + m_integrationFixName);
+        cmds.push_back("group " + m_integrateGroupName + " delete");
+        cmds.push_back("group " + m_nonIntegrateGroupName + " delete");
+        m_integrationApplied = false;
+    }
 
     bool result = true;
-    for(auto & cmd : m_cmds | std::views::reverse)
+
+    // Stop the motors which are not requested anymore
+    for(auto it = m_appliedCmds.begin(); it != m_appliedCmds.end();)
     {
-        result &= cmd->writeUndoCommands(cmds);
+        if(requestedCmds.count(it->first) == 0)
+        {
+            result &= it->second->writeUndoCommands(cmds);
+            it = m_appliedCmds.erase(it);
+        }
+        else
+            it++;
     }
 
-    cmds.push_back("#### End UNDO motor commands");
+    // Start the new motors and update the existing ones
+    for(auto & [origin, cmd] : requestedCmds)
+    {
+        auto applied = m_appliedCmds.find(origin);
+        if(applied == m_appliedCmds.end())
+        {
+            result &= cmd->writeDoCommands(cmds);
+        }
+        else
+        {
+            auto previousSelection = applied->second->getSelection();
+            auto selection = cmd->getSelection();
+            if(!std::ranges::equal(previousSelection, selection))
+            {
+                // The group has to be rebuilt
+                result &= applied->second->writeUndoCommands(cmds);
+                result &= cmd->writeDoCommands(cmds);
+            }
+            else
+            {
+                // Same group, only re-fix if the parameters changed
+                std::vector<std::string> previousFix;
+                std::vector<std::string> newFix;
+                applied->second->writeFixCommands(previousFix);
+                cmd->writeFixCommands(newFix);
+                if(previousFix != newFix)
+                {
+                    result &= applied->second->writeUnfixCommands(cmds);
+                    cmds.insert(cmds.end(), newFix.begin(), newFix.end());
+                }
+            }
+        }
+        m_appliedCmds[origin] = cmd;
+    }
+
+    if(integrationChanged)
+    {
+        std::vector<std::string> nonIntegrationGroup;
+        for(auto & [groupName, selection] : requestedNonIntegrated)
+            nonIntegrationGroup.push_back(groupName);
+        writeIntegrationCommands(nonIntegrationGroup, cmds);
+
+        std::stringstream cmdFixNVE;
+        cmdFixNVE<<"fix "<<m_integrationFixName<<" "<<m_integrateGroupName<<" nve";
+        cmds.push_back(cmdFixNVE.str());
+
+        m_appliedNonIntegrated = std::move(requestedNonIntegrated);
+        m_integrationApplied = true;
+    }
+
+    cmds.push_back("#### End UPDATE motor commands");
 
     return result;
 }
 
+bool radahn::lmp::LammpsCommandsUtils::writeClearCommands(std::vector<std::string>& cmds)
+{
+    cmds.push_back("#### Start CLEAR motor commands");
+
+    if(m_integrationApplied)
+    {
+        cmds.push_back("unfix " + m_integrationFixName);
+        cmds.push_back("group " + m_integrateGroupName + " delete");
+        cmds.push_back("group " + m_nonIntegrateGroupName + " delete");
+        m_integrationApplied = false;
+    }
+    m_appliedNonIntegrated.clear();
+
+    bool result = true;
+    for(auto & [origin, cmd] : m_appliedCmds)
+        result &= cmd->writeUndoCommands(cmds);
+    m_appliedCmds.clear();
+
+    cmds.push_back("#### End CLEAR motor commands");
+
+    return result;
+}
 
 
 void radahn::lmp::LammpsCommandsUtils::registerMoveCommandToConduit(conduit::Node& node, const std::string& name, VelocityQuantity vx, VelocityQuantity vy, VelocityQuantity vz, const std::vector<atomIndexes_t>& selection)
@@ -576,3 +770,68 @@ void radahn::lmp::LammpsCommandsUtils::registerWaitCommandToConduit(conduit::Nod
     node["cmdType"] = static_cast<std::underlying_type<radahn::lmp::SimCommandType>::type>(radahn::lmp::SimCommandType::SIM_COMMAND_WAIT);
     node["origin"] = name;
 }
+
+void radahn::lmp::LammpsCommandsUtils::registerCompletionToConduit(
+        conduit::Node& node, 
+        bool checkX, 
+        bool checkY, 
+        bool checkZ, 
+        DistanceQuantity dx, 
+        DistanceQuantity dy, 
+        DistanceQuantity dz)
+{
+    // The distances are expected in the same units as the rest of the command
+    std::array<uint8_t, 3> check = {static_cast<uint8_t>(checkX), static_cast<uint8_t>(checkY), static_cast<uint8_t>(checkZ)};
+    std::array<double, 3> distance = {dx.m_value, dy.m_value, dz.m_value};
+    node["completion"]["check"].set(check.data(), 3);
+    node["completion"]["distance"].set(distance.data(), 3);
+}
+
+conduit::Node& radahn::lmp::LammpsCommandsUtils::reuseCommandNode(conduit::Node& cmds, conduit::index_t index, const std::string& origin)
+{
+    if(index >= cmds.number_of_children())
+        return cmds.append();
+
+    auto & node = cmds.child(index);
+    if(!node.has_child("origin") || origin != node["origin"].as_char8_str())
+        node.reset();
+    return node;
+}
+
+void radahn::lmp::LammpsCommandsUtils::trimCommands(conduit::Node& cmds, conduit::index_t count)
+{
+    while(cmds.number_of_children() > count)
+        cmds.remove(cmds.number_of_children() - 1);
+}
+
+void radahn::lmp::LammpsCommandsUtils::writeIdSelection(std::ostream& out, std::span<const atomIndexes_t> selection)
+{
+    std::vector<atomIndexes_t> ids(selection.begin(), selection.end());
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    // Greedy split in arithmetic sequences, only sequences of at least 3 IDs are shorter as a range
+    size_t i = 0;
+    while(i < ids.size())
+    {
+        size_t end = i;
+        if(i + 1 < ids.size())
+        {
+            atomIndexes_t step = ids[i+1] - ids[i];
+            end = i + 1;
+            while(end + 1 < ids.size() && ids[end+1] - ids[end] == step)
+                end++;
+
+            if(end - i + 1 >= 3)
+            {
+                out<<" "<<ids[i]<<":"<<ids[end];
+                if(step > 1)
+                    out<<":"<<step;
+                i = end + 1;
+                continue;
+            }
+        }
+        out<<" "<<ids[i];
+        i++;
+    }
+}
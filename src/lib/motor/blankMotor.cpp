@@ -21,6 +21,7 @@ bool radahn::motor::BlankMotor::updateState(simIt_t it,
         kvs["steps_left"] = it - m_lastStep;
         kvs["steps_done"] = it - m_startStep;
         kvs["progress"] = (static_cast<double>(it - m_startStep) / static_cast<double>(m_nbStepsRequested))*100.0;
+        registerProgress(it, (static_cast<double>(it - m_startStep) / static_cast<double>(m_nbStepsRequested))*100.0);
 
         m_motorWriter.appendFrame(it, kvs);
 
@@ -39,6 +40,7 @@ bool radahn::motor::BlankMotor::updateState(simIt_t it,
         m_startStep = it;
         m_lastStep = it + m_nbStepsRequested;
         m_stepCountersSet = true;
+        registerProgress(it, 0.0);
     }
 
     m_motorWriter.appendFrame(it, kvs);
@@ -46,6 +48,14 @@ bool radahn::motor::BlankMotor::updateState(simIt_t it,
     return true;
 }
 
+simIt_t radahn::motor::BlankMotor::getEstimatedStepsToCompletion() const
+{
+    // The number of steps to wait is known exactly
+    if(m_status != MotorStatus::MOTOR_RUNNING || !m_stepCountersSet || m_lastStep <= m_lastProgressIt)
+        return 0;
+    return m_lastStep - m_lastProgressIt;
+}
+
 bool radahn::motor::BlankMotor::appendCommandToConduitNode(conduit::Node& node)
 {
     radahn::lmp::LammpsCommandsUtils::registerWaitCommandToConduit(node, m_name);
@@ -82,4 +92,23 @@ void radahn::motor::BlankMotor::convertSettingsTo(SimUnits destUnits)
 void radahn::motor::BlankMotor::declareCSVWriterFieldNames()
 {
     m_motorWriter.declareFieldNames({"steps_left", "steps_done", "progress"});
-}
\ No newline at end of file
+}
+
+void radahn::motor::BlankMotor::saveState(conduit::Node& node) const
+{
+    Motor::saveState(node);
+    node["startStep"] = m_startStep;
+    node["lastStep"] = m_lastStep;
+    node["stepCountersSet"] = static_cast<uint8_t>(m_stepCountersSet ? 1 : 0);
+}
+
+bool radahn::motor::BlankMotor::loadState(const conduit::Node& node)
+{
+    if(!Motor::loadState(node))
+        return false;
+
+    m_startStep = node["startStep"].to_uint64();
+    m_lastStep = node["lastStep"].to_uint64();
+    m_stepCountersSet = node["stepCountersSet"].to_uint8() > 0;
+    return true;
+}
@@ -0,0 +1,61 @@
+#include <radahn/motor/ensembleKVS.h>
+
+#include <cmath>
+#include <algorithm>
+
+void radahn::motor::EnsembleKVS::aggregate(radahn::core::simIt_t it, const std::vector<const conduit::Node*>& replicaKVS)
+{
+    // Group -> field -> value of each replica having it
+    std::map<std::string, std::map<std::string, std::vector<double>>> values;
+    for(auto kvs : replicaKVS)
+    {
+        for(conduit::index_t g = 0; g < kvs->number_of_children(); ++g)
+        {
+            auto & group = kvs->child(g);
+            auto & groupValues = values[group.name()];
+            for(conduit::index_t f = 0; f < group.number_of_children(); ++f)
+            {
+                auto & field = group.child(f);
+                if(!field.dtype().is_number() || field.dtype().number_of_elements() != 1)
+                    continue;
+                groupValues[field.name()].push_back(field.to_float64());
+            }
+        }
+    }
+
+    m_currentKVS = conduit::Node();
+    for(auto & [groupName, fields] : values)
+    {
+        auto & group = m_currentKVS.add_child(groupName);
+        for(auto & [fieldName, samples] : fields)
+        {
+            double sum = 0.0;
+            for(auto v : samples)
+                sum += v;
+            auto n = static_cast<double>(samples.size());
+            double mean = sum / n;
+
+            double variance = 0.0;
+            for(auto v : samples)
+                variance += (v - mean) * (v - mean);
+            variance /= n;
+
+            group[fieldName + "_mean"] = mean;
+            group[fieldName + "_std"] = std::sqrt(variance);
+            group[fieldName + "_min"] = *std::min_element(samples.begin(), samples.end());
+            group[fieldName + "_max"] = *std::max_element(samples.begin(), samples.end());
+            group[fieldName + "_n"] = static_cast<uint32_t>(samples.size());
+        }
+
+        auto csv = m_groupCSV.find(groupName);
+        if(csv == m_groupCSV.end())
+            csv = m_groupCSV.emplace(groupName, radahn::core::DynamicCSVWriter("ensemble_" + groupName, ';')).first;
+        csv->second.appendFrame(it, group);
+    }
+}
+
+void radahn::motor::EnsembleKVS::saveToCSV(const std::string& folder) const
+{
+    for(auto & [groupName, csv] : m_groupCSV)
+        csv.writeFile(folder);
+}
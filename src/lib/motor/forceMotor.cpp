@@ -33,7 +33,7 @@ bool radahn::motor::ForceMotor::updateState(radahn::core::simIt_t it,
     // Check if we have met the conditions
     auto currentCenter = m_currentState.computePositionCenter();
 
-    std::vector<radahn::core::atomPositions_t> distances = {0.0, 0.0, 0.0};
+    std::array<radahn::core::atomPositions_t, 3> distances = {0.0, 0.0, 0.0};
     distances[0] = currentCenter[0]-m_initialCx.m_value;
     distances[1] = currentCenter[1]-m_initialCy.m_value;
     distances[2] = currentCenter[2]-m_initialCz.m_value;
@@ -65,6 +65,7 @@ void radahn::motor::ForceMotor::declareCSVWriterFieldNames()
 bool radahn::motor::ForceMotor::appendCommandToConduitNode(conduit::Node& node)
 {
     radahn::lmp::LammpsCommandsUtils::registerAddForceCommandToConduit(node, m_name, m_fx, m_fy, m_fz, m_currentState.getSelectionVector());
+    radahn::lmp::LammpsCommandsUtils::registerCompletionToConduit(node, m_checkX, m_checkY, m_checkZ, m_dx, m_dy, m_dz);
 
     return true;
 }
@@ -112,4 +113,22 @@ void radahn::motor::ForceMotor::convertSettingsTo(radahn::core::SimUnits destUni
     m_initialCx.convertTo(destUnits);
     m_initialCy.convertTo(destUnits);
     m_initialCz.convertTo(destUnits);
-}
\ No newline at end of file
+}
+
+void radahn::motor::ForceMotor::saveState(conduit::Node& node) const
+{
+    SelectionMotor::saveState(node);
+    node["initialCenter"] = std::vector<double>({m_initialCx.m_value, m_initialCy.m_value, m_initialCz.m_value});
+}
+
+bool radahn::motor::ForceMotor::loadState(const conduit::Node& node)
+{
+    std::array<double, 3> initialCenter;
+    if(!SelectionMotor::loadState(node) || !loadVector(node, "initialCenter", initialCenter))
+        return false;
+
+    m_initialCx.m_value = initialCenter[0];
+    m_initialCy.m_value = initialCenter[1];
+    m_initialCz.m_value = initialCenter[2];
+    return true;
+}
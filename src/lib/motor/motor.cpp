@@ -1,5 +1,8 @@
 #include <radahn/motor/motor.h>
 
+#include <cmath>
+#include <algorithm>
+
 void radahn::motor::Motor::addDependency(std::shared_ptr<Motor> dependency) 
 { 
     m_dependencies.push_back(dependency);
@@ -29,6 +32,25 @@ bool radahn::motor::Motor::startMotor()
         return false;
 }
 
+radahn::core::simIt_t radahn::motor::Motor::getEstimatedStepsToCompletion() const
+{
+    if(m_status != MotorStatus::MOTOR_RUNNING || m_progressRate <= 0.0)
+        return 0;
+
+    double remaining = std::max(100.0 - m_lastProgress, 0.0);
+    return static_cast<radahn::core::simIt_t>(std::ceil(remaining / m_progressRate));
+}
+
+void radahn::motor::Motor::registerProgress(radahn::core::simIt_t it, double progress)
+{
+    if(m_progressRegistered && it > m_lastProgressIt)
+        m_progressRate = (progress - m_lastProgress) / static_cast<double>(it - m_lastProgressIt);
+
+    m_lastProgressIt = it;
+    m_lastProgress = progress;
+    m_progressRegistered = true;
+}
+
 bool radahn::motor::Motor::loadFromJSON(const nlohmann::json& node, uint32_t version, radahn::core::SimUnits units)
 {
     (void)version;
@@ -46,6 +68,33 @@ bool radahn::motor::Motor::loadFromJSON(const nlohmann::json& node, uint32_t ver
     return true;
 }
 
+void radahn::motor::Motor::saveState(conduit::Node& node) const
+{
+    node["status"] = static_cast<uint8_t>(m_status);
+    node["progressRegistered"] = static_cast<uint8_t>(m_progressRegistered ? 1 : 0);
+    node["lastProgressIt"] = m_lastProgressIt;
+    node["lastProgress"] = m_lastProgress;
+    node["progressRate"] = m_progressRate;
+    node["csv"] = m_motorWriter.getContent();
+}
+
+bool radahn::motor::Motor::loadState(const conduit::Node& node)
+{
+    if(!node.has_child("status") || !node.has_child("csv"))
+    {
+        spdlog::error("Incomplete checkpoint for the motor {}.", m_name);
+        return false;
+    }
+
+    m_status = MotorStatus(node["status"].to_uint8());
+    m_progressRegistered = node["progressRegistered"].to_uint8() > 0;
+    m_lastProgressIt = node["lastProgressIt"].to_uint64();
+    m_lastProgress = node["lastProgress"].to_float64();
+    m_progressRate = node["progressRate"].to_float64();
+    m_motorWriter.setContent(node["csv"].as_string());
+    return true;
+}
+
 void radahn::motor::Motor::writeCSVFile(const std::string& folder) const
 {
     m_motorWriter.writeFile(folder);
@@ -5,7 +5,13 @@
 #include <radahn/motor/rotateMotor.h>
 #include <radahn/motor/forceMotor.h>
 #include <radahn/motor/torqueMotor.h>
+#include <radahn/core/positionCodec.h>
+#include <radahn/lmp/lammpsCommandsUtils.h>
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <thread>
 using json = nlohmann::json;
 
 using namespace radahn::core;
@@ -48,40 +54,86 @@ void radahn::motor::MotorEngine::setCurrentSimulationIt(radahn::core::simIt_t it
     m_currentIt = it;
 }
 
-void radahn::motor::MotorEngine::updateEngineState(radahn::core::simIt_t it,
-        std::vector<radahn::core::atomIndexes_t>& indices, 
-        std::vector<radahn::core::atomPositions_t>& positions)
+bool radahn::motor::MotorEngine::updateEngineState(radahn::core::simIt_t it, const std::vector<const conduit::Node*>& chunks)
 {
-    // First, we need to sort the received positions
-    // HYPOTHESIS: We receive ALL the atom information, not just a sub-selection!!!
-    size_t nbAtoms = indices.size();
-    m_currentIndexes.resize(3*nbAtoms);
-    m_currentPositions.resize(3*nbAtoms);
+    // A single chunk flagged "sorted" was gathered by the simulation with the atoms 1..n in the order of their ID,
+    // its IDs don't need to be checked. The IDs of the other chunks are checked before anything is written.
+    bool sorted = chunks.size() == 1 && chunks[0]->has_child("sorted") && (*chunks[0])["sorted"].to_uint8() > 0;
+
+    // The arrays are sized on the largest ID received so far. Atoms which are not received keep their last known position.
+    size_t maxID = m_currentIndexes.size();
+    uint64_t totalNbAtoms = 0;
+    for(auto chunk : chunks)
+    {
+        auto & idsNode = (*chunk)["atomIDs"];
+        const atomIndexes_t* ids = idsNode.as_uint32_ptr();
+        auto nbAtoms = static_cast<uint64_t>(idsNode.dtype().number_of_elements());
+        totalNbAtoms += nbAtoms;
+        if(sorted)
+        {
+            maxID = std::max(maxID, static_cast<size_t>(nbAtoms));
+            continue;
+        }
 
-    for(size_t i = 0; i < nbAtoms; ++i)
+        // Lammps IDs are 1-based, 0 is not a valid ID
+        for(uint64_t i = 0; i < nbAtoms; ++i)
+        {
+            if(ids[i] == 0)
+            {
+                spdlog::error("Received the invalid atom ID 0 for the step {}.", it);
+                return false;
+            }
+            maxID = std::max(maxID, static_cast<size_t>(ids[i]));
+        }
+    }
+    if(maxID > m_currentIndexes.size())
     {
-        // Lammps indices are 1-based
-        int64_t atomID = static_cast<int64_t>(indices[i]);
-        uint64_t newIndex = static_cast<uint64_t>(atomID-1);
-        m_currentIndexes[newIndex] = indices[i];
-        m_currentPositions[3*newIndex] = positions[3*i];
-        m_currentPositions[3*newIndex+1] = positions[3*i+1];
-        m_currentPositions[3*newIndex+2] = positions[3*i+2];
+        m_currentIndexes.resize(maxID);
+        m_currentPositions.resize(3*maxID);
     }
 
+    // Each atom ID is sent by a single process, the chunks write to disjoint entries of the arrays
+    std::atomic<bool> result = true;
+    std::atomic<size_t> nextChunk = 0;
+    auto scatterChunks = [&]()
+    {
+        for(size_t c = nextChunk++; c < chunks.size(); c = nextChunk++)
+        {
+            auto & simData = *chunks[c];
+            auto & idsNode = simData["atomIDs"];
+            const atomIndexes_t* ids = idsNode.as_uint32_ptr();
+            auto nbAtoms = static_cast<uint64_t>(idsNode.dtype().number_of_elements());
+            for(uint64_t i = 0; i < nbAtoms; ++i)
+                m_currentIndexes[ids[i]-1] = ids[i];
+            if(!radahn::core::scatterPositions(simData, ids, nbAtoms, m_currentPositions.data()))
+            {
+                spdlog::error("Unable to decode the positions of the chunk {}.", c);
+                result = false;
+            }
+        }
+    };
+
+    // Small frames are scattered by this thread. The threads of the pool are started with the first large frame.
+    constexpr uint64_t minAtomsPerThread = 1 << 16;
+    size_t nbWorkers = std::min<size_t>(chunks.size(), static_cast<size_t>(totalNbAtoms / minAtomsPerThread));
+    if(nbWorkers > 1)
+    {
+        if(!m_scatterPool)
+            m_scatterPool = std::make_unique<radahn::core::WorkerPool>(std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1);
+        m_scatterPool->run(nbWorkers, scatterChunks);
+    }
+    else
+        scatterChunks();
+
     // Initialize the data for the current iteration
-    m_currentKVS = conduit::Node();
+    resetKVS();
 
     m_currentIt = it;
+    return result;
 }
 
-
-bool radahn::motor::MotorEngine::updateMotorsState(simIt_t it,
-    std::vector<atomIndexes_t>& indices, 
-    std::vector<atomPositions_t>& positions)
+bool radahn::motor::MotorEngine::updateMotors(simIt_t it)
 {
-    updateEngineState(it, indices, positions);
-
     // Now we can update the motors with the sorted arrays
     bool result = true;
     for(auto & motor : m_activeMotors)
@@ -141,11 +193,133 @@ bool radahn::motor::MotorEngine::updateMotorLists()
 bool radahn::motor::MotorEngine::getCommandsFromMotors(conduit::Node& node) const
 {
     bool result = true;
+    // One command per motor, the simulation compares them with the previous ones per origin
+    // The list of the previous frame is rewritten in place, a running motor keeps the same fields
+    conduit::index_t nbCommands = 0;
     for(auto & motor : m_activeMotors)
-        result &= motor->appendCommandToConduitNode(node);
+        result &= motor->appendCommandToConduitNode(radahn::lmp::LammpsCommandsUtils::reuseCommandNode(node, nbCommands++, motor->getMotorName()));
+    radahn::lmp::LammpsCommandsUtils::trimCommands(node, nbCommands);
     return result;
 }
 
+void radahn::motor::MotorEngine::getActiveSelection(std::vector<radahn::core::atomIndexes_t>& selection) const
+{
+    // The waiting motors are included as well, they can be started by updateMotorLists() before the next frame is received
+    // The selections are merged in the vector given by the caller, kept from one frame to the next
+    selection.clear();
+    for(auto & [name, motor] : m_motorsMap)
+    {
+        auto status = motor->getMotorStatus();
+        if(status == radahn::motor::MotorStatus::MOTOR_RUNNING || status == radahn::motor::MotorStatus::MOTOR_WAIT)
+            motor->collectSelection(selection);
+    }
+
+    std::sort(selection.begin(), selection.end());
+    selection.erase(std::unique(selection.begin(), selection.end()), selection.end());
+}
+
+void radahn::motor::MotorEngine::getReductionRequests(conduit::Node& requests) const
+{
+    // Same motors as getActiveSelection()
+    // The requests of the previous frame are rewritten in place, only the ones of the motors which stopped are removed
+    if(!requests.dtype().is_object())
+        requests.set(conduit::DataType::object());
+    for(auto i = requests.number_of_children(); i > 0; --i)
+    {
+        auto motor = m_motorsMap.find(requests.child_names()[static_cast<size_t>(i-1)]);
+        if(motor == m_motorsMap.end() || (motor->second->getMotorStatus() != radahn::motor::MotorStatus::MOTOR_RUNNING && motor->second->getMotorStatus() != radahn::motor::MotorStatus::MOTOR_WAIT))
+            requests.remove(i-1);
+    }
+    for(auto & [name, motor] : m_motorsMap)
+    {
+        auto status = motor->getMotorStatus();
+        if(status == radahn::motor::MotorStatus::MOTOR_RUNNING || status == radahn::motor::MotorStatus::MOTOR_WAIT)
+            motor->collectReductions(requests);
+    }
+}
+
+void radahn::motor::MotorEngine::applyReductions(simIt_t it, const conduit::Node& reductions)
+{
+    for(conduit::index_t i = 0; i < reductions.number_of_children(); ++i)
+    {
+        auto & reduction = reductions.child(i);
+        auto motor = m_motorsMap.find(reduction.name());
+        if(motor == m_motorsMap.end())
+        {
+            spdlog::warn("Received the reduction of the unknown motor {}.", reduction.name());
+            continue;
+        }
+        motor->second->applyReduction(it, reduction);
+    }
+}
+
+radahn::core::simIt_t radahn::motor::MotorEngine::getSuggestedInterval() const
+{
+    simIt_t suggestion = 0;
+    for(auto & motor : m_activeMotors)
+    {
+        auto estimate = motor->getEstimatedStepsToCompletion();
+        if(estimate > 0 && (suggestion == 0 || estimate < suggestion))
+            suggestion = estimate;
+    }
+    return suggestion;
+}
+
+void radahn::motor::MotorEngine::saveState(conduit::Node& node) const
+{
+    node["currentIt"] = m_currentIt;
+    for(auto & [name, motor] : m_motorsMap)
+        motor->saveState(node["motors"].add_child(name));
+
+    // Keep the order in which the motors were started
+    auto & activeNode = node["active"];
+    activeNode.set(conduit::DataType::list());
+    for(auto & motor : m_activeMotors)
+        activeNode.append() = motor->getMotorName();
+
+    m_globalCSV.saveState(node["global"]);
+}
+
+bool radahn::motor::MotorEngine::loadState(const conduit::Node& node)
+{
+    if(!node.has_child("motors") || !node.has_child("active"))
+    {
+        spdlog::error("Incomplete motor engine checkpoint.");
+        return false;
+    }
+
+    m_currentIt = node["currentIt"].to_uint64();
+    auto & motorsNode = node["motors"];
+    for(auto & [name, motor] : m_motorsMap)
+    {
+        if(!motorsNode.has_child(name))
+        {
+            spdlog::error("The motor {} is not part of the checkpoint. Was the motor configuration changed?", name);
+            return false;
+        }
+        if(!motor->loadState(motorsNode[name]))
+            return false;
+    }
+
+    m_activeMotors.clear();
+    auto & activeNode = node["active"];
+    for(conduit::index_t i = 0; i < activeNode.number_of_children(); ++i)
+    {
+        auto name = activeNode.child(i).as_string();
+        auto motor = m_motorsMap.find(name);
+        if(motor == m_motorsMap.end())
+        {
+            spdlog::error("Unknown active motor {} in the checkpoint.", name);
+            return false;
+        }
+        m_activeMotors.push_back(motor->second);
+    }
+
+    if(node.has_child("global"))
+        m_globalCSV.loadState(node["global"]);
+    return true;
+}
+
 bool radahn::motor::MotorEngine::isCompleted() const
 {
     for(auto & [name, motor] : m_motorsMap)
@@ -278,9 +452,25 @@ bool radahn::motor::MotorEngine::loadFromJSON(const std::string& filename)
     return true;
 }
 
+void radahn::motor::MotorEngine::resetKVS()
+{
+    // A running motor writes the same leaves at every frame, updateMotors() gets its existing subtree back from add_child()
+    // and the values are updated in place.
+    // The subtrees of the motors which are not running anymore must not stay in the next frames.
+    for(auto i = m_currentKVS.number_of_children(); i > 0; --i)
+    {
+        const auto & name = m_currentKVS.child_names()[static_cast<size_t>(i-1)];
+        bool active = name == "global" || std::any_of(m_activeMotors.begin(), m_activeMotors.end(), 
+            [&name](const auto & motor) { return motor->getMotorName() == name; });
+        if(!active)
+            m_currentKVS.remove(i-1);
+    }
+}
+
 void radahn::motor::MotorEngine::addGlobalKVS(conduit::Node& globals)
 {
-    m_currentKVS["global"] = globals;
+    // Same fields at every frame, copied in the existing leaves
+    m_currentKVS["global"].update(globals);
 }
 
 void radahn::motor::MotorEngine::commitKVSFrame()
@@ -290,9 +480,8 @@ void radahn::motor::MotorEngine::commitKVSFrame()
     // No need to commit for the motors in this case, the active motors do commit their frames once they're done updating.
 }
 
-void radahn::motor::MotorEngine::saveKVSToCSV()
+void radahn::motor::MotorEngine::saveKVSToCSV(const std::string& folder)
 {
-    std::string folder = ".";
     m_globalCSV.writeFile(folder);
 
     for(auto & [k, v] : m_motorsMap)
@@ -29,6 +29,7 @@ conduit::Node& kvs)
         kvs["centerY"] = m_initialCy.m_value;
         kvs["centerZ"] = m_initialCz.m_value;
         m_initialStateRegistered = true;
+        registerProgress(it, 0.0);
 
         m_motorWriter.appendFrame(it, kvs);
         return true;
@@ -37,7 +38,7 @@ conduit::Node& kvs)
     // Check if we have met the conditions
     auto currentCenter = m_currentState.computePositionCenter();
 
-    std::vector<radahn::core::atomPositions_t> distances = {0.0, 0.0, 0.0};
+    std::array<radahn::core::atomPositions_t, 3> distances = {0.0, 0.0, 0.0};
     distances[0] = currentCenter[0]-m_initialCx.m_value;    // Distance done since the start
     distances[1] = currentCenter[1]-m_initialCy.m_value;
     distances[2] = currentCenter[2]-m_initialCz.m_value;
@@ -70,6 +71,7 @@ conduit::Node& kvs)
     }
     
     kvs["progress"] = (progress / totalProgress) * 100.0;
+    registerProgress(it, (progress / totalProgress) * 100.0);
 
     bool validX = !m_checkX || (m_dx.m_value < 0.0 && distances[0] <= m_dx.m_value) || (m_dx.m_value >= 0.0 && distances[0] >= m_dx.m_value);
     bool validY = !m_checkY || (m_dy.m_value < 0.0 && distances[1] <= m_dy.m_value) || (m_dy.m_value >= 0.0 && distances[1] >= m_dy.m_value);
@@ -94,6 +96,7 @@ void radahn::motor::MoveMotor::declareCSVWriterFieldNames()
 bool radahn::motor::MoveMotor::appendCommandToConduitNode(conduit::Node& node)
 {
     radahn::lmp::LammpsCommandsUtils::registerMoveCommandToConduit(node, m_name, m_vx, m_vy, m_vz, m_currentState.getSelectionVector());
+    radahn::lmp::LammpsCommandsUtils::registerCompletionToConduit(node, m_checkX, m_checkY, m_checkZ, m_dx, m_dy, m_dz);
 
     return true;
 }
@@ -142,4 +145,22 @@ void radahn::motor::MoveMotor::convertSettingsTo(radahn::core::SimUnits destUnit
     m_initialCx.convertTo(destUnits);
     m_initialCy.convertTo(destUnits);
     m_initialCz.convertTo(destUnits);
-}
\ No newline at end of file
+}
+
+void radahn::motor::MoveMotor::saveState(conduit::Node& node) const
+{
+    SelectionMotor::saveState(node);
+    node["initialCenter"] = std::vector<double>({m_initialCx.m_value, m_initialCy.m_value, m_initialCz.m_value});
+}
+
+bool radahn::motor::MoveMotor::loadState(const conduit::Node& node)
+{
+    std::array<double, 3> initialCenter;
+    if(!SelectionMotor::loadState(node) || !loadVector(node, "initialCenter", initialCenter))
+        return false;
+
+    m_initialCx.m_value = initialCenter[0];
+    m_initialCy.m_value = initialCenter[1];
+    m_initialCz.m_value = initialCenter[2];
+    return true;
+}
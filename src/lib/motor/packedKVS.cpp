@@ -0,0 +1,166 @@
+#include <radahn/motor/packedKVS.h>
+
+#include <functional>
+#include <string_view>
+#include <random>
+
+namespace
+{
+
+bool isPackedField(const conduit::Node& field)
+{
+    return field.dtype().is_number() && field.dtype().number_of_elements() == 1;
+}
+
+} // namespace
+
+radahn::motor::PackedKVSWriter::PackedKVSWriter() : m_version(std::random_device{}())
+{
+}
+
+uint64_t radahn::motor::PackedKVSWriter::computeSignature(const conduit::Node& kvs, uint64_t& nbFields)
+{
+    uint64_t signature = 0;
+    nbFields = 0;
+    auto combine = [&signature](uint64_t value)
+    {
+        signature ^= value + 0x9E3779B97F4A7C15 + (signature << 6) + (signature >> 2);
+    };
+
+    for(conduit::index_t g = 0; g < kvs.number_of_children(); ++g)
+    {
+        auto & group = kvs.child(g);
+        combine(std::hash<std::string_view>{}(kvs.child_names()[static_cast<size_t>(g)]));
+        for(conduit::index_t f = 0; f < group.number_of_children(); ++f)
+        {
+            auto & field = group.child(f);
+            if(!isPackedField(field))
+                continue;
+            combine(std::hash<std::string_view>{}(group.child_names()[static_cast<size_t>(f)]));
+            combine(static_cast<uint64_t>(field.dtype().id()));
+            nbFields++;
+        }
+    }
+    return signature;
+}
+
+void radahn::motor::PackedKVSWriter::buildSchema(const conduit::Node& kvs)
+{
+    m_fields.clear();
+    m_sourceDtypes.clear();
+    for(conduit::index_t g = 0; g < kvs.number_of_children(); ++g)
+    {
+        auto & group = kvs.child(g);
+        for(conduit::index_t f = 0; f < group.number_of_children(); ++f)
+        {
+            auto & field = group.child(f);
+            if(!isPackedField(field))
+                continue;
+            m_fields.push_back(kvs.child_names()[static_cast<size_t>(g)] + "/" + group.child_names()[static_cast<size_t>(f)]);
+            m_sourceDtypes.push_back(field.dtype().name());
+        }
+    }
+}
+
+bool radahn::motor::PackedKVSWriter::update(const conduit::Node& kvs)
+{
+    uint64_t nbFields = 0;
+    auto signature = computeSignature(kvs, nbFields);
+    bool changed = !m_hasSchema || signature != m_signature || nbFields != m_fields.size();
+    if(changed)
+    {
+        buildSchema(kvs);
+        m_signature = signature;
+        m_version++;
+        m_hasSchema = true;
+    }
+
+    // Same traversal order as the schema
+    m_values.resize(m_fields.size());
+    size_t index = 0;
+    for(conduit::index_t g = 0; g < kvs.number_of_children(); ++g)
+    {
+        auto & group = kvs.child(g);
+        for(conduit::index_t f = 0; f < group.number_of_children(); ++f)
+        {
+            auto & field = group.child(f);
+            if(isPackedField(field))
+                m_values[index++] = field.to_float64();
+        }
+    }
+    return changed;
+}
+
+void radahn::motor::PackedKVSWriter::writeSchema(conduit::Node& msg) const
+{
+    msg.reset();
+    msg["kind"] = "schema";
+    msg["version"] = m_version;
+    auto & fields = msg["fields"];
+    auto & dtypes = msg["dtypes"];
+    auto & sourceDtypes = msg["sourceDtypes"];
+    fields.set(conduit::DataType::list());
+    dtypes.set(conduit::DataType::list());
+    sourceDtypes.set(conduit::DataType::list());
+    for(size_t i = 0; i < m_fields.size(); ++i)
+    {
+        fields.append() = m_fields[i];
+        dtypes.append() = "float64";
+        sourceDtypes.append() = m_sourceDtypes[i];
+    }
+}
+
+void radahn::motor::PackedKVSWriter::writeValues(radahn::core::simIt_t it, const conduit::Node& kvs, conduit::Node& msg) const
+{
+    // The message keeps its layout from one frame to the next, only the values are rewritten
+    msg["kind"] = "values";
+    msg["version"] = m_version;
+    msg["simIt"] = it;
+    msg["values"].set(m_values.data(), static_cast<conduit::index_t>(m_values.size()));
+
+    // The other leaves are rewritten in place, only the ones which are not part of the KVS anymore are removed
+    if(msg.has_child("others"))
+    {
+        auto & others = msg["others"];
+        for(auto g = others.number_of_children(); g > 0; --g)
+        {
+            auto & groupName = others.child_names()[static_cast<size_t>(g-1)];
+            if(!kvs.has_child(groupName))
+            {
+                others.remove(g-1);
+                continue;
+            }
+            auto & group = kvs.child(groupName);
+            auto & otherGroup = others.child(g-1);
+            if(!group.dtype().is_object())
+                continue;
+            for(auto f = otherGroup.number_of_children(); f > 0; --f)
+            {
+                auto & fieldName = otherGroup.child_names()[static_cast<size_t>(f-1)];
+                if(!group.has_child(fieldName) || isPackedField(group.child(fieldName)))
+                    otherGroup.remove(f-1);
+            }
+            if(otherGroup.number_of_children() == 0)
+                others.remove(g-1);
+        }
+        if(others.number_of_children() == 0)
+            msg.remove("others");
+    }
+
+    for(conduit::index_t g = 0; g < kvs.number_of_children(); ++g)
+    {
+        auto & group = kvs.child(g);
+        auto & groupName = kvs.child_names()[static_cast<size_t>(g)];
+        if(!group.dtype().is_object())
+        {
+            msg["others"].add_child(groupName).set(group);
+            continue;
+        }
+        for(conduit::index_t f = 0; f < group.number_of_children(); ++f)
+        {
+            auto & field = group.child(f);
+            if(!isPackedField(field))
+                msg["others"].add_child(groupName).add_child(group.child_names()[static_cast<size_t>(f)]).set(field);
+        }
+    }
+}
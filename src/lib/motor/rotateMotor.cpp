@@ -9,7 +9,6 @@ bool radahn::motor::RotateMotor::updateState(radahn::core::simIt_t it,
         return false;
 
     m_currentState.selectAtoms(it, indices, positions);
-    auto selectedPositions = m_currentState.getCurrentSelectedPositions();
     if(!m_initialStateRegistered)
     {
         spdlog::info("Registering the initial state for the motor {}.", m_name);
@@ -26,7 +25,8 @@ bool radahn::motor::RotateMotor::updateState(radahn::core::simIt_t it,
 
             // Save the first position
             // HYPOTHESIS: the atoms are always sorted, therefor the order of the atoms is always the same
-            m_trackedPointFirstIteration = {selectedPositions[m_trackedAtomIndex*3], selectedPositions[m_trackedAtomIndex*3+1], selectedPositions[m_trackedAtomIndex*3+2]};
+            auto trackedPosition = m_currentState.getSelectedAtomPosition(m_trackedAtomIndex);
+            m_trackedPointFirstIteration = {trackedPosition[0], trackedPosition[1], trackedPosition[2]};
             // Take two point very far away on the rotation axe to define a segment. GLM considers only a segment, not an infinite line for the projection.
             // Without this, the result of the projection will likely end up at an extremity of the segment so we make it long enough to "simulate" a line.
             m_trackedPointFirstIterationProjection = glm::closestPointOnLine(m_trackedPointFirstIteration, m_centroid - m_rotationAxis * 100000.0, m_centroid + m_rotationAxis * 100000.0);
@@ -56,13 +56,15 @@ bool radahn::motor::RotateMotor::updateState(radahn::core::simIt_t it,
         
         m_firstIterationProjectionVector = glm::normalize(m_firstIterationProjectionVector);
         m_initialStateRegistered = true;
+        registerProgress(it, 0.0);
         return true;
     }
 
     
 
     //glm::dvec3 pointOnAxe = centroid + axe;
-    glm::dvec3 trackedPointCurrent = {selectedPositions[m_trackedAtomIndex*3], selectedPositions[m_trackedAtomIndex*3+1], selectedPositions[m_trackedAtomIndex*3+2]};
+    auto trackedPosition = m_currentState.getSelectedAtomPosition(m_trackedAtomIndex);
+    glm::dvec3 trackedPointCurrent = {trackedPosition[0], trackedPosition[1], trackedPosition[2]};
     glm::dvec3 trackedPointProjection = glm::closestPointOnLine(trackedPointCurrent, m_centroid - m_rotationAxis * 10000000.0, m_centroid + m_rotationAxis * 10000000.0);
     glm::dvec3 currentIterationProjectionVector = trackedPointCurrent - trackedPointProjection;
     currentIterationProjectionVector = glm::normalize(currentIterationProjectionVector);
@@ -84,7 +86,9 @@ bool radahn::motor::RotateMotor::updateState(radahn::core::simIt_t it,
     m_totalRotationDeg = static_cast<double>(m_nbRotationCompleted) * 360.0 + rotationFromFirstDeg;
 
     kvs["progress"] = (m_totalRotationDeg / m_requestedAngle) * 100.0;
-    kvs["currentTotalAngleDeg"] = m_totalRotationDeg;
+    registerProgress(it, (m_totalRotationDeg / m_requestedAngle) * 100.0);
+    // add_child doesn't copy the long names to parse them as a path at every frame
+    kvs.add_child("currentTotalAngleDeg") = m_totalRotationDeg;
     kvs["currentAngleDeg"] = rotationFromFirstDeg;
     kvs["trackX"] = trackedPointCurrent.x;
     kvs["trackY"] = trackedPointCurrent.y;
@@ -161,4 +165,4 @@ void radahn::motor::RotateMotor::convertSettingsTo(radahn::core::SimUnits destUn
     m_px.convertTo(destUnits);
     m_py.convertTo(destUnits);
     m_pz.convertTo(destUnits);
-}
\ No newline at end of file
+}
@@ -0,0 +1,62 @@
+#include <radahn/motor/rotationMotor.h>
+
+#include <spdlog/spdlog.h>
+
+void radahn::motor::RotationMotor::collectReductions(conduit::Node& requests) const
+{
+    // The tracked atom is chosen among all the atoms of the selection when the motor starts
+    auto & vecSelection = m_currentState.getSelectionVector();
+    if(m_initialStateRegistered)
+        m_currentState.writeReductionRequest(requests.add_child(m_name), std::span(&vecSelection[m_trackedAtomIndex], 1));
+    else
+        m_currentState.writeReductionRequest(requests.add_child(m_name), vecSelection);
+}
+
+void radahn::motor::RotationMotor::saveState(conduit::Node& node) const
+{
+    SelectionMotor::saveState(node);
+    node["centroid"].set(&m_centroid.x, 3);
+    node["rotationAxis"].set(&m_rotationAxis.x, 3);
+    node["trackedPointFirstIteration"].set(&m_trackedPointFirstIteration.x, 3);
+    node["trackedPointFirstIterationProjection"].set(&m_trackedPointFirstIterationProjection.x, 3);
+    node["firstIterationProjectionVector"].set(&m_firstIterationProjectionVector.x, 3);
+    node["previousRotationAngleDeg"] = m_previousRotationAngleDeg;
+    node["previousRotationAngleRad"] = m_previousRotationAngleRad;
+    node["totalRotationDeg"] = m_totalRotationDeg;
+    node["nbRotationCompleted"] = m_nbRotationCompleted;
+    node["trackedAtomIndex"] = static_cast<uint64_t>(m_trackedAtomIndex);
+}
+
+bool radahn::motor::RotationMotor::loadState(const conduit::Node& node)
+{
+    if(!SelectionMotor::loadState(node))
+        return false;
+
+    auto loadVec3 = [this, &node](const std::string& name, glm::dvec3& vec)
+    {
+        std::array<double, 3> values;
+        if(!loadVector(node, name, values))
+            return false;
+        vec = {values[0], values[1], values[2]};
+        return true;
+    };
+
+    if(!loadVec3("centroid", m_centroid)
+        || !loadVec3("rotationAxis", m_rotationAxis)
+        || !loadVec3("trackedPointFirstIteration", m_trackedPointFirstIteration)
+        || !loadVec3("trackedPointFirstIterationProjection", m_trackedPointFirstIterationProjection)
+        || !loadVec3("firstIterationProjectionVector", m_firstIterationProjectionVector))
+        return false;
+
+    m_previousRotationAngleDeg = node["previousRotationAngleDeg"].to_float64();
+    m_previousRotationAngleRad = node["previousRotationAngleRad"].to_float64();
+    m_totalRotationDeg = node["totalRotationDeg"].to_float64();
+    m_nbRotationCompleted = static_cast<int32_t>(node["nbRotationCompleted"].to_int64());
+    m_trackedAtomIndex = static_cast<size_t>(node["trackedAtomIndex"].to_uint64());
+    if(m_initialStateRegistered && m_trackedAtomIndex >= m_currentState.getSelectionVector().size())
+    {
+        spdlog::error("The tracked atom of the motor {} is not part of its selection.", m_name);
+        return false;
+    }
+    return true;
+}
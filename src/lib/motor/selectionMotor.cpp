@@ -0,0 +1,57 @@
+#include <radahn/motor/selectionMotor.h>
+
+#include <spdlog/spdlog.h>
+
+void radahn::motor::SelectionMotor::collectSelection(std::vector<radahn::core::atomIndexes_t>& selection) const
+{
+    auto & vecSelection = m_currentState.getSelectionVector();
+    selection.insert(selection.end(), vecSelection.begin(), vecSelection.end());
+}
+
+void radahn::motor::SelectionMotor::collectReductions(conduit::Node& requests) const
+{
+    m_currentState.writeReductionRequest(requests.add_child(m_name), {});
+}
+
+void radahn::motor::SelectionMotor::applyReduction(radahn::core::simIt_t it, const conduit::Node& reduction)
+{
+    m_currentState.setReducedState(it, reduction);
+}
+
+void radahn::motor::SelectionMotor::saveState(conduit::Node& node) const
+{
+    Motor::saveState(node);
+    node["initialStateRegistered"] = static_cast<uint8_t>(m_initialStateRegistered ? 1 : 0);
+    m_currentState.saveState(node["currentState"]);
+    m_initialState.saveState(node["initialState"]);
+}
+
+bool radahn::motor::SelectionMotor::loadState(const conduit::Node& node)
+{
+    if(!Motor::loadState(node))
+        return false;
+
+    if(!node.has_child("initialStateRegistered") || !node.has_child("currentState") || !node.has_child("initialState"))
+    {
+        spdlog::error("Incomplete checkpoint for the selection of the motor {}.", m_name);
+        return false;
+    }
+
+    m_initialStateRegistered = node["initialStateRegistered"].to_uint8() > 0;
+    m_currentState.loadState(node["currentState"]);
+    m_initialState.loadState(node["initialState"]);
+    return true;
+}
+
+bool radahn::motor::SelectionMotor::loadVector(const conduit::Node& node, const std::string& name, std::array<double, 3>& values) const
+{
+    if(!node.has_child(name) || !node[name].dtype().is_float64() || node[name].dtype().number_of_elements() < 3)
+    {
+        spdlog::error("The checkpoint of the motor {} has no valid {} vector.", m_name, name);
+        return false;
+    }
+
+    const double* data = node[name].as_float64_ptr();
+    values = {data[0], data[1], data[2]};
+    return true;
+}
@@ -9,7 +9,6 @@ bool radahn::motor::TorqueMotor::updateState(radahn::core::simIt_t it,
         return false;
 
     m_currentState.selectAtoms(it, indices, positions);
-    auto selectedPositions = m_currentState.getCurrentSelectedPositions();
 
     // The torque uses the center of mass to anchor the rotation axis
     // Therefor, unlike the move rotate method, we have to recompute the centroid every iteration
@@ -32,7 +31,8 @@ bool radahn::motor::TorqueMotor::updateState(radahn::core::simIt_t it,
 
             // Save the first position
             // HYPOTHESIS: the atoms are always sorted, therefor the order of the atoms is always the same
-            m_trackedPointFirstIteration = {selectedPositions[m_trackedAtomIndex*3], selectedPositions[m_trackedAtomIndex*3+1], selectedPositions[m_trackedAtomIndex*3+2]};
+            auto trackedPosition = m_currentState.getSelectedAtomPosition(m_trackedAtomIndex);
+            m_trackedPointFirstIteration = {trackedPosition[0], trackedPosition[1], trackedPosition[2]};
             // Take two point very far away on the rotation axe to define a segment. GLM considers only a segment, not an infinite line for the projection.
             // Without this, the result of the projection will likely end up at an extremity of the segment so we make it long enough to "simulate" a line.
             m_trackedPointFirstIterationProjection = glm::closestPointOnLine(m_trackedPointFirstIteration, m_centroid - m_rotationAxis * 100000.0, m_centroid + m_rotationAxis * 100000.0);
@@ -62,6 +62,7 @@ bool radahn::motor::TorqueMotor::updateState(radahn::core::simIt_t it,
         
         m_firstIterationProjectionVector = glm::normalize(m_firstIterationProjectionVector);
         m_initialStateRegistered = true;
+        registerProgress(it, 0.0);
         return true;
     }
     
@@ -69,7 +70,8 @@ bool radahn::motor::TorqueMotor::updateState(radahn::core::simIt_t it,
     
 
     //glm::dvec3 pointOnAxe = centroid + axe;
-    glm::dvec3 trackedPointCurrent = {selectedPositions[m_trackedAtomIndex*3], selectedPositions[m_trackedAtomIndex*3+1], selectedPositions[m_trackedAtomIndex*3+2]};
+    auto trackedPosition = m_currentState.getSelectedAtomPosition(m_trackedAtomIndex);
+    glm::dvec3 trackedPointCurrent = {trackedPosition[0], trackedPosition[1], trackedPosition[2]};
     glm::dvec3 trackedPointProjection = glm::closestPointOnLine(trackedPointCurrent, m_centroid - m_rotationAxis * 10000000.0, m_centroid + m_rotationAxis * 10000000.0);
     glm::dvec3 currentIterationProjectionVector = trackedPointCurrent - trackedPointProjection;
     //double distanceFromAxis = glm::length(currentIterationProjectionVector);
@@ -93,8 +95,10 @@ bool radahn::motor::TorqueMotor::updateState(radahn::core::simIt_t it,
     m_totalRotationDeg = static_cast<double>(m_nbRotationCompleted) * 360.0 + rotationFromFirstDeg;
 
     kvs["progress"] = (m_totalRotationDeg / m_requestedAngle) * 100.0;
-    kvs["current_total_angle_deg"] = m_totalRotationDeg;
-    kvs["current_angle_deg"] = rotationFromFirstDeg;
+    registerProgress(it, (m_totalRotationDeg / m_requestedAngle) * 100.0);
+    // add_child doesn't copy the long names to parse them as a path at every frame
+    kvs.add_child("current_total_angle_deg") = m_totalRotationDeg;
+    kvs.add_child("current_angle_deg") = rotationFromFirstDeg;
     kvs["trackX"] = trackedPointCurrent.x;
     kvs["trackY"] = trackedPointCurrent.y;
     kvs["trackZ"] = trackedPointCurrent.z;
@@ -161,4 +165,4 @@ void radahn::motor::TorqueMotor::convertSettingsTo(radahn::core::SimUnits destUn
     m_tx.convertTo(destUnits);
     m_ty.convertTo(destUnits);
     m_tz.convertTo(destUnits);
-}
\ No newline at end of file
+}
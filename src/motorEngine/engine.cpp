@@ -1,4 +1,10 @@
 #include <string>
+#include <optional>
+#include <filesystem>
+#include <chrono>
+#include <map>
+
+#include <unistd.h>
 
 #include <godrick/mpi/godrickMPI.h>
 
@@ -8,6 +14,14 @@
 #include <conduit/conduit.hpp>
 
 #include <radahn/motor/motorEngine.h>
+#include <radahn/motor/ensembleKVS.h>
+#include <radahn/motor/packedKVS.h>
+#include <radahn/core/positionCodec.h>
+#include <radahn/core/frameCodec.h>
+#include <radahn/core/deltaCodec.h>
+#include <radahn/core/checkpoint.h>
+#include <radahn/core/phaseTimers.h>
+#include <radahn/core/shmFrameRing.h>
 #include <radahn/lmp/lammpsCommandsUtils.h>
 
 using namespace radahn::core;
@@ -35,38 +49,248 @@ void printSimulationData(std::vector<conduit::Node>& data)
     }
 }
 
-simIt_t mergeInputData(std::vector<conduit::Node>& receivedData, std::vector<atomIndexes_t>& outIndices, std::vector<atomPositions_t>& outPositions)
+// Motor graph of one simulation replica, with the decoding state of its frames
+struct Replica
 {
-    // Get the total nb of atoms
-    conduit::index_t totalNbAtoms = 0;
-    simIt_t simIt = 0;
+    MotorEngine engine;
+    DeltaDecoder positionsDecoder;
+    DeltaDecoder velocitiesDecoder;
+    // Decompressed fields of each chunk, kept between two frames so that they are decoded in place
+    std::vector<conduit::Node> decoded;
+    std::vector<conduit::Node*> chunks;     // Messages of the current frame, one per Lammps process of the replica
+    std::vector<const conduit::Node*> frames;   // "simdata" of the chunks, scattered by the engine
+};
+
+// Shared memory rings of the simulation ranks running on the same node as the engine
+struct SharedMemoryFrames
+{
+    std::string hostName;
+    std::map<std::string, std::unique_ptr<ShmFrameRing>> rings;
+    std::vector<std::pair<ShmFrameRing*, uint64_t>> inUse;     // Frames read in place during the current iteration
+    std::vector<std::string> accepted;                          // Rings opened during the current iteration
+
+    // Accept the rings offered by the simulation ranks of this node and point the "simdata" of the chunks
+    // written in a ring to their frame. The other chunks are received through MPI as usual.
+    void resolve(std::vector<conduit::Node>& chunks)
+    {
+        for(auto & chunk : chunks)
+        {
+            if(chunk.has_child("shmOffer"))
+            {
+                auto name = chunk["shmOffer"]["name"].as_string();
+                if(chunk["shmOffer"]["host"].as_string() == hostName && rings.count(name) == 0)
+                {
+                    auto ring = ShmFrameRing::open(name);
+                    if(ring)
+                    {
+                        spdlog::info("Reading the frames of the shared memory ring {}.", name);
+                        rings.emplace(name, std::move(ring));
+                        accepted.push_back(name);
+                    }
+                }
+            }
+
+            if(chunk.has_child("shm"))
+            {
+                auto ring = rings.find(chunk["shm"]["name"].as_string());
+                uint64_t seq = chunk["shm"]["seq"].to_uint64();
+                if(ring == rings.end() || !ring->second->view(seq, chunk["shm"]["schema"].as_string(), chunk["simdata"]))
+                {
+                    spdlog::critical("Unable to read the frame {} from the shared memory. Abording.", seq);
+                    exit(-1);
+                }
+                inUse.emplace_back(ring->second.get(), seq);
+            }
+        }
+    }
 
-    for(size_t i = 0; i < receivedData.size(); ++i)
+    // Tell the simulation ranks which rings were opened, they write their next frames there
+    void writeAccepted(conduit::Node& output) const
     {
-        auto & simData = receivedData[i]["simdata"];
-        totalNbAtoms += simData["atomIDs"].dtype().number_of_elements();
+        // The message is reused, the rings opened during a previous iteration are not listed again
+        if(output.has_child("shmAccepted"))
+            output.remove("shmAccepted");
+        for(auto & name : accepted)
+            output["shmAccepted"].append() = name;
     }
 
-    // Prepare the vectors
-    outIndices.reserve(static_cast<size_t>(totalNbAtoms));
-    outPositions.reserve(static_cast<size_t>(totalNbAtoms*3));
+    // The frames of the iteration are processed, the simulation can reuse their slots
+    void release()
+    {
+        for(auto & [ring, seq] : inUse)
+            ring->release(seq);
+        inUse.clear();
+        accepted.clear();
+    }
+};
 
-    // Copy the data to the vectors
-    for(size_t i = 0; i < receivedData.size(); ++i)
+// Rebuild the fields compressed against the previous frame in the chunks of the replica.
+// The decoders keep a reference per atom, the chunks are processed one after the other.
+simIt_t decodeInputData(Replica& replica)
+{
+    simIt_t simIt = 0;
+    replica.frames.clear();
+    if(replica.decoded.size() < replica.chunks.size())
+        replica.decoded.resize(replica.chunks.size());
+    for(size_t i = 0; i < replica.chunks.size(); ++i)
     {
-        auto & simData = receivedData[i]["simdata"];
+        auto & simData = (*replica.chunks[i])["simdata"];
         simIt = simData["simIt"].as_uint64();
         atomIndexes_t* indices = simData["atomIDs"].value();
         uint64_t nbAtoms = static_cast<uint64_t>(simData["atomIDs"].dtype().number_of_elements());
-        atomPositions_t* positions = simData["atomPositions"].value();
 
-        outIndices.insert(outIndices.end(), indices, indices + nbAtoms);
-        outPositions.insert(outPositions.end(), positions, positions + 3*nbAtoms);
+        // The velocities are not used by the engine but the decoder must follow every frame to keep its references
+        auto & decoded = replica.decoded[i];
+        if(simData.has_child("atomPositionsDelta"))
+        {
+            if(!replica.positionsDecoder.decode(indices, nbAtoms, simData.child("atomPositionsDelta"), decoded["atomPositions"]))
+            {
+                spdlog::critical("Unable to decompress the positions of the chunk {}. Abording.", i);
+                exit(-1);
+            }
+            simData["atomPositions"].set_external(decoded["atomPositions"]);
+        }
+        if(simData.has_child("atomVelocitiesDelta") && !replica.velocitiesDecoder.decode(indices, nbAtoms, simData.child("atomVelocitiesDelta"), decoded["atomVelocities"]))
+        {
+            spdlog::critical("Unable to decompress the velocities of the chunk {}. Abording.", i);
+            exit(-1);
+        }
+        replica.frames.push_back(&simData);
     }
 
     return simIt;
 }
 
+// The positions of every chunk are decoded directly at their ID in the engine arrays
+void loadReplicaFrame(Replica& replica, simIt_t receivedIt)
+{
+    if(!replica.engine.updateEngineState(receivedIt, replica.frames))
+    {
+        spdlog::critical("Unable to decode the positions received for the step {}. Abording.", receivedIt);
+        exit(-1);
+    }
+}
+
+// Rate limiting of the messages sent to the visualization. The engine only publishes the latest frame:
+// a frame arriving less than 1/targetFps after the previous publication of its stream is dropped before
+// being serialized. The number of dropped frames is reported in the global KVS. When the last frame of a
+// stream was dropped, it is published before closing (see takePending).
+class VisualizationPublisher
+{
+public:
+    enum Stream { ATOMS = 0, KVS = 1 };
+
+    // 0 publishes every frame
+    explicit VisualizationPublisher(double targetFps) :
+        m_period(targetFps > 0.0 ? std::chrono::duration<double>(1.0 / targetFps) : std::chrono::duration<double>(0.0)) {}
+
+    // Return true if the current frame of the stream must be published, count it as dropped otherwise
+    bool isDue(Stream stream)
+    {
+        auto now = clock::now();
+        if(m_published[stream] && now - *m_published[stream] < m_period)
+        {
+            m_dropped[stream]++;
+            m_pending[stream] = true;
+            return false;
+        }
+        m_published[stream] = now;
+        m_pending[stream] = false;
+        return true;
+    }
+
+    // Return true if the last frame of the stream was dropped and hasn't been published since
+    bool takePending(Stream stream)
+    {
+        bool pending = m_pending[stream];
+        m_pending[stream] = false;
+        return pending;
+    }
+
+    void exportTo(conduit::Node& node) const
+    {
+        node.add_child("viz_dropped_atoms") = m_dropped[ATOMS];
+        node.add_child("viz_dropped_kvs") = m_dropped[KVS];
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    std::chrono::duration<double> m_period;
+    std::optional<clock::time_point> m_published[2];
+    bool m_pending[2] = {false, false};
+    uint64_t m_dropped[2] = {0, 0};
+};
+
+// KVS sent on the kvs gate, either as it is or as packed value frames preceded by their schema (see packedKVS.h)
+struct KVSPublisher
+{
+    bool packed = false;
+    PackedKVSWriter writer;
+    conduit::Node schemaMsg;
+    conduit::Node valuesMsg;
+    uint64_t nbPublished = 0;
+
+    // A subscriber connecting after the schema was sent gets it with the next periodic resend
+    static constexpr uint64_t schemaEvery = 50;
+
+    void publish(godrick::mpi::GodrickMPI& handler, conduit::Node& kvs, simIt_t it)
+    {
+        if(!packed)
+        {
+            handler.push("kvs", kvs);
+            return;
+        }
+
+        if(writer.update(kvs) || nbPublished % schemaEvery == 0)
+        {
+            writer.writeSchema(schemaMsg);
+            handler.push("kvs", schemaMsg);
+        }
+        writer.writeValues(it, kvs, valuesMsg);
+        handler.push("kvs", valuesMsg);
+        nbPublished++;
+    }
+};
+
+// Commit the KVS frame of every replica and return the node to publish, the KVS of the simulation
+// or the statistics over the ensemble. The engine timers are added to the global KVS as engine_<phase> and restarted.
+// replicaKVS points to the KVS of each replica, it is built once as the engines keep their KVS for the whole run.
+conduit::Node& commitKVSFrames(std::vector<Replica>& replicas, const std::vector<const conduit::Node*>& replicaKVS, EnsembleKVS& ensemble, PhaseTimers& timers, const VisualizationPublisher& publisher)
+{
+    for(auto & replica : replicas)
+    {
+        replica.engine.addGlobalKVS((*replica.chunks[0])["thermos"]);    // All the nodes of a replica have the same thermo info, no need to check all the inputs
+        timers.exportTo(replica.engine.getCurrentKVS()["global"], "engine_");
+        publisher.exportTo(replica.engine.getCurrentKVS()["global"]);
+        replica.engine.commitKVSFrame();
+    }
+    timers.clear();
+
+    if(replicas.size() == 1)
+        return replicas[0].engine.getCurrentKVS();
+
+    ensemble.aggregate(replicas[0].engine.getCurrentIt(), replicaKVS);
+    return ensemble.getCurrentKVS();
+}
+
+// Publish the positions of the first replica on the atoms gate, as JSON or as a binary frame (see frameCodec.h)
+// The message and the frame buffer are kept between two calls, the values are rewritten in place.
+void pushAtoms(godrick::mpi::GodrickMPI& handler, MotorEngine& engine, std::optional<PositionEncoding> frameEncoding, std::vector<uint8_t>& frameBuffer, conduit::Node& atoms)
+{
+    if(frameEncoding)
+    {
+        encodePositionsFrame(engine.getCurrentIt(), engine.getCurrentPositions(), *frameEncoding, frameBuffer);
+        atoms["frame"].set(frameBuffer.data(), static_cast<conduit::index_t>(frameBuffer.size()));
+    }
+    else
+    {
+        atoms["positions"] = engine.getCurrentPositions();
+        atoms["simIt"] = engine.getCurrentIt();
+    }
+    handler.push("atoms", atoms);
+}
+
 int main(int argc, char** argv)
 {
     (void)argc;
@@ -78,6 +302,14 @@ int main(int argc, char** argv)
     std::string motorConfig;
     bool useTestMotors = false;
     bool forceMaxSteps = false;
+    bool publishROI = false;
+    bool useReductions = false;
+    std::string checkpointFolder = "checkpoint";
+    bool resume = false;
+    uint32_t nbReplicas = 1;
+    std::string atomsFormat = "json";
+    bool packedKVS = false;
+    double vizFps = 0.0;
 
     auto cli = lyra::cli()
         | lyra::opt( taskName, "name" )
@@ -97,7 +329,31 @@ int main(int argc, char** argv)
             ("Use the test motor setup.")
         | lyra::opt( forceMaxSteps)
             ["--forcemaxsteps"]
-            ("Continue the simulation until the maximum number of steps given, even if all the motors have completed.");
+            ("Continue the simulation until the maximum number of steps given, even if all the motors have completed.")
+        | lyra::opt( publishROI)
+            ["--roi"]
+            ("Send the union of the active motor selections to the simulation so that only these atoms are sent between two full frames.")
+        | lyra::opt( useReductions)
+            ["--reductions"]
+            ("Let the simulation compute the selection centers and tracked atoms needed by the motors so that no atom is sent between two full frames.")
+        | lyra::opt( checkpointFolder, "checkpointdir")
+            ["--checkpointdir"]
+            ("Folder shared with the simulation to store the checkpoints. Default to checkpoint.")
+        | lyra::opt( resume)
+            ["--resume"]
+            ("Restart the motors from the last checkpoint completed by both the simulation and the motor engine.")
+        | lyra::opt( nbReplicas, "replicas")
+            ["--replicas"]
+            ("Number of replicas (Lammps partitions) of the simulation. Each replica is steered by its own copy of the motors. Default to 1.")
+        | lyra::opt( atomsFormat, "atomsformat")
+            ["--atomsformat"]
+            ("Format of the positions published on the atoms gate: json, or float64/float32 for a binary frame. The binary frames require a gate using the conduit message format. Default to json.")
+        | lyra::opt( packedKVS)
+            ["--packedkvs"]
+            ("Publish the KVS as a schema message, sent again when the fields change, followed by frames of values only.")
+        | lyra::opt( vizFps, "vizfps")
+            ["--vizfps"]
+            ("Maximum number of frames per second published on the atoms and KVS gates, the frames in excess are dropped. Default to 0 (every frame).");
 
     auto result = cli.parse( { argc, argv } );
     if ( !result )
@@ -118,6 +374,29 @@ int main(int argc, char** argv)
         exit(1);
     }
 
+    if(useReductions && publishROI)
+    {
+        spdlog::warn("The reductions replace the region of interest, ignoring --roi.");
+        publishROI = false;
+    }
+
+    if(nbReplicas == 0)
+    {
+        spdlog::critical("At least one replica is required.");
+        exit(1);
+    }
+
+    std::optional<PositionEncoding> frameEncoding;
+    if(atomsFormat == "float64")
+        frameEncoding = PositionEncoding::FLOAT64;
+    else if(atomsFormat == "float32")
+        frameEncoding = PositionEncoding::FLOAT32;
+    else if(atomsFormat != "json")
+    {
+        spdlog::critical("Unknown atoms format {}. Expected json, float64 or float32.", atomsFormat);
+        exit(1);
+    }
+
     spdlog::info("Starting the task {}.", taskName);
 
     auto handler = godrick::mpi::GodrickMPI();
@@ -131,27 +410,72 @@ int main(int argc, char** argv)
         exit(-1);
     }
 
-    // Create the engine and add a test set of motors
-    auto engine = radahn::motor::MotorEngine();
-
-    if(useTestMotors)
+    // One motor graph per simulation replica, all created from the same setup
+    std::vector<Replica> replicas(nbReplicas);
+    for(auto & replica : replicas)
     {
-        spdlog::info("Loading the test motor setup.");
-        engine.loadTestMotorSetup();
+        if(useTestMotors)
+        {
+            spdlog::info("Loading the test motor setup.");
+            replica.engine.loadTestMotorSetup();
+        }
+        else if(!motorConfig.empty())
+        {
+            spdlog::info("Loading the motor setup {}.", motorConfig);
+            replica.engine.loadFromJSON(motorConfig);    
+        }
     }
-    else if(!motorConfig.empty())
+    if(nbReplicas > 1)
+        spdlog::info("Steering an ensemble of {} replicas.", nbReplicas);
+    EnsembleKVS ensemble;
+    std::vector<const conduit::Node*> replicaKVS;
+    for(auto & replica : replicas)
+        replicaKVS.push_back(&replica.engine.getCurrentKVS());
+
+    // The state is applied once the motors are converted to the simulation units
+    conduit::Node resumeState;
+    std::optional<simIt_t> resumeStep;
+    if(resume)
     {
-        spdlog::info("Loading the motor setup {}.", motorConfig);
-        engine.loadFromJSON(motorConfig);    
+        std::vector<std::string> prefixes({"engine"});
+        for(uint32_t i = 0; i < nbReplicas; ++i)
+            prefixes.push_back(getSimulationCheckpointPrefix(i, nbReplicas));
+        resumeStep = findLastCheckpoint(checkpointFolder, prefixes);
+        if(!resumeStep)
+        {
+            spdlog::critical("No complete checkpoint found in {}. Unable to resume.", checkpointFolder);
+            exit(-1);
+        }
+        spdlog::info("Resuming the motors from the checkpoint of the step {}.", *resumeStep);
+        resumeState.load(getCheckpointPath(checkpointFolder, "engine", *resumeStep), "conduit_bin");
     }
 
     std::vector<conduit::Node> receivedData;
     std::vector<conduit::Node> receivedUserCmd;
+    std::vector<uint8_t> frameBuffer;
+    conduit::Node atomsMessage;
+    // Commands sent to the simulation, rewritten in place at every frame
+    conduit::Node commandsMessage;
+    conduit::Node emptyCommandsMessage;
+    std::vector<atomIndexes_t> roi;
+    VisualizationPublisher publisher(vizFps);
+    KVSPublisher kvsPublisher;
+    kvsPublisher.packed = packedKVS;
     bool unitSet = false;
+    std::string previousPhase;
 
+    SharedMemoryFrames sharedFrames;
+    char hostName[256] = {};
+    gethostname(hostName, sizeof(hostName) - 1);
+    sharedFrames.hostName = hostName;
 
+    // Time spent in each phase of the loop, added to the global KVS
+    PhaseTimers timers;
+    timers.start("get");
     while(handler.get("atoms", receivedData) == godrick::MessageResponse::MESSAGES)
     {
+        timers.stop("get");
+
         // Debug
         //printSimulationData(receivedData);
 
@@ -193,108 +517,248 @@ int main(int argc, char** argv)
         // We received a stop command, exiting the iteration loop
         if(terminateLoop)
             break;
-        
 
-        // Merge all the data into individual arrays instead of partial arrays
-        // This is necessary when Lammps is running on multiple MPI processes, we receive as many 
-        // messages as Lammps MPI processes
-        // This cause a double memory footprint but avoid having to deal with partial arrays everywhere
-        std::vector<atomIndexes_t> fullIndices;
-        std::vector<atomPositions_t> fullPositions;
-        auto receivedIt = mergeInputData(receivedData, fullIndices, fullPositions);
+        // The chunks written in shared memory only carry the location of their frame
+        sharedFrames.resolve(receivedData);
+
+        // The partitions of the simulation send their chunks in the same message set, sorting them by replica
+        for(auto & replica : replicas)
+            replica.chunks.clear();
+        for(auto & chunk : receivedData)
+        {
+            uint32_t replicaIndex = 0;
+            if(chunk["simdata"].has_child("replica"))
+                replicaIndex = chunk["simdata"]["replica"].to_uint32();
+            if(replicaIndex >= nbReplicas)
+            {
+                spdlog::critical("Received a frame from the replica {} but the engine expects {} replicas. Abording.", replicaIndex, nbReplicas);
+                exit(-1);
+            }
+            replicas[replicaIndex].chunks.push_back(&chunk);
+        }
+        for(uint32_t i = 0; i < nbReplicas; ++i)
+        {
+            if(replicas[i].chunks.empty())
+            {
+                spdlog::critical("No frame received from the replica {}. Abording.", i);
+                exit(-1);
+            }
+        }
+
+        // We receive as many messages as Lammps MPI processes. They are not merged, the engine
+        // reads the positions of each chunk in place and writes them at their ID.
+        timers.start("decode");
+        simIt_t receivedIt = 0;
+        for(auto & replica : replicas)
+            receivedIt = decodeInputData(replica);
+        timers.stop("decode");
 
         // Switch the motors settings to the simulation settings
         if(!unitSet)
         {
 
             auto unitSim = radahn::core::SimUnits(receivedData[0]["simdata"]["units"].as_uint8());
-            engine.convertMotorsTo(unitSim);
+            for(auto & replica : replicas)
+                replica.engine.convertMotorsTo(unitSim);
             unitSet = true;
+
+            if(resumeStep)
+            {
+                bool restored = true;
+                if(nbReplicas == 1)
+                    restored = replicas[0].engine.loadState(resumeState);
+                else if(!resumeState.has_child("replicas") || resumeState["replicas"].number_of_children() != static_cast<conduit::index_t>(nbReplicas))
+                    restored = false;
+                else
+                {
+                    for(uint32_t i = 0; i < nbReplicas; ++i)
+                        restored &= replicas[i].engine.loadState(resumeState["replicas"].child(static_cast<conduit::index_t>(i)));
+                }
+
+                if(!restored)
+                {
+                    spdlog::critical("Unable to restore the motors from the checkpoint. Abording.");
+                    exit(-1);
+                }
+            }
         }
 
 
         spdlog::info("Received simulation data Step {}", receivedIt);
-        //for(uint64_t i = 0; i < fullIndices.size(); ++i)
-        //    spdlog::info("{} {} {}", fullPositions[3*i], fullPositions[3*i+1], fullPositions[3*i+2]);
 
 
         // Check in which phase we are
+        // The replicas run the same number of steps, they are all in the same phase
         auto phase = receivedData[0]["simdata"]["phase"].as_string();
+
+        // The global KVS is rewritten in place at each frame, the thermo fields change with the phase
+        if(phase != previousPhase)
+        {
+            for(auto & replica : replicas)
+            {
+                if(replica.engine.getCurrentKVS().has_child("global"))
+                    replica.engine.getCurrentKVS().remove("global");
+            }
+            previousPhase = phase;
+        }
+
         //std::string phase{"NVE"};
+        // Frames restricted to the region of interest only update the atoms used by the motors,
+        // they are not forwarded to the visualization
+        bool fullFrame = true;
+        if(receivedData[0]["simdata"].has_child("fullFrame"))
+            fullFrame = receivedData[0]["simdata"]["fullFrame"].to_uint8() > 0;
+
         if(phase.compare("NVT") == 0)
         {
             // During the NVT phase, we don't execute the motors yet. 
             // We only update the state of the engine, but not the motors
-            engine.updateEngineState(receivedIt, fullIndices, fullPositions);
+            for(auto & replica : replicas)
+                loadReplicaFrame(replica, receivedIt);
 
             // Sending an empty message to keep the loop going.
-            conduit::Node cmdOutput;
-            handler.push("motorscmd", cmdOutput);
+            sharedFrames.writeAccepted(emptyCommandsMessage);
+            handler.push("motorscmd", emptyCommandsMessage);
 
+            // The KVS frame is committed for the CSV files even when it is not published
             // This is kinda dangerous because the push operation may modify the Node
             // In this case it's fine because it's the instruction before the next iteration
-            engine.addGlobalKVS(receivedData[0]["thermos"]);    // All the nodes have the same thermo info, no need to check all the inputs
-            engine.commitKVSFrame();
-            conduit::Node& temporalData = engine.getCurrentKVS();
-            
-            //temporalData["global"] = receivedData[0]["thermos"];
-            handler.push("kvs", temporalData);
+            // Both streams are decided first so that the exported drop counters include this frame
+            bool publishKVS = publisher.isDue(VisualizationPublisher::KVS);
+            bool publishAtoms = publisher.isDue(VisualizationPublisher::ATOMS);
+            auto & kvs = commitKVSFrames(replicas, replicaKVS, ensemble, timers, publisher);
+            if(publishKVS)
+                kvsPublisher.publish(handler, kvs, receivedIt);
 
 
             // Send the atom positions to the outside 
-            conduit::Node atoms;
-            atoms["positions"] = engine.getCurrentPositions();
-            atoms["simIt"] = engine.getCurrentIt();
-            handler.push("atoms", atoms);
+            // With an ensemble, the visualization follows the first replica
+            if(publishAtoms)
+                pushAtoms(handler, replicas[0].engine, frameEncoding, frameBuffer, atomsMessage);
         }
         else if (phase.compare("NVE") == 0)
         {
-            engine.updateMotorsState(receivedIt, fullIndices, fullPositions);
+            timers.start("update");
+            bool allCompleted = true;
+            for(auto & replica : replicas)
+            {
+                // The reductions are computed by the simulation for the motors, they are sent by its first rank
+                for(auto chunk : replica.chunks)
+                {
+                    if((*chunk)["simdata"].has_child("reductions"))
+                        replica.engine.applyReductions(receivedIt, (*chunk)["simdata"]["reductions"]);
+                }
 
-            if(engine.isCompleted())
+                // When resuming, the simulation sends the checkpoint frame again. It was already processed by the motors.
+                loadReplicaFrame(replica, receivedIt);
+                if(!resumeStep || receivedIt != *resumeStep)
+                    replica.engine.updateMotors(receivedIt);
+                allCompleted &= replica.engine.isCompleted();
+            }
+            timers.stop("update");
+
+            if(allCompleted && !forceMaxSteps)
             {
-                if(forceMaxSteps)
+                spdlog::info("Motor engine has completed. Exiting the main loop.");
+                replicas[0].engine.getCurrentKVS().print();
+                break;
+            }
+
+            // With an ensemble, each partition reads the commands of its replica
+            // The replicas stay synchronized, they all run the shortest interval suggested
+            timers.start("commands");
+            auto & output = commandsMessage;
+            simIt_t nextInterval = 0;
+            if(nbReplicas > 1)
+            {
+                // One child per replica, created with the first frame
+                auto & replicasOutput = output["replicas"];
+                while(replicasOutput.number_of_children() < static_cast<conduit::index_t>(nbReplicas))
+                    replicasOutput.append();
+            }
+            for(uint32_t i = 0; i < nbReplicas; ++i)
+            {
+                auto & replica = replicas[i];
+                conduit::Node& replicaOutput = nbReplicas == 1 ? output : output["replicas"].child(static_cast<conduit::index_t>(i));
+                if(replica.engine.isCompleted())
                 {
                     // Sending a blank command in this case to keep the loop going. The Lammps
-                    // component will send a terminate message when the maximum number of steps has been reached.
-                    conduit::Node output;
-                    radahn::lmp::LammpsCommandsUtils::registerWaitCommandToConduit(output["lmpcmds"].append(), "motorEngine");
-                    handler.push("motorscmd", output);
+                    // component will send a terminate message when the maximum number of steps has been reached
+                    // or when all the replicas have completed.
+                    auto & cmds = replicaOutput["lmpcmds"];
+                    radahn::lmp::LammpsCommandsUtils::registerWaitCommandToConduit(radahn::lmp::LammpsCommandsUtils::reuseCommandNode(cmds, 0, "motorEngine"), "motorEngine");
+                    radahn::lmp::LammpsCommandsUtils::trimCommands(cmds, 1);
+                    if(publishROI)
+                        replicaOutput["roi"] = std::vector<atomIndexes_t>();
+                    if(useReductions)
+                        replicaOutput["reductions"].set(conduit::DataType::object());
+                    continue;
                 }
-                else
+
+                // Get commands from the motor
+                replica.engine.getCommandsFromMotors(replicaOutput["lmpcmds"]);
+
+                // Length of the next interval suggested to the simulation so that the closest motor
+                // stops near its target instead of overshooting by a full interval
+                auto suggested = replica.engine.getSuggestedInterval();
+                if(suggested > 0 && (nextInterval == 0 || suggested < nextInterval))
+                    nextInterval = suggested;
+
+                if(publishROI)
                 {
-                    spdlog::info("Motor engine has completed. Exiting the main loop.");
-                    engine.getCurrentKVS().print();
-                    break;
+                    replica.engine.getActiveSelection(roi);
+                    replicaOutput["roi"] = roi;
                 }
-            }
-            else 
-            {
-                // Get commands from the motor
-                conduit::Node output;
-                engine.getCommandsFromMotors(output["lmpcmds"].append());
 
-                handler.push("motorscmd", output);
+                if(useReductions)
+                    replica.engine.getReductionRequests(replicaOutput["reductions"]);
             }
+            if(nextInterval > 0)
+                output["nextInterval"] = nextInterval;
+            else if(output.has_child("nextInterval"))
+                output.remove("nextInterval");
+            // The simulation may already be several intervals ahead of this frame (command lag)
+            output["sourceIt"] = receivedIt;
+            sharedFrames.writeAccepted(output);
+            timers.stop("commands");
+
+            timers.start("push");
+            handler.push("motorscmd", output);
+            timers.stop("push");
 
             // This is kinda dangerous because the push operation may modify the Node
             // In this case it's fine because it's the instruction before the next iteration
-            engine.addGlobalKVS(receivedData[0]["thermos"]);    // All the nodes have the same thermo info, no need to check all the inputs
-            engine.commitKVSFrame();
-            conduit::Node& temporalData = engine.getCurrentKVS();
-            
-            //temporalData["global"] = receivedData[0]["thermos"];
-            handler.push("kvs", temporalData);
+            bool publishKVS = publisher.isDue(VisualizationPublisher::KVS);
+            bool publishAtoms = fullFrame && publisher.isDue(VisualizationPublisher::ATOMS);
+            auto & kvs = commitKVSFrames(replicas, replicaKVS, ensemble, timers, publisher);
+            if(publishKVS)
+                kvsPublisher.publish(handler, kvs, receivedIt);
 
 
             // Send the atom positions to the outside 
-            conduit::Node atoms;
-            atoms["positions"] = engine.getCurrentPositions();
-            atoms["simIt"] = engine.getCurrentIt();
-            handler.push("atoms", atoms);
+            if(publishAtoms)
+                pushAtoms(handler, replicas[0].engine, frameEncoding, frameBuffer, atomsMessage);
 
             // Iterations is finished, processing the motor state and prepare the motor lists for the next iteration
-            engine.updateMotorLists();
+            for(auto & replica : replicas)
+                replica.engine.updateMotorLists();
+
+            // The simulation wrote its checkpoint for this step before sending the frame
+            if(receivedData[0]["simdata"].has_child("checkpoint"))
+            {
+                conduit::Node state;
+                if(nbReplicas == 1)
+                    replicas[0].engine.saveState(state);
+                else
+                {
+                    for(auto & replica : replicas)
+                        replica.engine.saveState(state["replicas"].append());
+                }
+                std::filesystem::create_directories(checkpointFolder);
+                state.save(getCheckpointPath(checkpointFolder, "engine", receivedIt), "conduit_bin");
+                pruneCheckpoints(checkpointFolder, "engine", 2);
+                spdlog::info("Motor engine checkpoint written for the step {}.", receivedIt);
+            }
         }
         else 
         {
@@ -303,6 +767,8 @@ int main(int argc, char** argv)
         }
 
         receivedData.clear();
+        sharedFrames.release();
+        timers.start("get");
 
         //engine.getCurrentKVS().print();
 
@@ -312,7 +778,27 @@ int main(int argc, char** argv)
     //spdlog::info("Cleaning the motor engine...");
     //engine.clearMotors();
     //spdlog::info("Motor engine cleaned.");
-    engine.saveKVSToCSV();
+    if(nbReplicas == 1)
+        replicas[0].engine.saveKVSToCSV();
+    else
+    {
+        for(uint32_t i = 0; i < nbReplicas; ++i)
+        {
+            auto folder = "replica" + std::to_string(i);
+            std::filesystem::create_directories(folder);
+            replicas[i].engine.saveKVSToCSV(folder);
+        }
+        ensemble.saveToCSV();
+    }
+
+    // The latest frames dropped by the rate limiting are published before closing
+    if(publisher.takePending(VisualizationPublisher::KVS))
+    {
+        auto & kvs = nbReplicas == 1 ? replicas[0].engine.getCurrentKVS() : ensemble.getCurrentKVS();
+        kvsPublisher.publish(handler, kvs, replicas[0].engine.getCurrentIt());
+    }
+    if(publisher.takePending(VisualizationPublisher::ATOMS))
+        pushAtoms(handler, replicas[0].engine, frameEncoding, frameBuffer, atomsMessage);
 
     spdlog::info("Engine exited loop. Closing...");
     handler.close();
@@ -0,0 +1,218 @@
+// Check that the parts of the steering loop reusing their buffers don't allocate once the first frames are processed.
+// The frame follows the sequence of the engine for the NVE phase: delta decoding, scatter of the chunks by the thread pool
+// (the frame is large enough to be split), update of the motors and their KVS, commands, region of interest and
+// reduction requests sent back to the simulation, global KVS, atoms gate frame and phase timers.
+// The simulation side is covered by the position encodings.
+//
+// Bounded, not zero:
+// - the motors append a CSV row at every update. The history grows with the run, its buffer doubles and only
+//   reallocates a few times over the frames.
+// Not covered:
+// - the global CSV history (commitKVSFrame), which keeps a map of the fields for every frame;
+// - the delta encoder output, its payload is sized on the compressed frame and a conduit array can't keep a larger capacity
+//   without sending it;
+// - the driver message assembly, which needs Lammps, and the transport.
+
+#include <radahn/core/positionCodec.h>
+#include <radahn/core/deltaCodec.h>
+#include <radahn/core/frameCodec.h>
+#include <radahn/core/phaseTimers.h>
+#include <radahn/motor/motorEngine.h>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+
+namespace
+{
+
+std::atomic<uint64_t> nbAllocations = 0;
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    nbAllocations++;
+    if(void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+using namespace radahn::core;
+using namespace radahn::motor;
+
+int main()
+{
+    // Two chunks of 1 << 16 atoms, the engine scatters them with its thread pool
+    constexpr size_t nbChunks = 2;
+    const uint64_t nbAtomsPerChunk = 1 << 16;
+    const double boxLo[3] = {0.0, 0.0, 0.0};
+    const double boxHi[3] = {100.0, 100.0, 100.0};
+
+    // A wait motor and a force motor which doesn't reach its target during the test
+    auto motorConfig = (std::filesystem::temp_directory_path() / "radahn_test_motors.json").string();
+    {
+        std::ofstream config(motorConfig);
+        config << R"({"header": {"version": 1, "units": "LAMMPS_REAL"}, "motors": [)"
+               << R"({"type": "blank", "name": "wait", "nbStepsRequested": 1000000},)"
+               << R"({"type": "force", "name": "pull", "selection": [1, 2, 3, 4, 5, 6, 7, 8, 70000, 70001], "fx": 0.1, "checkX": true, "dx": 1000.0}]})";
+    }
+    MotorEngine engine;
+    bool loaded = engine.loadFromJSON(motorConfig);
+    std::filesystem::remove(motorConfig);
+    if(!loaded || !engine.updateMotorLists())
+    {
+        spdlog::error("Unable to load the test motors.");
+        return EXIT_FAILURE;
+    }
+
+    std::vector<atomPositions_t> positions(3*nbAtomsPerChunk);
+    std::array<std::vector<atomIndexes_t>, nbChunks> ids;
+    for(auto & chunkIDs : ids)
+        chunkIDs.resize(nbAtomsPerChunk);
+
+    conduit::Node float64Frame;
+    conduit::Node float32Frame;
+    conduit::Node fixed16Frame;
+    std::vector<uint8_t> gateFrame;
+    conduit::Node timersNode;
+    conduit::Node globals;
+    conduit::Node commands;
+    std::vector<atomIndexes_t> roi;
+    PhaseTimers timers;
+
+    // Chunks received by the engine, compressed against the previous frame by each rank
+    std::array<DeltaEncoder, nbChunks> encoders;
+    std::array<DeltaDecoder, nbChunks> decoders;
+    std::array<conduit::Node, nbChunks> chunks;
+    std::array<conduit::Node, nbChunks> decoded;
+    std::vector<const conduit::Node*> frames = {&chunks[0], &chunks[1]};
+
+    const uint32_t nbWarmupFrames = 3;
+    const uint32_t nbFrames = 50;
+    uint64_t steadyAllocations = 0;
+    uint64_t historyAllocations = 0;
+    for(uint32_t frame = 0; frame < nbWarmupFrames + nbFrames; ++frame)
+    {
+        auto before = nbAllocations.load();
+        uint64_t excluded = 0;
+        uint64_t history = 0;
+
+        for(size_t c = 0; c < nbChunks; ++c)
+        {
+            // Atoms received in reverse order, as they would from several ranks
+            for(uint64_t i = 0; i < nbAtomsPerChunk; ++i)
+            {
+                ids[c][i] = static_cast<atomIndexes_t>((c + 1) * nbAtomsPerChunk - i);
+                for(uint64_t axis = 0; axis < 3; ++axis)
+                    positions[3*i+axis] = static_cast<double>(i + axis + frame + c) * 0.001;
+            }
+
+            // Simulation side
+            timers.start("extract");
+            encodePositions(PositionEncoding::FLOAT64, positions.data(), nbAtomsPerChunk, boxLo, boxHi, float64Frame);
+            encodePositions(PositionEncoding::FLOAT32, positions.data(), nbAtomsPerChunk, boxLo, boxHi, float32Frame);
+            encodePositions(PositionEncoding::FIXED16, positions.data(), nbAtomsPerChunk, boxLo, boxHi, fixed16Frame);
+            timers.stop("extract");
+
+            // Message received by the engine, not counted
+            auto excludedStart = nbAllocations.load();
+            auto & chunk = chunks[c];
+            chunk["simIt"] = static_cast<uint64_t>(frame);
+            chunk["atomIDs"].set(ids[c].data(), static_cast<conduit::index_t>(nbAtomsPerChunk));
+            encoders[c].encode(ids[c].data(), nbAtomsPerChunk, float64Frame["atomPositions"], chunk.add_child("atomPositionsDelta"));
+            excluded += nbAllocations.load() - excludedStart;
+
+            // Engine side
+            timers.start("update");
+            if(!decoders[c].decode(ids[c].data(), nbAtomsPerChunk, chunk.child("atomPositionsDelta"), decoded[c]))
+            {
+                spdlog::error("Unable to decode the chunk {} of the frame {}.", c, frame);
+                return EXIT_FAILURE;
+            }
+            excludedStart = nbAllocations.load();
+            chunk["atomPositions"].set_external(decoded[c]);
+            excluded += nbAllocations.load() - excludedStart;
+            timers.stop("update");
+        }
+
+        timers.start("update");
+        if(!engine.updateEngineState(frame, frames))
+        {
+            spdlog::error("Unable to scatter the frame {}.", frame);
+            return EXIT_FAILURE;
+        }
+        auto historyStart = nbAllocations.load();
+        engine.updateMotors(frame);
+        history += nbAllocations.load() - historyStart;
+        timers.stop("update");
+
+        timers.start("commands");
+        engine.getCommandsFromMotors(commands["lmpcmds"]);
+        engine.getActiveSelection(roi);
+        commands["roi"] = roi;
+        engine.getReductionRequests(commands["reductions"]);
+        commands["nextInterval"] = engine.getSuggestedInterval();
+        timers.stop("commands");
+
+        globals["simIt"] = static_cast<uint64_t>(frame);
+        globals["temp"] = 300.0 + frame;
+        engine.addGlobalKVS(globals);
+        timers.exportTo(engine.getCurrentKVS()["global"], "engine_");
+        auto excludedStart = nbAllocations.load();
+        engine.commitKVSFrame();
+        excluded += nbAllocations.load() - excludedStart;
+
+        timers.start("push");
+        encodePositionsFrame(engine.getCurrentIt(), engine.getCurrentPositions(), PositionEncoding::FLOAT32, gateFrame);
+        timers.stop("push");
+
+        if(!engine.updateMotorLists() || engine.isCompleted())
+        {
+            spdlog::error("The test motors stopped at the frame {}.", frame);
+            return EXIT_FAILURE;
+        }
+
+        timers.exportTo(timersNode, "engine_");
+        timers.clear();
+
+        auto allocations = nbAllocations.load() - before - excluded - history;
+        if(frame >= nbWarmupFrames)
+        {
+            steadyAllocations += allocations;
+            historyAllocations += history;
+        }
+    }
+
+    bool result = true;
+    if(steadyAllocations > 0)
+    {
+        spdlog::error("{} allocations during the {} frames following the warmup.", steadyAllocations, nbFrames);
+        result = false;
+    }
+    // A motor allocating at every update would reach the number of frames
+    if(historyAllocations >= nbFrames)
+    {
+        spdlog::error("{} allocations by the motor updates during the {} frames following the warmup.", historyAllocations, nbFrames);
+        result = false;
+    }
+    if(!result)
+        return EXIT_FAILURE;
+
+    spdlog::info("No allocation during the {} frames following the warmup, {} by the CSV history of the motors.", nbFrames, historyAllocations);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include <radahn/core/commandJournal.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdlib>
+#include <filesystem>
+
+using namespace radahn::core;
+
+// Write the entries in a journal, read it back and compare the entries in order
+bool checkRoundTrip(const std::string& name, const std::vector<JournalEntry>& entries, size_t maxStrings)
+{
+    auto path = (std::filesystem::temp_directory_path() / "radahn_test.journal").string();
+
+    {
+        CommandJournalWriter writer(path, 64, maxStrings);
+        if(!writer.isOpen())
+        {
+            spdlog::error("{}: unable to create the journal {}.", name, path);
+            return false;
+        }
+        for(auto & entry : entries)
+        {
+            if(entry.type == JournalRecord::COMMAND)
+                writer.appendCommand(entry.content);
+            else if(entry.type == JournalRecord::SCRIPT)
+                writer.appendScript(entry.content);
+            else
+                writer.appendBlob(entry.tag, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(entry.content.data()), entry.content.size()));
+        }
+        writer.close();
+    }
+
+    CommandJournalReader reader;
+    bool result = reader.open(path);
+    size_t nbRead = 0;
+    JournalEntry entry;
+    while(result && reader.next(entry))
+    {
+        if(nbRead >= entries.size()
+            || entry.type != entries[nbRead].type
+            || entry.content != entries[nbRead].content
+            || (entry.type == JournalRecord::BLOB && entry.tag != entries[nbRead].tag))
+        {
+            spdlog::error("{}: the entry {} read back doesn't match \"{}\".", name, nbRead, entry.content);
+            result = false;
+        }
+        nbRead++;
+    }
+    if(result && nbRead != entries.size())
+    {
+        spdlog::error("{}: read {} entries instead of {}.", name, nbRead, entries.size());
+        result = false;
+    }
+    std::filesystem::remove(path);
+
+    if(result)
+        spdlog::info("{} passed.", name);
+    return result;
+}
+
+int main()
+{
+    std::vector<JournalEntry> entries;
+    auto addCommand = [&entries](const std::string& cmd) { entries.push_back({JournalRecord::COMMAND, "", cmd}); };
+
+    entries.push_back({JournalRecord::SCRIPT, "", "units metal\natom_style atomic\nread_data system.data\n"});
+    for(uint32_t step = 0; step < 20; ++step)
+    {
+        addCommand("#### LOOP NVE Start from Timestep " + std::to_string(step * 100) + " #####");
+        // Selections are interned, the same ones are used by several steps
+        addCommand("group motor" + std::to_string(step % 3) + "GRP id 1 2 3 4 5 " + std::to_string(10 + step % 3));
+        addCommand("fix motorID motorGRP addforce " + std::to_string(0.5 * step) + " -1.25e-3 0");
+        addCommand("run " + std::to_string(100 + step) + " pre no post no");
+        // Binary payloads, with the byte used as argument marker in the command templates
+        std::string payload = {'\x00', '\x01', static_cast<char>(step), '\xff'};
+        entries.push_back({JournalRecord::BLOB, "actions/radahnMotors", payload});
+    }
+    // Spacing and lone integers are kept as is
+    addCommand("velocity  all create 300.0 4928459 ");
+    addCommand("");
+
+    bool result = true;
+    result &= checkRoundTrip("Journal round trip", entries, 1 << 16);
+    // A small table resets the strings many times, including in the middle of a command
+    result &= checkRoundTrip("Journal round trip with resets", entries, 3);
+
+    return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
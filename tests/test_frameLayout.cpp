@@ -0,0 +1,52 @@
+#include <radahn/core/frameLayout.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdlib>
+
+using namespace radahn::core;
+
+// Check that ids placed at their position in order are sorted, and that dense is only reported for the IDs 1..nbAtoms
+bool checkOrder(const std::string& name, const std::vector<atomIndexes_t>& ids, bool expectedDense)
+{
+    std::vector<size_t> order;
+    bool dense = computeSortedOrder(ids.data(), ids.size(), order);
+    if(dense != expectedDense)
+    {
+        spdlog::error("{}: frame reported {} dense.", name, dense ? "as" : "as not");
+        return false;
+    }
+
+    std::vector<atomIndexes_t> sorted(ids.size(), 0);
+    for(size_t i = 0; i < ids.size(); ++i)
+    {
+        if(order[i] >= ids.size() || sorted[order[i]] != 0)
+        {
+            spdlog::error("{}: invalid position {} for the atom {}.", name, order[i], ids[i]);
+            return false;
+        }
+        sorted[order[i]] = ids[i];
+    }
+    for(size_t i = 0; i < sorted.size(); ++i)
+    {
+        if((i > 0 && sorted[i-1] >= sorted[i]) || (dense && sorted[i] != i + 1))
+        {
+            spdlog::error("{}: the atom {} is misplaced at the position {}.", name, sorted[i], i);
+            return false;
+        }
+    }
+    spdlog::info("{} passed.", name);
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+    result &= checkOrder("Dense frame", {3, 1, 4, 2, 5}, true);
+    // Deleted atoms leave gaps in the IDs, the frame can't be indexed by ID
+    result &= checkOrder("Frame with gaps", {7, 1, 4, 2, 5}, false);
+    // Region of interest, the IDs are within 1..nbAtoms of the simulation but not of the frame
+    result &= checkOrder("Partial frame", {9, 3, 6}, false);
+    result &= checkOrder("Empty frame", {}, true);
+
+    return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
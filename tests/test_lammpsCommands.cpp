@@ -0,0 +1,113 @@
+#include <radahn/lmp/lammpsCommandsUtils.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdlib>
+#include <sstream>
+
+using namespace radahn::core;
+using namespace radahn::lmp;
+
+// Build the commands sent by the engine for a fixed motor and a force motor
+conduit::Node buildCommands(double fx, const std::vector<atomIndexes_t>& forceSelection)
+{
+    conduit::Node cmds;
+    LammpsCommandsUtils::registerMoveCommandToConduit(
+        cmds["lmpcmds"].append(),
+        "move",
+        VelocityQuantity(0.0, SimUnits::LAMMPS_REAL),
+        VelocityQuantity(0.0, SimUnits::LAMMPS_REAL),
+        VelocityQuantity(0.0, SimUnits::LAMMPS_REAL),
+        {1, 2, 3});
+    LammpsCommandsUtils::registerAddForceCommandToConduit(
+        cmds["lmpcmds"].append(),
+        "force",
+        ForceQuantity(fx, SimUnits::LAMMPS_REAL),
+        ForceQuantity(0.0, SimUnits::LAMMPS_REAL),
+        ForceQuantity(0.0, SimUnits::LAMMPS_REAL),
+        forceSelection);
+    return cmds;
+}
+
+// Apply the commands and check the Lammps commands between the UPDATE markers
+bool checkUpdate(const std::string& name, LammpsCommandsUtils& utils, conduit::Node cmds, const std::vector<std::string>& expected)
+{
+    if(!utils.loadCommandsFromConduit(cmds))
+    {
+        spdlog::error("{}: unable to load the commands.", name);
+        return false;
+    }
+
+    std::vector<std::string> lmpCmds;
+    if(!utils.writeUpdateCommands(lmpCmds) || lmpCmds.size() < 2)
+    {
+        spdlog::error("{}: unable to write the update commands.", name);
+        return false;
+    }
+    std::vector<std::string> updates(lmpCmds.begin() + 1, lmpCmds.end() - 1);
+
+    if(updates != expected)
+    {
+        spdlog::error("{}: expected {} commands, got {}:", name, expected.size(), updates.size());
+        for(auto & cmd : updates)
+            spdlog::error("    {}", cmd);
+        return false;
+    }
+    spdlog::info("{} passed.", name);
+    return true;
+}
+
+// Check the ID list written for a Lammps group
+bool checkSelection(const std::string& name, const std::vector<atomIndexes_t>& selection, const std::string& expected)
+{
+    std::stringstream ss;
+    LammpsCommandsUtils::writeIdSelection(ss, selection);
+    if(ss.str() != expected)
+    {
+        spdlog::error("{}: expected \"{}\", got \"{}\".", name, expected, ss.str());
+        return false;
+    }
+    spdlog::info("{} passed.", name);
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= checkSelection("Empty selection", {}, "");
+    result &= checkSelection("Duplicated IDs", {5, 5, 6, 7, 7}, " 5:7");
+    // Two IDs are shorter as a list than as a range
+    result &= checkSelection("Run of 2", {1, 2}, " 1 2");
+    result &= checkSelection("Run of 3", {1, 2, 3}, " 1:3");
+    result &= checkSelection("Strided run", {2, 4, 6, 8}, " 2:8:2");
+    result &= checkSelection("Unsorted selection", {9, 3, 6, 1}, " 1 3:9:3");
+    result &= checkSelection("Mixed runs", {11, 1, 2, 4, 6, 8, 10}, " 1 2:10:2 11");
+
+    LammpsCommandsUtils utils;
+
+    result &= checkUpdate("First update", utils, buildCommands(1.0, {4, 5}), {
+        "group forceGRP id 4 5",
+        "fix forceID forceGRP addforce 1 0 0\n",
+        "group moveGRP id 1:3",
+        "fix moveID moveGRP move linear 0 0 0\n",
+        "group " + utils.getNonIntegrationGroup() + " union  moveGRP",
+        "group " + utils.getIntegrationGroup() + " subtract all " + utils.getNonIntegrationGroup(),
+        "fix NVE " + utils.getIntegrationGroup() + " nve"});
+
+    // Nothing changed, Lammps is left untouched
+    result &= checkUpdate("Unchanged update", utils, buildCommands(1.0, {4, 5}), {});
+
+    // Only the force of the motor changed, its group is kept
+    result &= checkUpdate("Parameter update", utils, buildCommands(2.0, {4, 5}), {
+        "unfix forceID",
+        "fix forceID forceGRP addforce 2 0 0\n"});
+
+    // The selection of an integrated motor changed, only its group is rebuilt
+    result &= checkUpdate("Selection update", utils, buildCommands(2.0, {4, 8}), {
+        "unfix forceID",
+        "group forceGRP delete",
+        "group forceGRP id 4 8",
+        "fix forceID forceGRP addforce 2 0 0\n"});
+
+    return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,189 @@
+#include <radahn/core/positionCodec.h>
+#include <radahn/core/deltaCodec.h>
+#include <radahn/core/frameCodec.h>
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <algorithm>
+
+using namespace radahn::core;
+
+bool checkRoundTrip(PositionEncoding encoding, double tolerance)
+{
+    const double boxLo[3] = {-10.0, 0.0, 5.0};
+    const double boxHi[3] = {10.0, 50.0, 6.0};
+    std::vector<atomPositions_t> positions = {
+        -10.0, 0.0, 5.0,
+        10.0, 50.0, 6.0,
+        1.2345678, 24.9876543, 5.5,
+        -3.3, 12.5, 5.123456
+    };
+    uint64_t nbAtoms = positions.size() / 3;
+
+    conduit::Node simData;
+    encodePositions(encoding, positions.data(), nbAtoms, boxLo, boxHi, simData);
+
+    std::vector<atomPositions_t> decoded;
+    if(!decodePositions(simData, decoded) || decoded.size() != positions.size())
+    {
+        spdlog::error("Failed to decode the {} positions.", to_string(encoding));
+        return false;
+    }
+
+    for(size_t i = 0; i < positions.size(); ++i)
+    {
+        if(std::abs(decoded[i] - positions[i]) > tolerance)
+        {
+            spdlog::error("Encoding {}: value {} decoded as {}.", to_string(encoding), positions[i], decoded[i]);
+            return false;
+        }
+    }
+
+    // The same positions written at their ID, the atoms being received in reverse order
+    std::vector<atomIndexes_t> ids = {4, 3, 2, 1};
+    std::vector<atomPositions_t> scattered(positions.size());
+    if(!scatterPositions(simData, ids.data(), nbAtoms, scattered.data()))
+    {
+        spdlog::error("Failed to scatter the {} positions.", to_string(encoding));
+        return false;
+    }
+    for(size_t i = 0; i < positions.size(); ++i)
+    {
+        auto dst = 3*(ids[i/3]-1) + i%3;
+        if(scattered[dst] != decoded[i])
+        {
+            spdlog::error("Encoding {}: value {} scattered as {}.", to_string(encoding), decoded[i], scattered[dst]);
+            return false;
+        }
+    }
+    spdlog::info("Encoding {} passed.", to_string(encoding));
+    return true;
+}
+
+// Send a few frames where the atoms move slightly and migrate between two encoders (ranks)
+bool checkDeltaRoundTrip()
+{
+    DeltaEncoder rank0(3);
+    DeltaEncoder rank1(3);
+    DeltaDecoder decoder;
+
+    std::vector<atomPositions_t> positions = {
+        1.0, 2.0, 3.0,
+        -4.5, 5.25, 6.125,
+        7.0, -8.0, 9.5,
+        10.1, 11.2, 12.3
+    };
+
+    for(uint32_t frame = 0; frame < 8; ++frame)
+    {
+        for(size_t i = 0; i < positions.size(); ++i)
+            positions[i] += 0.001 * static_cast<double>(i + frame);
+
+        // The atom 4 moves from the rank 0 to the rank 1 at the frame 4
+        std::vector<atomIndexes_t> ids0 = {1, 2};
+        std::vector<atomIndexes_t> ids1 = {3};
+        if(frame < 4)
+            ids0.push_back(4);
+        else
+            ids1.push_back(4);
+
+        for(auto [encoder, ids] : {std::make_pair(&rank0, &ids0), std::make_pair(&rank1, &ids1)})
+        {
+            std::vector<atomPositions_t> chunk;
+            for(auto id : *ids)
+                chunk.insert(chunk.end(), positions.begin() + 3*(id-1), positions.begin() + 3*id);
+
+            conduit::Node values;
+            values = chunk;
+            conduit::Node encoded;
+            encoder->encode(ids->data(), ids->size(), values, encoded);
+
+            // A truncated message is rejected without changing the references of the decoder
+            conduit::Node truncated;
+            truncated.set(encoded);
+            std::vector<uint8_t> shortSizes(encoded["sizes"].as_uint8_ptr(), encoded["sizes"].as_uint8_ptr() + 1);
+            truncated["sizes"] = shortSizes;
+            conduit::Node rejected;
+            if(decoder.decode(ids->data(), ids->size(), truncated, rejected))
+            {
+                spdlog::error("Delta frame {}: truncated message accepted.", frame);
+                return false;
+            }
+
+            conduit::Node decoded;
+            if(!decoder.decode(ids->data(), ids->size(), encoded, decoded))
+            {
+                spdlog::error("Failed to decode the delta frame {}.", frame);
+                return false;
+            }
+
+            const double* decodedPositions = decoded.as_float64_ptr();
+            for(size_t i = 0; i < chunk.size(); ++i)
+            {
+                if(decodedPositions[i] != chunk[i])
+                {
+                    spdlog::error("Delta frame {}: value {} decoded as {}.", frame, chunk[i], decodedPositions[i]);
+                    return false;
+                }
+            }
+        }
+    }
+    spdlog::info("Delta compression passed.");
+    return true;
+}
+
+bool checkFrameRoundTrip(PositionEncoding dtype, double tolerance)
+{
+    std::vector<atomPositions_t> positions = {
+        1.0, -2.5, 3.25,
+        1234.5678, 0.000123, -98.7654321
+    };
+
+    std::vector<uint8_t> frame;
+    if(!encodePositionsFrame(42, positions, dtype, frame))
+    {
+        spdlog::error("Failed to encode the {} frame.", to_string(dtype));
+        return false;
+    }
+
+    simIt_t it = 0;
+    std::vector<atomPositions_t> decoded;
+    if(!decodePositionsFrame(frame, it, decoded) || it != 42 || decoded.size() != positions.size())
+    {
+        spdlog::error("Failed to decode the {} frame.", to_string(dtype));
+        return false;
+    }
+
+    for(size_t i = 0; i < positions.size(); ++i)
+    {
+        if(std::abs(decoded[i] - positions[i]) > tolerance * std::max(1.0, std::abs(positions[i])))
+        {
+            spdlog::error("Frame {}: value {} decoded as {}.", to_string(dtype), positions[i], decoded[i]);
+            return false;
+        }
+    }
+
+    // A truncated frame must be rejected
+    frame.pop_back();
+    if(decodePositionsFrame(frame, it, decoded))
+    {
+        spdlog::error("Frame {}: truncated frame accepted.", to_string(dtype));
+        return false;
+    }
+    spdlog::info("Frame {} passed.", to_string(dtype));
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+    result &= checkRoundTrip(PositionEncoding::FLOAT64, 0.0);
+    result &= checkRoundTrip(PositionEncoding::FLOAT32, 1e-5);
+    // Half of the largest quantization step (50 / 65535)
+    result &= checkRoundTrip(PositionEncoding::FIXED16, 0.5 * 50.0 / 65535.0 + 1e-12);
+    result &= checkDeltaRoundTrip();
+    result &= checkFrameRoundTrip(PositionEncoding::FLOAT64, 0.0);
+    result &= checkFrameRoundTrip(PositionEncoding::FLOAT32, 1e-6);
+
+    return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,93 @@
+#include <radahn/core/positionCodec.h>
+#include <radahn/motor/motorEngine.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+
+using namespace radahn::core;
+using namespace radahn::motor;
+
+// Scatter the chunks with the engine, split between the threads of its pool, and compare the frame
+// with the chunks scattered one after the other by this thread
+bool checkScatter(const std::string& name, MotorEngine& engine, simIt_t it, const std::vector<conduit::Node>& chunks, std::vector<atomPositions_t>& expected)
+{
+    std::vector<const conduit::Node*> frames;
+    for(auto & chunk : chunks)
+        frames.push_back(&chunk);
+    if(!engine.updateEngineState(it, frames))
+    {
+        spdlog::error("{}: unable to scatter the frame.", name);
+        return false;
+    }
+
+    for(auto & chunk : chunks)
+    {
+        auto & idsNode = chunk["atomIDs"];
+        auto nbAtoms = static_cast<uint64_t>(idsNode.dtype().number_of_elements());
+        if(!scatterPositions(chunk, idsNode.as_uint32_ptr(), nbAtoms, expected.data()))
+        {
+            spdlog::error("{}: unable to scatter the reference frame.", name);
+            return false;
+        }
+    }
+
+    auto & positions = engine.getCurrentPositions();
+    if(positions.size() != expected.size())
+    {
+        spdlog::error("{}: the engine frame has {} coordinates instead of {}.", name, positions.size(), expected.size());
+        return false;
+    }
+    auto mismatch = std::mismatch(positions.begin(), positions.end(), expected.begin());
+    if(mismatch.first != positions.end())
+    {
+        auto index = static_cast<size_t>(mismatch.first - positions.begin());
+        spdlog::error("{}: coordinate {} of the atom {} is {} instead of {}.", name, index % 3, index / 3 + 1, *mismatch.first, *mismatch.second);
+        return false;
+    }
+    spdlog::info("{} passed.", name);
+    return true;
+}
+
+int main()
+{
+    // Chunks above 1 << 16 atoms, the engine splits them between the threads of its pool
+    constexpr size_t nbChunks = 3;
+    const uint64_t nbAtomsPerChunk = (1 << 16) + 7;
+    const uint64_t nbAtoms = nbChunks * nbAtomsPerChunk;
+    const double boxLo[3] = {-50.0, 0.0, 0.0};
+    const double boxHi[3] = {50.0, 100.0, 100.0};
+    const PositionEncoding encodings[nbChunks] = {PositionEncoding::FLOAT64, PositionEncoding::FLOAT32, PositionEncoding::FIXED16};
+
+    // Each process owns a random set of atoms
+    std::vector<atomIndexes_t> ids(nbAtoms);
+    std::iota(ids.begin(), ids.end(), 1);
+    std::mt19937 rng(42);
+    std::shuffle(ids.begin(), ids.end(), rng);
+
+    std::uniform_real_distribution<double> distribution(-50.0, 100.0);
+    auto buildChunks = [&](size_t nbSent)
+    {
+        std::vector<conduit::Node> chunks(nbSent);
+        std::vector<atomPositions_t> positions(3*nbAtomsPerChunk);
+        for(size_t c = 0; c < nbSent; ++c)
+        {
+            for(auto & position : positions)
+                position = distribution(rng);
+            encodePositions(encodings[c], positions.data(), nbAtomsPerChunk, boxLo, boxHi, chunks[c]);
+            chunks[c]["atomIDs"].set(ids.data() + c * nbAtomsPerChunk, static_cast<conduit::index_t>(nbAtomsPerChunk));
+        }
+        return chunks;
+    };
+
+    MotorEngine engine;
+    std::vector<atomPositions_t> expected(3*nbAtoms);
+    bool result = true;
+    result &= checkScatter("Parallel scatter", engine, 0, buildChunks(nbChunks), expected);
+    // The atoms of the chunk which is not received keep their previous position
+    result &= checkScatter("Parallel scatter of a partial frame", engine, 1, buildChunks(nbChunks - 1), expected);
+
+    return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,16 +1,126 @@
+import argparse
+import json
+import struct
+
+import numpy as np
 import zmq
 
+# Binary frame published on the atoms gate with --atomsformat float64/float32, see include/radahn/core/frameCodec.h
+FRAME_MAGIC = b"RDHNFRME"
+FRAME_HEADER = struct.Struct("<8sHBBIQQ")
+FRAME_SCHEMA_VERSION = 1
+FRAME_KIND_POSITIONS = 1
+FRAME_DTYPES = {0: np.dtype("<f8"), 1: np.dtype("<f4")}
+
+def extractConduitLeaf(parts:list, name:str) -> memoryview:
+    """Return the bytes of the uint8 leaf `name` of a message sent with the conduit format:
+    the JSON schema of the node followed by its compact data."""
+    if len(parts) < 2:
+        raise ValueError("The message is not a conduit message (schema and data).")
+    schema = json.loads(parts[0])
+    leaf = schema.get(name) if isinstance(schema, dict) else None
+    if not isinstance(leaf, dict) or leaf.get("dtype") != "uint8":
+        raise ValueError(f"The message has no uint8 field {name}.")
+
+    offset = int(leaf.get("offset", 0))
+    count = int(leaf["number_of_elements"])
+    if int(leaf.get("stride", 1)) != 1 or offset + count > len(parts[-1]):
+        raise ValueError(f"Invalid layout of the field {name} in the message.")
+    return memoryview(parts[-1])[offset:offset + count]
+
+def decodePositionsFrame(frame) -> tuple:
+    """Return (simIt, positions) where positions is a (nbAtoms, 3) float64 array."""
+    if len(frame) < FRAME_HEADER.size:
+        raise ValueError("The message is not a Radahn frame.")
+    magic, version, kind, dtype, _, simIt, nbAtoms = FRAME_HEADER.unpack_from(frame, 0)
+    if magic != FRAME_MAGIC:
+        raise ValueError("The message is not a Radahn frame.")
+    if version != FRAME_SCHEMA_VERSION:
+        raise ValueError(f"Unsupported frame schema version {version}.")
+    if kind != FRAME_KIND_POSITIONS:
+        raise ValueError(f"Unsupported frame kind {kind}.")
+    if dtype not in FRAME_DTYPES:
+        raise ValueError(f"Unsupported frame dtype {dtype}.")
+    if len(frame) < FRAME_HEADER.size + 3 * nbAtoms * FRAME_DTYPES[dtype].itemsize:
+        raise ValueError(f"Truncated frame of {nbAtoms} atoms.")
+
+    positions = np.frombuffer(frame, dtype=FRAME_DTYPES[dtype], count=3 * nbAtoms, offset=FRAME_HEADER.size)
+    return simIt, positions.astype(np.float64).reshape((nbAtoms, 3))
+
+class PackedKVSReader:
+    """Rebuild the KVS records published by the engine with --packedkvs, see include/radahn/motor/packedKVS.h"""
+    def __init__(self):
+        self.version = None
+        self.fields = []
+        self.dtypes = []
+
+    def decode(self, msg:dict):
+        """Return the KVS as {group: {field: value}}, the message unchanged if it is not packed,
+        or None for a schema message or values received before their schema."""
+        kind = msg.get("kind")
+        if kind is None:
+            return msg
+        if kind == "schema":
+            self.version = msg["version"]
+            self.fields = msg["fields"]
+            # The values are packed as float64, the integers are restored from the type of their KVS leaf
+            self.dtypes = msg.get("sourceDtypes", msg["dtypes"])
+            return None
+        if kind != "values" or msg["version"] != self.version:
+            return None
+
+        # A single value is not written as an array in JSON
+        values = msg["values"] if isinstance(msg["values"], list) else [msg["values"]]
+        kvs = {}
+        for path, dtype, value in zip(self.fields, self.dtypes, values):
+            group, field = path.split("/", 1)
+            kvs.setdefault(group, {})[field] = value if dtype.startswith("float") else int(value)
+        # Leaves which are not numeric scalars, copied as they are
+        for group, fields in msg.get("others", {}).items():
+            if isinstance(fields, dict):
+                kvs.setdefault(group, {}).update(fields)
+            else:
+                kvs[group] = fields
+        return kvs
+
+def listenKVS(sock):
+    reader = PackedKVSReader()
+    while(True):
+        print("Waiting for message...")
+        msg = reader.decode(sock.recv_json())
+        if msg is not None:
+            print(msg)
+
+def listenAtoms(sock):
+    while(True):
+        print("Waiting for message...")
+        parts = sock.recv_multipart()
+        if len(parts) == 1:
+            # JSON message, default format of the atoms gate
+            print(parts[0].decode("utf-8"))
+            continue
+        simIt, positions = decodePositionsFrame(extractConduitLeaf(parts, "frame"))
+        print(f"Step {simIt}: {positions.shape[0]} atoms, first atom {positions[0] if len(positions) > 0 else None}")
+
 def main():
-    addr = "tcp://localhost:50000"
+    parser = argparse.ArgumentParser(description="Print the messages published by the Radahn engine.")
+    parser.add_argument("--atoms",
+                        help="Listen to the atoms gate (port 50001) instead of the KVS gate (port 50000).",
+                        dest="atoms",
+                        action='store_true',
+                        required=False)
+    args = parser.parse_args()
+
+    addr = "tcp://localhost:50001" if args.atoms else "tcp://localhost:50000"
     context = zmq.Context()
     sock = context.socket(zmq.SUB)
     sock.connect(addr)
     sock.setsockopt(zmq.SUBSCRIBE, b'')
 
-    while(True):
-        print("Waiting for message...")
-        msg = sock.recv_json()
-        print(msg)
+    if args.atoms:
+        listenAtoms(sock)
+    else:
+        listenKVS(sock)
 
 if __name__ == "__main__":
-    main()
\ No newline at end of file
+    main()
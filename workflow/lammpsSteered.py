@@ -46,6 +46,14 @@ def main():
 		                dest = "frequpdate",
 		                type=int)
     parser.set_defaults(frequpdate=100)
+    parser.add_argument("--minfrequpdate",
+		                help = "Minimum number of steps between two outputs when the motor engine adapts the interval length. Default to frequpdate.",
+		                dest = "minfrequpdate",
+		                type=int)
+    parser.add_argument("--maxfrequpdate",
+		                help = "Maximum number of steps between two outputs when the motor engine adapts the interval length. Default to frequpdate.",
+		                dest = "maxfrequpdate",
+		                type=int)
     parser.add_argument("--ncores",
 		                help = "Number of physical cores assigned to Lammps.",
 		                dest = "ncores",
@@ -81,9 +89,94 @@ def main():
                         dest="forcemaxsteps",
                         action='store_true',
                         required=False)
+    parser.add_argument("--zerocopy",
+                        help="Send the atom data directly from the Lammps memory without intermediate copies.",
+                        dest="zerocopy",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--gatherframe",
+                        help="Gather the atoms on the first Lammps rank ordered by ID so the engine receives a single sorted frame.",
+                        dest="gatherframe",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--fixradahn",
+                        help="Apply the motors inside the Lammps timestep loop with the fix radahn instead of Lammps commands.",
+                        dest="fixradahn",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--asyncsend",
+                        help="Push the frames from a separate thread while Lammps computes the next interval. Requires an MPI library with MPI_THREAD_MULTIPLE and a command lag of at least 1.",
+                        dest="asyncsend",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--persistentrun",
+                        help="Continue the previous Lammps run without its setup when the motors didn't change the fixes since the previous interval.",
+                        dest="persistentrun",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--shm",
+                        help="Send the frames from Lammps to the engine through shared memory when they run on the same node.",
+                        dest="shm",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--roi",
+                        help="Let the engine request only the atoms used by the motors between two full frames. Requires \"roi\": true in the \"export\" section of the Lammps config.",
+                        dest="roi",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--reductions",
+                        help="Let Lammps compute the selection centers needed by the motors instead of sending the atoms between two full frames.",
+                        dest="reductions",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--checkpointevery",
+                        help="Checkpoint the simulation and the motor engine every N NVE intervals.",
+                        dest="checkpointevery",
+                        type=int,
+                        required=False)
+    parser.add_argument("--resume",
+                        help="Restart the session from the last checkpoint.",
+                        dest="resume",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--atomsformat",
+                        help="Format of the positions published on the atoms gate: json, or float64/float32 for a binary frame decoded by utils/listenRadahn.py.",
+                        dest="atomsformat",
+                        choices=["json", "float64", "float32"],
+                        default="json",
+                        required=False)
+    parser.add_argument("--packedkvs",
+                        help="Publish the KVS as a schema message followed by frames of values only, decoded by the frontend and utils/listenRadahn.py.",
+                        dest="packedkvs",
+                        action='store_true',
+                        required=False)
+    parser.add_argument("--vizfps",
+                        help="Maximum number of frames per second published by the engine to the frontend. Default to every frame.",
+                        dest="vizfps",
+                        type=float,
+                        required=False)
+    parser.add_argument("--commandlag",
+                        help="Number of intervals Lammps may run ahead of the motor engine. With a lag of N, the interval k+1 runs with the commands computed from the frame k-N. Default to 0 (Lammps waits for the commands of the last frame).",
+                        dest="commandlag",
+                        type=int,
+                        default=0,
+                        required=False)
+    parser.add_argument("--replicas",
+                        help="Number of replicas of the simulation run as Lammps partitions and steered by the same engine. The Lammps cores are split evenly between the replicas.",
+                        dest="replicas",
+                        type=int,
+                        default=1,
+                        required=False)
     
     args = parser.parse_args()
 
+    # The shared memory ring of the driver has 8 slots (shmRingSlots in src/lammps/lammpsDriver.cpp)
+    if args.shm and args.commandlag > 6:
+        raise ValueError(f"The command lag can't exceed 6 intervals with --shm, got {args.commandlag}.")
+    # The driver waits for the commands of the next interval before pushing its frame, they can't depend on it
+    if args.asyncsend and args.commandlag < 1:
+        raise ValueError("The asynchronous sender requires a command lag of at least 1 interval.")
+
     # Print the command line for logging purposes
     print("Commandline:", end=" ")
     for i in range(1, len(sys.argv)):
@@ -152,8 +245,30 @@ def main():
     lammpsCmd += f" --initlmp {fileLmpPath.name}"
     lammpsCmd += f" --maxnvesteps {args.nvesteps}"
     lammpsCmd += f" --intervalsteps {args.frequpdate}"
+    if args.minfrequpdate is not None:
+        lammpsCmd += f" --minintervalsteps {args.minfrequpdate}"
+    if args.maxfrequpdate is not None:
+        lammpsCmd += f" --maxintervalsteps {args.maxfrequpdate}"
     if args.lmpconfig is not None:
         lammpsCmd += f" --lmpconfig {fileLmpConfig.name}"
+    if args.zerocopy:
+        lammpsCmd += " --zerocopy"
+    if args.gatherframe:
+        lammpsCmd += " --gatherframe"
+    if args.fixradahn:
+        lammpsCmd += " --fixradahn"
+    if args.asyncsend:
+        lammpsCmd += " --asyncsend"
+    if args.persistentrun:
+        lammpsCmd += " --persistentrun"
+    if args.shm:
+        lammpsCmd += " --shm"
+    if args.checkpointevery is not None:
+        lammpsCmd += f" --checkpointevery {args.checkpointevery}"
+    if args.resume:
+        lammpsCmd += " --resume"
+    if args.replicas > 1:
+        lammpsCmd += f" --replicas {args.replicas}"
 
 
     if args.ncores + 1 > nCoresHost:
@@ -161,6 +276,8 @@ def main():
     splitResources = cluster.splitNodesByCoreRange([args.ncores, 1])
     lammpsResources = splitResources[0]
     print(f"Number of cores assigned to Lammps: {args.ncores}")
+    if args.replicas < 1 or args.ncores % args.replicas != 0:
+        raise ValueError(f"The {args.ncores} Lammps cores cannot be split evenly between {args.replicas} replicas.")
 
     lammps = MPITask(name="lammps", cmdline=lammpsCmd, placementPolicy=MPIPlacementPolicy.ONETASKPERCORE, resources=lammpsResources)
     lammps.addInputPort("in")
@@ -174,6 +291,20 @@ def main():
         engineCmd += f" --motors {fileMotorConfig.name}"
     if forceMaxSteps:
         engineCmd += f" --forcemaxsteps"
+    if args.roi:
+        engineCmd += " --roi"
+    if args.reductions:
+        engineCmd += " --reductions"
+    if args.resume:
+        engineCmd += " --resume"
+    if args.replicas > 1:
+        engineCmd += f" --replicas {args.replicas}"
+    if args.atomsformat != "json":
+        engineCmd += f" --atomsformat {args.atomsformat}"
+    if args.packedkvs:
+        engineCmd += " --packedkvs"
+    if args.vizfps is not None:
+        engineCmd += f" --vizfps {args.vizfps}"
     engineResources = splitResources[1]
     engine = MPITask(name="engine", cmdline=engineCmd, placementPolicy=MPIPlacementPolicy.ONETASKPERCORE, resources=engineResources)
     engine.addInputPort("atoms")
@@ -190,12 +321,17 @@ def main():
     engineToSim = MPIPairedCommunicator(id="engineToSim", protocol=MPICommunicatorProtocol.PARTIAL_BCAST_GATHER)
     engineToSim.connectToInputPort(lammps.getInputPort("in"))
     engineToSim.connectToOutputPort(engine.getOutputPort("motorscmd"))
-    engineToSim.setNbToken(1)
+    # Each token lets Lammps run one interval without waiting for the commands of its last frame
+    if args.commandlag < 0:
+        raise ValueError(f"The command lag must be positive, got {args.commandlag}.")
+    engineToSim.setNbToken(1 + args.commandlag)
 
     # Open gates
     outKVSEngine = ZMQGateCommunicator(name="kvsGate", side=CommunicatorGateSideFlag.OPEN_SENDER, protocol=ZMQCommunicatorProtocol.PUB_SUB, bindingSide=ZMQBindingSide.ZMQ_BIND_SENDER, format=CommunicatorMessageFormat.MSG_FORMAT_JSON, port=50000)
     outKVSEngine.connectToOutputPort(engine.getOutputPort("kvs"))
-    outAtomsEngine = ZMQGateCommunicator(name="atomsGate", side=CommunicatorGateSideFlag.OPEN_SENDER, protocol=ZMQCommunicatorProtocol.PUB_SUB, bindingSide=ZMQBindingSide.ZMQ_BIND_SENDER, format=CommunicatorMessageFormat.MSG_FORMAT_JSON, port=50001)
+    # The binary frames are sent as is, without the JSON conversion of the positions
+    atomsGateFormat = CommunicatorMessageFormat.MSG_FORMAT_JSON if args.atomsformat == "json" else CommunicatorMessageFormat.MSG_FORMAT_CONDUIT
+    outAtomsEngine = ZMQGateCommunicator(name="atomsGate", side=CommunicatorGateSideFlag.OPEN_SENDER, protocol=ZMQCommunicatorProtocol.PUB_SUB, bindingSide=ZMQBindingSide.ZMQ_BIND_SENDER, format=atomsGateFormat, port=50001)
     outAtomsEngine.connectToOutputPort(engine.getOutputPort("atoms"))
     inCmdEngine = ZMQGateCommunicator(name="cmdGate", side=CommunicatorGateSideFlag.OPEN_RECEIVER, protocol=ZMQCommunicatorProtocol.PUSH_PULL, bindingSide=ZMQBindingSide.ZMQ_BIND_RECEIVER, format=CommunicatorMessageFormat.MSG_FORMAT_JSON, port=50002, nonblocking=True)
     inCmdEngine.connectToInputPort(engine.getInputPort("usercmd"))